@@ -0,0 +1,77 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Input;
+
+// Maps gameplay actions to keys, chords (keys held together) and mouse buttons (VK_LBUTTON...).
+// Actions are registered once by name and then only used through their integer id.
+// Bindings are compiled into a flat table which Evaluate walks once per frame, after
+// Input::Update, to fill the action bitsets. Queries are a bit test.
+class ActionMap
+{
+public:
+	static const int MAX_ACTIONS = 256;
+	static const int MAX_CHORD_KEYS = 4;
+
+	ActionMap();
+	~ActionMap() {};
+
+	// INIT
+	void Init();
+
+	// ACTIONS
+	// Returns the id of the action, the existing one if the name is already registered,
+	// -1 when MAX_ACTIONS is reached
+	int RegisterAction(const std::string& name);
+	// -1 if unknown. Look ids up once, not every frame. Queries return false for unknown ids.
+	int FindAction(const std::string& name) const;
+	const std::string& GetActionName(int action) const { return m_actionNames[action]; }
+
+	// BINDINGS
+	// Rebinding marks the table dirty, it is compiled again by the next Evaluate
+	bool Bind(int action, int key);
+	// Active while every key of the chord is down, up to MAX_CHORD_KEYS keys in any order
+	bool BindChord(int action, std::initializer_list<int> keys);
+	void ClearBindings(int action);
+	void Compile();
+	// Bindings in the compiled table, duplicates removed
+	int GetCompiledCount() const { return (int)m_table.size(); }
+
+	// UPDATE
+	void Evaluate(const Input& input);
+
+	// QUERIES
+	bool IsActive(int action) const { return IsValid(action) && m_active[action]; }
+	// Became active / inactive on the last Evaluate
+	bool WasActivated(int action) const { return IsValid(action) && m_activated[action]; }
+	bool WasDeactivated(int action) const { return IsValid(action) && m_deactivated[action]; }
+
+private:
+	static bool IsValid(int action) { return action >= 0 && action < MAX_ACTIONS; }
+
+private:
+	struct Binding
+	{
+		uint8_t Keys[MAX_CHORD_KEYS];
+		uint8_t KeyCount;
+		uint8_t Action;
+	};
+
+private:
+	std::vector<std::string> m_actionNames;
+	std::unordered_map<std::string, int> m_actionIds;
+
+	// Bindings as given, and the compiled table walked by Evaluate
+	std::vector<Binding> m_bindings;
+	std::vector<Binding> m_table;
+	bool m_isDirty = false;
+
+	std::bitset<MAX_ACTIONS> m_active;
+	std::bitset<MAX_ACTIONS> m_activated;
+	std::bitset<MAX_ACTIONS> m_deactivated;
+};
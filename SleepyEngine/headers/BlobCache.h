@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Directory of binary blobs, one file per 64 bit key. Each file starts with a header (magic,
+// version, key, size and hash of the content): truncated, corrupted or foreign files are misses.
+// Load and Store can be called from several threads and processes at once.
+class BlobCache
+{
+public:
+	BlobCache();
+	~BlobCache() {};
+
+	// INIT
+	// directory is created if needed, empty disables the cache. extension ends the file names (".cso").
+	bool Init(const std::string& directory, const std::string& extension);
+
+	bool Load(uint64_t key, std::vector<uint8_t>& blob) const;
+	// Written next to its final path then renamed, readers never see a partial file
+	bool Store(uint64_t key, const void* pData, size_t size) const;
+
+	// SETTER / GETTER
+	bool IsEnabled() const { return !m_directory.empty(); }
+
+private:
+	std::string GetPath(uint64_t key) const;
+
+private:
+	std::string m_directory;
+	std::string m_extension;
+};
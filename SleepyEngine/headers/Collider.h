@@ -1,6 +1,10 @@
 #pragma once
 #include "Component.h"
 
+class PhysicsWorld;
+
+// Axis aligned box collider, also holding the body state used by PhysicsWorld.
+// A collider with an inverse mass of 0 is static: it never moves and never sleeps.
 class Collider : public Component
 {
 public:
@@ -10,6 +14,81 @@ public:
 	// INIT
 	void Init() override;
 
+	// SLEEP
+	// Explicit wake event, the whole island of the collider is woken on the next step
+	void WakeUp();
+	bool IsSleeping() const { return m_isSleeping; }
+	bool IsStatic() const { return m_inverseMass == 0.0f; }
+
+	// FORCES
+	void ApplyImpulse(const XMFLOAT3& impulse);
+
+	// SETTER / GETTER
+	// Teleports: the previous center moves too, so nothing is interpolated across the jump
+	void SetCenter(const XMFLOAT3& center) { m_center = center; m_previousCenter = center; OnTransformChanged(); }
+	XMFLOAT3 GetCenter() const { return m_center; }
+	// Center before the last step
+	XMFLOAT3 GetPreviousCenter() const { return m_previousCenter; }
+
+	void SetHalfExtents(const XMFLOAT3& halfExtents) { m_halfExtents = halfExtents; OnTransformChanged(); }
+	XMFLOAT3 GetHalfExtents() const { return m_halfExtents; }
+
+	void SetVelocity(const XMFLOAT3& velocity) { m_velocity = velocity; WakeUp(); }
+	XMFLOAT3 GetVelocity() const { return m_velocity; }
+
+	// mass <= 0 makes the collider static
+	void SetMass(float mass);
+	float GetInverseMass() const { return m_inverseMass; }
+
+	void SetRestitution(float restitution) { m_restitution = restitution; }
+	float GetRestitution() const { return m_restitution; }
+
+	// CONTINUOUS COLLISION
+	// Fast colliders are swept through their motion of the step instead of being
+	// tested at their end position only, so they cannot tunnel through thin colliders.
+	// More expensive, only for projectiles and the like.
+	void SetContinuous(bool isContinuous) { m_isContinuous = isContinuous; }
+	bool IsContinuous() const { return m_isContinuous; }
+
+	// COLLISION FILTERING
+	// Two colliders only collide when each one's layer is in the other's mask.
+	// Rejected pairs never reach the pair cache.
+	void SetCollisionLayer(uint32_t layer);
+	uint32_t GetCollisionLayer() const { return m_collisionLayer; }
+
+	void SetCollisionMask(uint32_t mask);
+	uint32_t GetCollisionMask() const { return m_collisionMask; }
+
+	bool CanCollideWith(const Collider& other) const
+	{
+		return (m_collisionLayer & other.m_collisionMask) != 0 && (other.m_collisionLayer & m_collisionMask) != 0;
+	}
+
 private:
-};
+	friend class PhysicsWorld;
+
+	// Wakes the collider, or for a static one the sleeping bodies it touched or now touches
+	void OnTransformChanged();
+
+	XMFLOAT3 m_center = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 m_previousCenter = { 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 m_halfExtents = { 0.5f, 0.5f, 0.5f };
+	XMFLOAT3 m_velocity = { 0.0f, 0.0f, 0.0f };
 
+	float m_inverseMass = 1.0f;
+	float m_restitution = 0.2f;
+	bool m_isContinuous = false;
+
+	uint32_t m_collisionLayer = 1;
+	uint32_t m_collisionMask = 0xFFFFFFFF;
+
+	// SLEEP STATE (written by PhysicsWorld)
+	// Time spent under the sleep velocity threshold
+	float m_sleepTimer = 0.0f;
+	bool m_isSleeping = false;
+	int m_islandId = -1;
+
+	// Owning world and index in its collider list, set by PhysicsWorld::AddCollider
+	PhysicsWorld* m_pWorld = nullptr;
+	int m_worldIndex = -1;
+};
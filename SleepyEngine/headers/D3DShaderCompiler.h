@@ -0,0 +1,16 @@
+#pragma once
+#include "ShaderCompiler.h"
+
+// D3DCompileFromFile (d3dcompiler_47), includes resolved relative to the including file.
+// Debug builds compile with D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION.
+class D3DShaderCompiler : public ShaderCompiler
+{
+public:
+	D3DShaderCompiler() {};
+	~D3DShaderCompiler() {};
+
+	bool Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) override;
+	std::string GetVersion() const override;
+
+	static unsigned int GetCompileFlags();
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "LinearRing.h"
+
+// Descriptor churn since Init
+struct DescriptorStats
+{
+	uint32_t PersistentCapacity = 0;
+	uint32_t PersistentInUse = 0;
+	uint32_t PersistentPeak = 0;
+	uint64_t PersistentAllocations = 0;
+	uint64_t PersistentFrees = 0;
+	uint32_t TransientCapacity = 0;
+	// Not retired yet, wasted slots at the wrap included
+	uint32_t TransientInUse = 0;
+	uint64_t TransientAllocations = 0;
+	// Persistent and transient allocations which found no room
+	uint64_t FailedAllocations = 0;
+	// Persistent frees of a descriptor out of range or already free, ignored
+	uint64_t InvalidFrees = 0;
+	// Staging to shader visible copies, and the CopyDescriptors calls they were batched in
+	uint64_t CopiedDescriptors = 0;
+	uint64_t CopyBatches = 0;
+};
+
+// Indices of the two kinds of descriptors of a heap type, the descriptors themselves are
+// elsewhere (RhiD3D12DescriptorHeap):
+// - persistent ones live as long as their resource and come from a free list,
+// - transient ones are contiguous ranges of the frame (descriptor tables), from a LinearRing
+//   retired by fence value.
+// The two index spaces are separate. Thread safe.
+class DescriptorAllocator
+{
+public:
+	static const uint32_t INVALID_DESCRIPTOR = 0xFFFFFFFF;
+
+	DescriptorAllocator();
+	~DescriptorAllocator() {};
+
+	// INIT
+	void Init(uint32_t persistentCount, uint32_t transientCount);
+
+	// PERSISTENT
+	// INVALID_DESCRIPTOR when every descriptor is in use
+	uint32_t AllocatePersistent();
+	// INVALID_DESCRIPTOR is ignored, double frees too but they are counted in DescriptorStats::InvalidFrees
+	void FreePersistent(uint32_t descriptor);
+
+	// TRANSIENT
+	// First of count contiguous descriptors, valid until the frame is retired
+	uint32_t AllocateTransient(uint32_t count);
+	// See LinearRing
+	void Retire(uint64_t completedFenceValue) { m_transientRing.Retire(completedFenceValue); }
+	void EndFrame(uint64_t fenceValue) { m_transientRing.EndFrame(fenceValue); }
+
+	// SETTER / GETTER
+	DescriptorStats GetStats() const;
+	// Counted here so GetStats has everything
+	void AddCopies(uint64_t descriptorCount);
+
+private:
+	mutable std::mutex m_persistentMutex;
+	// Stack of free persistent descriptors
+	std::vector<uint32_t> m_freePersistent;
+	// 1 while the descriptor is in m_freePersistent
+	std::vector<uint8_t> m_isPersistentFree;
+	uint32_t m_persistentCapacity = 0;
+	uint32_t m_persistentPeak = 0;
+	uint64_t m_persistentAllocations = 0;
+	uint64_t m_persistentFrees = 0;
+	uint64_t m_persistentFailures = 0;
+	uint64_t m_invalidFrees = 0;
+
+	LinearRing m_transientRing;
+	std::atomic<uint64_t> m_transientAllocations;
+	std::atomic<uint64_t> m_copiedDescriptors;
+	std::atomic<uint64_t> m_copyBatches;
+};
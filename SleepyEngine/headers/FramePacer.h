@@ -0,0 +1,43 @@
+#pragma once
+
+// Limits the frame rate of the Run loop without pinning a core.
+// Most of the remaining frame budget is slept, only the last m_spinTicks are spin-waited
+// because Sleep() wakes up late by up to a scheduler quantum.
+// When the window is minimized or unfocused, the loop blocks on the message queue instead.
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	// INIT
+	// targetFrameRate <= 0 disables the limiter
+	bool Init(double targetFrameRate);
+
+	// Called at the end of a frame, returns when the next one should start
+	void WaitForNextFrame();
+
+	// IDLE
+	// Returns false right away when the window is in the foreground.
+	// Otherwise blocks until a message arrives (minimized, unfocused) or until the next
+	// idle frame is due (unfocused only). Returns true if a message arrived and must be
+	// processed, false when a frame must be drawn.
+	bool WaitWhileIdle(HWND window);
+
+	// SETTER / GETTER
+	void SetTargetFrameRate(double targetFrameRate);
+	void SetIdleFrameRate(double idleFrameRate) { m_idleFrameRate = idleFrameRate; }
+	void SetSpinTime(double seconds);
+
+private:
+	int64_t m_frameTicks = 0;
+	int64_t m_nextFrameTicks = 0;
+	int64_t m_spinTicks = 0;
+
+	double m_idleFrameRate = 10.0;
+	bool m_isIdle = false;
+	int64_t m_nextIdleFrameTicks = 0;
+
+	// timeBeginPeriod(1) was called and must be balanced
+	bool m_hasTimerPeriod = false;
+};
@@ -0,0 +1,88 @@
+#pragma once
+// Only std on purpose: the ring and the mock timeline are used without D3D12
+#include <cstdint>
+
+// Monotonic fence the ring waits on: a D3D12 queue and fence in the engine,
+// MockFenceTimeline for headless runs and platforms without D3D12.
+class FenceTimeline
+{
+public:
+	virtual ~FenceTimeline() {};
+
+	// Queues a signal after the work submitted so far and returns its value
+	virtual uint64_t Signal() = 0;
+	virtual uint64_t GetCompletedValue() = 0;
+	// Blocks until the completed value reaches value
+	virtual void WaitFor(uint64_t value) = 0;
+};
+
+// Fake GPU which completes its work m_latency signals after it was submitted.
+// WaitFor completes everything up to the value right away, like a GPU the CPU waited for.
+class MockFenceTimeline : public FenceTimeline
+{
+public:
+	MockFenceTimeline(int latency = 0) : m_latency(latency) {}
+	~MockFenceTimeline() {};
+
+	uint64_t Signal() override;
+	uint64_t GetCompletedValue() override { return m_completedValue; }
+	void WaitFor(uint64_t value) override;
+
+	// Completes the work up to value, as if the GPU got there
+	void Complete(uint64_t value);
+
+	// SETTER / GETTER
+	void SetLatency(int latency) { m_latency = latency; }
+	uint64_t GetLastSignaledValue() const { return m_lastSignaledValue; }
+	int GetWaitCount() const { return m_waitCount; }
+
+private:
+	int m_latency;
+	uint64_t m_lastSignaledValue = 0;
+	uint64_t m_completedValue = 0;
+	int m_waitCount = 0;
+};
+
+// Ring of frames in flight. Each frame slot owns resources the GPU reads while the frame
+// executes (command allocator, upload memory...) and remembers the fence value signaled
+// after its submission. Beginning a frame only blocks when its slot is still in use by the
+// GPU, so the CPU can run up to frameCount frames ahead.
+class FrameRing
+{
+public:
+	static const int MAX_FRAME_COUNT = 3;
+
+	FrameRing();
+	~FrameRing() {};
+
+	// INIT
+	// frameCount is clamped to [1, MAX_FRAME_COUNT]
+	bool Init(FenceTimeline* pTimeline, int frameCount);
+
+	// FRAME
+	// Waits until the next slot is no longer used by the GPU and returns its index.
+	// Its resources can be reset once this returns.
+	int BeginFrame();
+	// Call after the frame was submitted, signals the fence of its slot
+	void EndFrame();
+	// Waits for every frame in flight
+	void WaitIdle();
+
+	// SETTER / GETTER
+	int GetFrameCount() const { return m_frameCount; }
+	int GetFrameIndex() const { return m_frameIndex; }
+	uint64_t GetFenceValue(int frameIndex) const { return m_fenceValues[frameIndex]; }
+	uint64_t GetSubmittedCount() const { return m_submittedCount; }
+	// Frames which had to wait for the GPU before starting
+	uint64_t GetWaitCount() const { return m_waitCount; }
+
+private:
+	FenceTimeline* m_pTimeline = nullptr;
+	int m_frameCount = 0;
+	int m_frameIndex = -1;
+	// 0: the slot was never submitted
+	uint64_t m_fenceValues[MAX_FRAME_COUNT];
+
+	uint64_t m_submittedCount = 0;
+	uint64_t m_waitCount = 0;
+};
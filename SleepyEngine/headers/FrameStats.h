@@ -0,0 +1,65 @@
+#pragma once
+
+// Frame time statistics: percentiles over a rolling window of the last frames,
+// and a log bucketed histogram plus an over budget count over the whole run.
+// Dumped to CSV at shutdown so QA can compare runs.
+class FrameStats
+{
+public:
+	static const int WINDOW_SIZE = 1024;
+
+	// 4 buckets per octave starting at 0.25 ms, the last one also holds everything slower
+	static const int BUCKETS_PER_OCTAVE = 4;
+	static const int BUCKET_COUNT = 48;
+
+	struct Summary
+	{
+		int FrameCount;
+		// In milliseconds
+		double Mean;
+		double P50;
+		double P95;
+		double P99;
+		double Max;
+		int OverBudgetCount;
+	};
+
+	FrameStats();
+	~FrameStats() {};
+
+	// INIT
+	bool Init(double budgetSeconds);
+
+	// Called once per frame with the frame duration
+	void AddFrame(double seconds);
+
+	// Over the rolling window, sorts a copy of the window so do not call it every frame
+	Summary GetSummary();
+
+	// EXPORT
+	bool ExportCsv(const std::string& path);
+
+	// SETTER / GETTER
+	void SetBudget(double seconds) { m_budgetMs = (float)(seconds * 1000.0); }
+	double GetBudget() const { return m_budgetMs * 0.001; }
+	uint64_t GetTotalFrameCount() const { return m_totalFrameCount; }
+	uint64_t GetTotalOverBudgetCount() const { return m_totalOverBudgetCount; }
+	uint64_t GetBucketFrameCount(int bucket) const { return m_histogram[bucket]; }
+	static double GetBucketLowerBound(int bucket);
+	static int GetBucket(double milliseconds);
+
+private:
+	// Frame durations in ms, ring buffer
+	std::vector<float> m_window;
+	int m_windowCount = 0;
+	int m_writeIndex = 0;
+	std::vector<float> m_sortScratch;
+
+	uint64_t m_histogram[BUCKET_COUNT];
+	uint64_t m_totalFrameCount = 0;
+	uint64_t m_totalOverBudgetCount = 0;
+	double m_totalMs = 0.0;
+	float m_maxMs = 0.0f;
+
+	float m_budgetMs = 1000.0f / 60.0f;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "TlsfAllocator.h"
+
+// Creates the memory behind the heaps of a GpuHeapAllocator: a D3D12 heap and the buffer
+// placed over it in the D3D12 backend, plain memory when fuzzing on other platforms
+class GpuHeapSource
+{
+public:
+	virtual ~GpuHeapSource() {};
+
+	virtual bool CreateHeap(int heapIndex, uint64_t size) = 0;
+	// No allocation is left in it
+	virtual void DestroyHeap(int heapIndex) = 0;
+};
+
+// Range of a heap, keep it to free it
+struct GpuHeapAllocation
+{
+	int HeapIndex = -1;
+	uint32_t Block = TlsfAllocator::INVALID_ALLOCATION;
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+
+	bool IsValid() const { return HeapIndex >= 0; }
+};
+
+// Sub-allocates large heaps reserved from a GpuHeapSource, so small resources don't each pay
+// for a heap (and its 64 KB alignment). Every heap is carved up by a TlsfAllocator, a new heap is
+// only reserved when none of them fits, and heaps which become empty are released except the
+// first one. Thread safe.
+class GpuHeapAllocator
+{
+public:
+	// Called by Defragment for each moved allocation, without the allocator lock: it can allocate
+	// and free. The owner copies the data (from's range is still valid) and points its references
+	// to `to`, from is freed once every callback returned. An owner which freed from meanwhile
+	// (the Free is deferred to Defragment) frees `to` instead.
+	using MoveCallback = std::function<void(const GpuHeapAllocation& from, const GpuHeapAllocation& to)>;
+
+	GpuHeapAllocator();
+	~GpuHeapAllocator();
+
+	// INIT
+	// heapSize is the size of each reserved heap, allocations bigger than it fail
+	bool Init(GpuHeapSource* pSource, uint64_t heapSize);
+
+	// ALLOCATION
+	GpuHeapAllocation Allocate(uint64_t size, uint64_t alignment = TlsfAllocator::GRANULARITY);
+	void Free(const GpuHeapAllocation& allocation);
+
+	// DEFRAGMENTATION
+	// Moves up to maxMoves allocations out of the least used heap into the others, then
+	// releases it if it is empty. Returns the number of moves. Concurrent calls run one at a time.
+	int Defragment(int maxMoves, const MoveCallback& onMove);
+
+	// SETTER / GETTER
+	uint64_t GetHeapSize() const { return m_heapSize; }
+	// Released heaps leave a hole, GetHeapStats of a hole is empty
+	int GetHeapCount() const;
+	TlsfStats GetHeapStats(int heapIndex) const;
+
+private:
+	GpuHeapAllocation AllocateFromHeap(int heapIndex, uint64_t size, uint64_t alignment);
+	void ReleaseHeapIfEmpty(int heapIndex);
+
+private:
+	GpuHeapSource* m_pSource = nullptr;
+	uint64_t m_heapSize = 0;
+	// nullptr for released heaps, their index is reused
+	std::vector<TlsfAllocator*> m_heaps;
+	mutable std::mutex m_mutex;
+
+	// DEFRAGMENTATION
+	// Held for the whole Defragment, m_mutex is released during the callbacks
+	std::mutex m_defragmentMutex;
+	// Heap being emptied, -1 outside of Defragment. It is not released before the moves are done.
+	int m_defragmentSource = -1;
+	// Blocks of the source heap being moved, Free leaves them to Defragment
+	std::vector<uint32_t> m_movingBlocks;
+
+	// Planned by Defragment
+	struct Move
+	{
+		GpuHeapAllocation From;
+		GpuHeapAllocation To;
+	};
+};
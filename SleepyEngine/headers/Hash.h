@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// 64 bit FNV-1a for cache keys. Not cryptographic, but stable across runs and platforms so the
+// keys can be stored on disk.
+class Hash
+{
+public:
+	static const uint64_t OFFSET_BASIS = 0xCBF29CE484222325ull;
+
+	// Continues hash with size bytes of pData
+	static uint64_t Bytes(const void* pData, size_t size, uint64_t hash = OFFSET_BASIS);
+	// Hashes the length first, so consecutive strings can't shift into each other
+	static uint64_t String(const std::string& value, uint64_t hash = OFFSET_BASIS);
+	static uint64_t Integer(uint64_t value, uint64_t hash = OFFSET_BASIS);
+};
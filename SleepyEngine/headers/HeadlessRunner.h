@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include "Rhi.h"
+
+class Input;
+class ActionMap;
+class PhysicsWorld;
+class ScriptScheduler;
+class FrameStats;
+class JobSystem;
+class Renderer;
+
+// Runs the engine update loop without a window, a GPU or a real clock: input events and timer
+// deltas come from a recorded log (InputRecorder) and frames run back to back. Two runs of the
+// same log do the same work, so their frame times can be compared. Frames are drawn through the
+// null RHI backend (recording cost only) or the software one (actual pixels). Only uses portable
+// code, it also builds outside Windows.
+class HeadlessRunner
+{
+public:
+	HeadlessRunner();
+	~HeadlessRunner();
+
+	// INIT
+	// Fill the scene through the getters between Init and Run.
+	// backend must be portable: Null or Software.
+	bool Init(int workerCount = 0, RhiBackend backend = RhiBackend::Null);
+
+	// Replays the whole log, returns the number of frames run or -1 when the log cannot be read.
+	// FrameStats receives the measured CPU time of every frame, not the recorded deltas.
+	int Run(const std::string& replayPath);
+	bool ExportFrameStats(const std::string& csvPath);
+
+	// SETTER / GETTER
+	Input* GetInput() { return m_pInput; }
+	ActionMap* GetActionMap() { return m_pActionMap; }
+	PhysicsWorld* GetPhysicsWorld() { return m_pPhysicsWorld; }
+	ScriptScheduler* GetScriptScheduler() { return m_pScriptScheduler; }
+	FrameStats* GetFrameStats() { return m_pFrameStats; }
+	JobSystem* GetJobSystem() { return m_pJobSystem; }
+	RhiDevice* GetRhiDevice() { return m_pRhiDevice; }
+	RhiSwapChain* GetSwapChain() { return m_pSwapChain; }
+	Renderer* GetRenderer() { return m_pRenderer; }
+
+private:
+	JobSystem* m_pJobSystem = nullptr;
+	Input* m_pInput = nullptr;
+	ActionMap* m_pActionMap = nullptr;
+	ScriptScheduler* m_pScriptScheduler = nullptr;
+	PhysicsWorld* m_pPhysicsWorld = nullptr;
+	FrameStats* m_pFrameStats = nullptr;
+
+	RhiDevice* m_pRhiDevice = nullptr;
+	RhiSwapChain* m_pSwapChain = nullptr;
+	Renderer* m_pRenderer = nullptr;
+};
@@ -1,23 +1,85 @@
 #pragma once
+#include <bitset>
+#include <vector>
+#include "InputEvent.h"
 
-#include <map> // Ca marchait sans au campus mais plus maintenant. <map> est suppos tre import dans "pch.h" par Input.cpp
-//#include <string>
+class InputSampler;
 
+// Keyboard and mouse state, built from input events instead of polling every key.
+// Events are queued as they arrive (window messages or any other backend through PushEvent)
+// and applied once per frame by Update. Queries are O(1) and never allocate.
 class Input
 {
 public:
+	static const int KEY_COUNT = 256;
+
 	Input();
+	~Input();
 	bool Init();
 
+	// Applies the queued events. Pressed and released keys stay so until the next Update.
 	void Update();
 
-	bool IsPressed(int key, bool allowHold);
-	bool IsHeld(int key);
-	bool GotReleased(int key);
+	// EVENTS
+	void PushEvent(const InputEvent& event);
+#ifdef _WIN32
+	// Queues the input events of a window message, from the WndProc
+	void HandleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+#endif
+	// Queues a key up for every key down, for when the window loses the focus
+	void ReleaseAll();
+
+	// SAMPLING
+	// Keyboard and mouse are sampled by a thread at sampleRate (Hz) instead of coming from
+	// window messages, Update drains what it sampled. Event timestamps are then within
+	// 1 / sampleRate of the real change. Keys the sampler does not watch still come from the messages.
+#ifdef _WIN32
+	bool StartSampling(HWND window, double sampleRate);
+#endif
+	void StopSampling();
+	bool IsSampling() const { return m_pSampler != nullptr; }
+
+	// QUERIES
+	// allowHold: true while the key is down, otherwise only on the frame it went down
+	bool IsPressed(int key, bool allowHold) const;
+	// Down since a previous frame
+	bool IsHeld(int key) const;
+	bool GotReleased(int key) const;
+	bool IsDown(int key) const { return IsValid(key) && m_keyStates[key] != 0; }
+
+	// Timer ticks of the last press / release of the key, finer than the frame when sampling
+	int64_t GetPressedTime(int key) const { return IsValid(key) ? m_pressedTimes[key] : 0; }
+	int64_t GetReleasedTime(int key) const { return IsValid(key) ? m_releasedTimes[key] : 0; }
+
+	int GetMouseX() const { return m_mouseX; }
+	int GetMouseY() const { return m_mouseY; }
+
+	// Events applied by the last Update, in order, with their timestamps
+	const std::vector<InputEvent>& GetFrameEvents() const { return m_frameEvents; }
 
+	// Called by Update for every key changing state, once per edge
 	void OnKeyPressed(int key);
 	void OnKeyReleased(int key);
 
 private:
-	std::map<int, int> InputList;
-};
\ No newline at end of file
+	static bool IsValid(int key) { return key >= 0 && key < KEY_COUNT; }
+	void ApplyEvent(const InputEvent& event);
+
+private:
+	// 1 while the key is down
+	uint8_t m_keyStates[KEY_COUNT];
+	// Went down / up during the last Update, both can be set by a quick tap
+	std::bitset<KEY_COUNT> m_pressed;
+	std::bitset<KEY_COUNT> m_released;
+	int64_t m_pressedTimes[KEY_COUNT];
+	int64_t m_releasedTimes[KEY_COUNT];
+
+	int m_mouseX = 0;
+	int m_mouseY = 0;
+
+	// Both reserved in Init and swapped by Update
+	std::vector<InputEvent> m_eventQueue;
+	std::vector<InputEvent> m_frameEvents;
+
+	InputSampler* m_pSampler = nullptr;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+enum class InputEventType : uint8_t
+{
+	KeyDown,
+	KeyUp,
+	MouseMove
+};
+
+// One change of an input device. Mouse buttons are keys (VK_LBUTTON, VK_RBUTTON, VK_MBUTTON).
+struct InputEvent
+{
+	// Timer ticks (ns) when the change was seen
+	int64_t Time;
+	InputEventType Type;
+	// Virtual key code, for key events
+	uint8_t Key;
+	// Client area position, for mouse moves
+	int16_t X;
+	int16_t Y;
+};
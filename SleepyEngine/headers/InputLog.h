@@ -0,0 +1,63 @@
+#pragma once
+// Only std on purpose: logs are replayed by headless runs, without Windows
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "InputEvent.h"
+
+// Binary log of the input events and timer deltas of every frame, to replay a run exactly.
+// Layout: "SLIL", version (u32), then per frame: delta ticks, event count, and per event its
+// type, its key or mouse position, and its time relative to the frame. Integers are LEB128
+// varints (zigzag for signed values), a frame without input takes 2 to 4 bytes.
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool Open(const std::string& path);
+	// frameTicks: timer ticks of the frame the events were applied in
+	void RecordFrame(int64_t frameTicks, int64_t deltaTicks, const std::vector<InputEvent>& events);
+	void Close();
+
+	bool IsOpen() const { return m_file.is_open(); }
+	int GetFrameCount() const { return m_frameCount; }
+
+private:
+	void WriteVarint(uint64_t value);
+	void WriteSigned(int64_t value);
+
+private:
+	std::ofstream m_file;
+	// Encoded frame, written in one go
+	std::vector<uint8_t> m_buffer;
+	int m_frameCount = 0;
+};
+
+class InputReplay
+{
+public:
+	InputReplay();
+	~InputReplay() {};
+
+	// Loads the whole log, false if it is missing or not an input log
+	bool Open(const std::string& path);
+
+	// Decodes the next frame. previousFrameTicks is the replay clock before the frame, which then
+	// starts deltaTicks later; event times are rebuilt around it.
+	// Returns false at the end of the log or on a truncated frame.
+	bool NextFrame(int64_t previousFrameTicks, int64_t& deltaTicks, std::vector<InputEvent>& events);
+	void Rewind();
+
+	int GetFramesRead() const { return m_framesRead; }
+
+private:
+	bool ReadVarint(uint64_t& value);
+	bool ReadSigned(int64_t& value);
+
+private:
+	std::vector<uint8_t> m_data;
+	size_t m_readOffset = 0;
+	int m_framesRead = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include "InputEvent.h"
+#include "SpscQueue.h"
+
+// Samples the keyboard and mouse on its own thread at the rate given to Init and queues
+// timestamped events, so key timings are not rounded to the frame. SleepyEngine only starts it
+// when a rate is set with SetInputSamplingRate, 1 kHz is a good value.
+// A moving cursor is queued as one MouseMove per MOVE_COALESCE_SECONDS at most, a key event
+// flushes the pending move first so the order is kept.
+// Only watched keys are sampled, one GetAsyncKeyState call each per sample. Input keeps taking
+// the other keys from the window messages.
+class InputSampler
+{
+public:
+	static const uint32_t QUEUE_CAPACITY = 4096;
+	static constexpr double MOVE_COALESCE_SECONDS = 0.004;
+
+	InputSampler();
+	~InputSampler();
+
+	// INIT
+	// Events are only produced while window is in the foreground
+	bool Init(HWND window, double sampleRate);
+	// Not while running
+	void Watch(int key);
+	bool IsWatched(int key) const { return key >= 0 && key < 256 && m_isWatched[key]; }
+
+	void Start();
+	void Stop();
+
+	// CONSUMER (game thread)
+	bool PopEvent(InputEvent& event) { return m_events.Pop(event); }
+	// Pushes refused because the game thread did not drain the queue in time. Key edges are
+	// retried on the next sample, cursor moves are merged into the next one.
+	uint64_t GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+	void ThreadMain();
+	void Sample(int64_t time);
+	// False when the queue is full, the caller keeps its state to retry on the next sample
+	bool Emit(const InputEvent& event);
+	bool FlushMove();
+	void WaitUntil(int64_t ticks);
+
+private:
+	HWND m_window = nullptr;
+	int64_t m_periodTicks = 0;
+	int64_t m_moveCoalesceTicks = 0;
+	// High resolution waitable timer when available, Sleep otherwise
+	HANDLE m_waitTimer = nullptr;
+
+	std::vector<uint8_t> m_watchedKeys;
+	bool m_isWatched[256];
+
+	// SAMPLER THREAD STATE
+	uint8_t m_keyStates[256];
+	POINT m_cursor = { -1, -1 };
+	// Last cursor move, not queued yet
+	InputEvent m_pendingMove = {};
+	bool m_hasPendingMove = false;
+	int64_t m_pendingMoveStart = 0;
+	bool m_wasForeground = false;
+
+	std::thread m_thread;
+	std::atomic<bool> m_isRunning;
+
+	SpscQueue<InputEvent> m_events;
+	std::atomic<uint64_t> m_droppedCount;
+};
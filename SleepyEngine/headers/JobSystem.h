@@ -0,0 +1,181 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+// Runs [begin, end) of the range given to the job, begin = end = 0 for plain jobs
+typedef void (*JobFunction)(void* pData, int begin, int end);
+
+struct Job;
+
+// Number of jobs left in a group. Jobs given to RunAfter start when it reaches 0, once the jobs
+// of the group left it: waiting on their counter also means this one can be destroyed.
+// Reuse a counter with continuations only once it IsDone.
+class JobCounter
+{
+public:
+	JobCounter() : m_value(0), m_finishingCount(0) {}
+
+	// Once true, no job touches the counter anymore and it can be destroyed
+	bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0 && m_finishingCount.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int> m_value;
+	// Jobs inside Finish, the last one still starts the continuations after m_value reached 0
+	std::atomic<int> m_finishingCount;
+	std::mutex m_continuationMutex;
+	std::vector<Job*> m_continuations;
+};
+
+struct Job
+{
+	JobFunction Function;
+	void* pData;
+	int Begin;
+	int End;
+	// > 0 for ParallelFor ranges, which are split while other workers starve
+	int GrainSize;
+	JobCounter* pCounter;
+	// Set from allocation to Finish, a pool slot must not be reused before
+	std::atomic<bool> IsInFlight = false;
+};
+
+// Chase-Lev work stealing deque: the owner pushes and pops at the bottom, thieves steal at the top.
+class WorkStealingDeque
+{
+public:
+	static const int64_t CAPACITY = 4096;
+
+	WorkStealingDeque();
+
+	// OWNER
+	// Returns false when full
+	bool Push(Job* pJob);
+	Job* Pop();
+	bool IsEmpty() const;
+
+	// THIEVES
+	Job* Steal();
+
+private:
+	std::atomic<int64_t> m_top;
+	std::atomic<int64_t> m_bottom;
+	std::atomic<Job*> m_jobs[CAPACITY];
+};
+
+// Fixed pool of worker threads with one work stealing deque each.
+// The thread calling Init is worker 0: it does not get a thread but executes jobs while in Wait.
+// Other threads can submit jobs too, through a shared locked queue.
+class JobSystem
+{
+public:
+	// Jobs a thread can have allocated and not finished, past it allocating runs jobs until one finishes
+	static const int MAX_JOBS_IN_FLIGHT = 4096;
+
+	JobSystem();
+	~JobSystem();
+
+	// INIT
+	// workerCount <= 0 uses every hardware thread
+	bool Init(int workerCount = 0);
+	void Shutdown();
+
+	// JOBS
+	void Run(JobFunction function, void* pData, JobCounter* pCounter);
+	// Starts the job once dependency reaches 0
+	void RunAfter(JobCounter& dependency, JobFunction function, void* pData, JobCounter* pCounter);
+	// Executes jobs until the counter reaches 0
+	void Wait(JobCounter& counter);
+
+	// Calls function(begin, end) on sub ranges of [0, count), blocks until all are done.
+	// Ranges are split lazily, only when the local deque is empty (some worker stole from it),
+	// so the number of jobs adapts to the load instead of being fixed up front.
+	template<typename Function>
+	void ParallelFor(int count, int grainSize, const Function& function)
+	{
+		if (count <= 0)
+			return;
+
+		if (m_workerCount <= 1 || count <= grainSize)
+		{
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		Submit(&ParallelForTrampoline<Function>, (void*)&function, 0, count, grainSize > 0 ? grainSize : 1, &counter);
+		Wait(counter);
+	}
+
+	// SETTER / GETTER
+	int GetWorkerCount() const { return m_workerCount; }
+	// -1 on threads which are not workers
+	static int GetWorkerIndex();
+
+private:
+	template<typename Function>
+	static void ParallelForTrampoline(void* pData, int begin, int end)
+	{
+		(*(const Function*)pData)(begin, end);
+	}
+
+	void Submit(JobFunction function, void* pData, int begin, int end, int grainSize, JobCounter* pCounter);
+	void Push(Job* pJob);
+	struct JobPool;
+
+	// Pool of the calling thread, created on its first job
+	JobPool* GetJobPool();
+	Job* AllocateJob();
+	Job* GetJob();
+	void Execute(Job* pJob);
+	void Finish(Job* pJob);
+	void WorkerMain(int workerIndex);
+
+private:
+	struct Worker
+	{
+		WorkStealingDeque Deque;
+		std::thread Thread;
+		uint32_t Random = 0;
+	};
+
+	struct JobPool
+	{
+		Job Jobs[MAX_JOBS_IN_FLIGHT];
+		uint32_t NextIndex = 0;
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	int m_workerCount = 0;
+	std::atomic<bool> m_isRunning;
+
+	// Jobs submitted by threads which are not workers
+	std::mutex m_sharedQueueMutex;
+	std::vector<Job*> m_sharedQueue;
+	std::atomic<int> m_sharedQueueSize;
+
+	// Idle workers sleep here, woken when a job is pushed
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<int> m_sleepingCount;
+
+	// Job pools, one per thread which allocated jobs, owned here
+	std::mutex m_poolMutex;
+	std::vector<std::unique_ptr<JobPool>> m_pools;
+	std::unordered_map<std::thread::id, JobPool*> m_threadPools;
+
+	// Tells instances apart for the thread_local pool shortcut, a new one can be built
+	// at the address of a destroyed one
+	uint64_t m_generation;
+
+	static std::atomic<uint64_t> s_nextGeneration;
+	static thread_local int t_workerIndex;
+	static thread_local JobPool* t_pJobPool;
+	static thread_local uint64_t t_jobPoolGeneration;
+};
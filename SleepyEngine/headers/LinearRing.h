@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Offsets of a ring shared by the frames in flight (upload memory, descriptors). Allocations are
+// linear and lock free, a compare and swap on the head. When a frame ends, everything allocated
+// so far is tagged with the fence value of its submission, and comes back once it completed.
+// Offsets grow forever and wrap around the capacity, an allocation never straddles the end.
+class LinearRing
+{
+public:
+	static const uint64_t INVALID_OFFSET = ~(uint64_t)0;
+	// Frames ended but not retired. More are merged into the last one, which only retires it later.
+	static const int MAX_PENDING_FRAMES = 16;
+
+	LinearRing();
+	~LinearRing() {};
+
+	// INIT
+	void Init(uint64_t capacity);
+
+	// FRAME
+	// Single threaded, not concurrently with allocations of the frame being ended
+	// Frees the frames whose fence value is <= completedFenceValue
+	void Retire(uint64_t completedFenceValue);
+	// Everything allocated so far is freed once fenceValue completes
+	void EndFrame(uint64_t fenceValue);
+
+	// ALLOCATION
+	// Thread safe. alignment must be a power of two dividing the capacity.
+	// Returns the offset in [0, capacity), INVALID_OFFSET when the space is still in use.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	// SETTER / GETTER
+	uint64_t GetCapacity() const { return m_capacity; }
+	// Allocated and not retired yet, wasted space at the wrap included
+	uint64_t GetUsedSize() const { return m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed); }
+	uint64_t GetFailedCount() const { return m_failedCount.load(std::memory_order_relaxed); }
+	int GetPendingFrameCount() const { return m_pendingCount; }
+
+private:
+	uint64_t m_capacity = 0;
+
+	// Virtual offsets, the physical one is offset % m_capacity
+	std::atomic<uint64_t> m_head;
+	// Everything before it is free
+	std::atomic<uint64_t> m_tail;
+	std::atomic<uint64_t> m_failedCount;
+
+	// Ended frames, oldest first
+	struct PendingFrame
+	{
+		uint64_t FenceValue;
+		// m_head when the frame ended
+		uint64_t End;
+	};
+	PendingFrame m_pendingFrames[MAX_PENDING_FRAMES];
+	int m_pendingFirst = 0;
+	int m_pendingCount = 0;
+};
@@ -5,7 +5,10 @@
 //***************************************************************************************
 
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+#include <cstdlib>
 #include <DirectXMath.h> 
 #include <cstdint>
 
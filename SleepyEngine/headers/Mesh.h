@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <DirectXMath.h>
+
+class RhiDevice;
+class RhiBuffer;
+
+// Vertex layout of Color.hlsl
+struct Vertex {
+	DirectX::XMFLOAT3 Pos;
+	DirectX::XMFLOAT4 Color;
+};
+
+// Per instance constants of Color.hlsl, an array of them is bound to b0
+struct InstanceData
+{
+	// Transposed for HLSL
+	DirectX::XMFLOAT4X4 WorldViewProj;
+	// Multiplies the vertex color
+	DirectX::XMFLOAT4 Color;
+};
+
+// Triangle list with 32 bit indices. The buffers live in upload memory, written once by Init.
+class Mesh
+{
+public:
+	Mesh();
+	~Mesh();
+
+	// INIT
+	bool Init(RhiDevice* pDevice, const Vertex* pVertices, int vertexCount, const uint32_t* pIndices, int indexCount);
+	// Cube from -1 to 1, clockwise faces
+	static Mesh* CreateBox(RhiDevice* pDevice, const DirectX::XMFLOAT4& color);
+
+	// SETTER / GETTER
+	RhiBuffer* GetVertexBuffer() const { return m_pVertexBuffer; }
+	RhiBuffer* GetIndexBuffer() const { return m_pIndexBuffer; }
+	int GetVertexCount() const { return m_vertexCount; }
+	int GetIndexCount() const { return m_indexCount; }
+	// Small id for sort keys. It wraps, two meshes sharing one only sort less well.
+	uint32_t GetSortId() const { return m_sortId; }
+
+private:
+	RhiBuffer* m_pVertexBuffer = nullptr;
+	RhiBuffer* m_pIndexBuffer = nullptr;
+	int m_vertexCount = 0;
+	int m_indexCount = 0;
+	uint32_t m_sortId;
+
+	static std::atomic<uint32_t> s_nextSortId;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+class Mesh;
+
 class MeshRenderer
 {
 public:
@@ -9,6 +11,11 @@ public:
 	// INIT
 	void Init();
 
+	// SETTER / GETTER
+	// Renderers sharing a mesh, a shader and a material are drawn as one instanced draw (RenderQueue)
+	Mesh* GetMesh() { return m_pMesh; }
+	void SetMesh(Mesh* pMesh) { m_pMesh = pMesh; }
+
 private:
 	Mesh* m_pMesh = nullptr;
 };
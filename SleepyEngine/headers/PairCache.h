@@ -0,0 +1,59 @@
+#pragma once
+
+// Persistent set of broadphase pairs, updated from the broadphase deltas
+// (x intervals starting or stopping to overlap) instead of being rebuilt every step.
+// Each pair remembers whether its AABBs touched on the previous step so the
+// world can tell contacts that begin, stay or end.
+class PairCache
+{
+public:
+	enum class ContactState : uint8_t
+	{
+		None,
+		Begin,
+		Stay,
+		End
+	};
+
+	struct Pair
+	{
+		// A < B, indices in the PhysicsWorld collider list
+		int A;
+		int B;
+		ContactState State;
+
+		bool IsTouching() const { return State == ContactState::Begin || State == ContactState::Stay; }
+	};
+
+	PairCache();
+	~PairCache() {};
+
+	// INIT
+	void Init();
+
+	// BROADPHASE DELTAS
+	// Returns false if the pair was already cached
+	bool Add(int a, int b);
+	// Returns false if the pair was not cached, otherwise pRemoved receives the removed pair
+	bool Remove(int a, int b, Pair* pRemoved);
+
+	// COLLIDER REMOVAL
+	// Removes every pair referencing index and appends them to removed
+	void RemoveAll(int index, std::vector<Pair>& removed);
+	// Replaces index from by index to in every pair, to must not be referenced anymore
+	void Rename(int from, int to);
+
+	// SETTER / GETTER
+	int GetCount() const { return (int)m_pairs.size(); }
+	Pair& GetPair(int i) { return m_pairs[i]; }
+	const Pair* Find(int a, int b) const;
+
+private:
+	static uint64_t MakeKey(int a, int b);
+	void RemoveAt(int i);
+
+private:
+	// Dense storage for cache friendly iteration, indexed through m_pairIndices
+	std::vector<Pair> m_pairs;
+	std::unordered_map<uint64_t, int> m_pairIndices;
+};
@@ -0,0 +1,186 @@
+#pragma once
+#include "PairCache.h"
+
+class Collider;
+class Script;
+class JobSystem;
+
+// One contact that began or ended during a step
+struct ContactEvent
+{
+	Collider* pA;
+	Collider* pB;
+};
+
+// Simulates the registered colliders: integration, incremental sweep and prune broadphase,
+// AABB narrowphase and an impulse solver. Continuous colliders use swept bounds in the
+// broadphase and are stopped at their time of impact.
+// Bodies touching each other are grouped in islands. An island whose bodies all stayed
+// under the sleep velocity threshold for m_timeToSleep seconds is put to sleep and skipped
+// by integration, broadphase updates and the solver until a contact or WakeUp() wakes it.
+class PhysicsWorld
+{
+public:
+	PhysicsWorld();
+	~PhysicsWorld() {};
+
+	// INIT
+	void Init();
+
+	// COLLIDERS
+	void AddCollider(Collider* pCollider);
+	// The end events of the removed collider are sent on the next step, keep it alive until then
+	void RemoveCollider(Collider* pCollider);
+
+	// UPDATE
+	void Step(float deltaTime);
+
+	// Called by Collider when its layer, mask or mass changed. Ends the cached pairs the filter now
+	// rejects and adds the overlapping ones it now accepts: pairs which still collide get no event.
+	void RefreshFilter(Collider* pCollider, bool wasStatic);
+
+	// SLEEP
+	// Called by Collider::WakeUp, processed at the beginning of the next step.
+	// For a static collider which moved, wakes the sleeping bodies around its old and new bounds.
+	void RequestWake(Collider* pCollider);
+
+	// CONTACT EVENTS
+	// Listeners receive all the begin and end events of a step in a single OnContacts call
+	void AddContactListener(Script* pScript);
+	void RemoveContactListener(Script* pScript);
+
+	// SETTER / GETTER
+	void SetGravity(const XMFLOAT3& gravity) { m_gravity = gravity; }
+	XMFLOAT3 GetGravity() const { return m_gravity; }
+
+	void SetSleepThreshold(float linearVelocity) { m_sleepVelocitySq = linearVelocity * linearVelocity; }
+	void SetTimeToSleep(float seconds) { m_timeToSleep = seconds; }
+
+	// Per body stages (integration, sleep timers) are spread over its workers, nullptr to stay serial
+	void SetJobSystem(JobSystem* pJobSystem) { m_pJobSystem = pJobSystem; }
+
+	int GetColliderCount() const { return (int)m_colliders.size(); }
+	const Collider* GetCollider(int index) const { return m_colliders[index]; }
+	int GetAwakeCount() const { return m_awakeCount; }
+	int GetSleepingIslandCount() const { return (int)m_sleepingIslands.size(); }
+	int GetCachedPairCount() const { return m_pairCache.GetCount(); }
+
+private:
+	struct Bounds
+	{
+		XMFLOAT3 Min;
+		XMFLOAT3 Max;
+	};
+
+	// Start or end of a collider interval on the sweep axis (x)
+	struct Endpoint
+	{
+		float Value;
+		int Index;
+		bool IsMin;
+	};
+
+	struct Contact
+	{
+		int A;
+		int B;
+		// From A to B
+		XMFLOAT3 Normal;
+		float Penetration;
+	};
+
+	// STEP STAGES
+	void ProcessWakeRequests();
+	void IntegrateVelocities(float deltaTime);
+	void UpdateBroadPhase();
+	void UpdatePairs();
+	void SolveContacts();
+	void SolveTimeOfImpact(float deltaTime);
+	void IntegratePositions(float deltaTime);
+	void CorrectPositions();
+	void BuildIslands();
+	void UpdateSleep(float deltaTime);
+	void DispatchContactEvents();
+
+	// BROADPHASE DELTAS
+	void OnOverlapBegin(int a, int b);
+	void OnOverlapEnd(int a, int b);
+
+	// HELPERS
+	bool IsActive(int index) const;
+	bool IsPairAccepted(int a, int b) const;
+	bool IsContinuousActive(int index) const;
+	// Time of impact of box a moving by motion against the static box b, as a fraction of motion
+	static bool SweepBounds(const Bounds& a, const XMFLOAT3& motion, const Bounds& b, float& timeOfImpact, XMFLOAT3& normal);
+	static bool Overlaps(const Bounds& a, const Bounds& b);
+	bool IsTouching(int a, int b) const;
+	void RefreshBounds(int index);
+	void AddContact(int a, int b);
+	void WakeIsland(int islandId);
+	// Refreshes the bounds of a moved static collider and wakes the sleepers it touched or touches
+	void WakeAroundStatic(int index);
+	int FindRoot(int index);
+
+private:
+	std::vector<Collider*> m_colliders;
+
+	// BROADPHASE
+	// Bounds are only refreshed for active bodies, sleeping ones keep their last bounds
+	std::vector<Bounds> m_bounds;
+	// Kept sorted between steps: insertion sort stays cheap and every swap
+	// between a min and a max endpoint is a pair starting or stopping to overlap
+	std::vector<Endpoint> m_endpoints;
+	PairCache m_pairCache;
+	std::vector<PairCache::Pair> m_removedPairs;
+	// Sweep axis interval of each collider, gathered from the endpoints by RefreshFilter
+	std::vector<float> m_sweepMin;
+	std::vector<float> m_sweepMax;
+	// Active continuous bodies found by the last broadphase update
+	int m_continuousCount = 0;
+
+	// NARROWPHASE / SOLVER
+	std::vector<Contact> m_contacts;
+	int m_solverIterations = 4;
+	float m_penetrationSlop = 0.01f;
+	float m_correctionPercent = 0.6f;
+	// Under this approach speed contacts do not bounce, which lets resting bodies settle
+	float m_restitutionThreshold = 1.0f;
+
+	// CONTINUOUS COLLISION
+	// Fraction of the step each body is allowed to move, and the normal it hit
+	std::vector<float> m_timeOfImpact;
+	std::vector<XMFLOAT3> m_impactNormals;
+
+	// CONTACT EVENTS
+	std::vector<ContactEvent> m_beginEvents;
+	std::vector<ContactEvent> m_endEvents;
+	std::vector<Script*> m_contactListeners;
+
+	// ISLANDS
+	std::vector<int> m_islandParent;
+	std::vector<int> m_rootToIsland;
+	// Island id -> members, filled when the island is put to sleep
+	std::unordered_map<int, std::vector<int>> m_sleepingIslands;
+	// Reused between steps, only the first m_awakeIslandCount entries are valid
+	std::vector<std::vector<int>> m_awakeIslands;
+	int m_awakeIslandCount = 0;
+	int m_nextIslandId = 0;
+
+	// SLEEP
+	std::vector<Collider*> m_wakeRequests;
+	float m_sleepVelocitySq = 0.05f * 0.05f;
+	float m_timeToSleep = 0.5f;
+	// Put to sleep by the last step, their previous center still has to catch up
+	std::vector<Collider*> m_fellAsleep;
+	// Dynamic bodies not sleeping. When 0 the step does nothing.
+	int m_awakeCount = 0;
+
+	// PARALLELISM
+	JobSystem* m_pJobSystem = nullptr;
+	// Bodies per job range, smaller worlds are not worth splitting
+	int m_parallelGrainSize = 256;
+
+	XMFLOAT3 m_gravity = { 0.0f, -9.81f, 0.0f };
+	float m_maxDeltaTime = 0.05f;
+	float m_stepDeltaTime = 0.0f;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Rhi.h"
+#include "BlobCache.h"
+
+class JobSystem;
+
+struct PipelineCacheStats
+{
+	// Asked for a pipeline which was already created or being created
+	int Hits = 0;
+	int Created = 0;
+	// Created from the driver blob a previous run stored
+	int FromDisk = 0;
+	// Rejected by the backend, or it threw. Each one is also logged.
+	int Failed = 0;
+};
+
+// Pipelines keyed by a hash of everything they are made of: the shader bytecode, the root
+// parameters and depth test of the description, and the state the backend fixes (input layout,
+// blend, rasterizer, formats: RhiDevice::GetPipelineStateHash). Each distinct pipeline is created
+// once and owned by the cache, the backend shares root signatures between them.
+// Creation can run on the job system (CreateAsync) so it does not stall the frame asking for it.
+// With a cache directory, the driver blob of each pipeline is stored and given back to the driver
+// by the next runs, which skips most of the compilation.
+class PipelineCache
+{
+public:
+	PipelineCache();
+	// Waits for the pending creations: destroy it before the job system
+	~PipelineCache();
+
+	// INIT
+	// pJobSystem can be nullptr, CreateAsync then creates on the calling thread
+	void Init(RhiDevice* pDevice, JobSystem* pJobSystem);
+	// Before the first creation. directory is created if needed, empty to keep nothing on disk.
+	bool SetCacheDirectory(const std::string& directory);
+
+	// CREATION
+	// Creates the pipeline on the calling thread if it was never asked for, waits for it if it is
+	// being created on a worker. nullptr when the backend rejects desc.
+	RhiPipeline* GetOrCreate(const RhiPipelineDesc& desc);
+	// Starts creating the pipeline on a worker and returns its key for Find. The bytecode is
+	// copied, it can be freed right away.
+	uint64_t CreateAsync(const RhiPipelineDesc& desc);
+	// nullptr while the pipeline is being created, or when it was rejected
+	RhiPipeline* Find(uint64_t key) const;
+	// Waits for every pending creation
+	void WaitAll();
+
+	// Never 0
+	uint64_t ComputeKey(const RhiPipelineDesc& desc) const;
+
+	// SETTER / GETTER
+	PipelineCacheStats GetStats() const;
+	int GetPipelineCount() const;
+
+private:
+	struct Entry;
+
+	// Entry of desc, isNew when this call added it
+	Entry* FindOrAdd(const RhiPipelineDesc& desc, bool& isNew);
+	void Create(Entry* pEntry);
+	void WaitFor(Entry* pEntry);
+	static void CreateJob(void* pData, int begin, int end);
+
+private:
+	RhiDevice* m_pDevice = nullptr;
+	JobSystem* m_pJobSystem = nullptr;
+	BlobCache m_blobCache;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, Entry*> m_entries;
+
+	std::atomic<int> m_hitCount{ 0 };
+	std::atomic<int> m_createdCount{ 0 };
+	std::atomic<int> m_fromDiskCount{ 0 };
+	std::atomic<int> m_failedCount{ 0 };
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Minimal PNG encoder: 8 bit RGBA, no filtering and stored (uncompressed) deflate blocks.
+// Files are bigger than they need to be but any viewer or image diff tool reads them.
+class PngWriter
+{
+public:
+	// pixels are width * height RGBA8 values, R in the lowest byte, rows top to bottom
+	static bool WriteRgba(const std::string& path, uint32_t width, uint32_t height, const uint32_t* pPixels);
+
+private:
+	static uint32_t Crc32(uint32_t crc, const uint8_t* pData, size_t size);
+};
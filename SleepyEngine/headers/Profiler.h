@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include "Timer.h"
+
+// Hierarchical CPU profiler.
+// PROFILE_SCOPE("Name") records the duration of the enclosing scope, PROFILE_FUNCTION() uses the
+// function name. Zones go to a ring buffer owned by the recording thread (no lock, no allocation),
+// and can be exported as a Chrome trace / Perfetto JSON file (chrome://tracing, ui.perfetto.dev).
+// Everything compiles to nothing unless SLEEPY_PROFILE is defined. When compiled in, a disabled
+// profiler costs a single relaxed atomic load per zone.
+#ifdef SLEEPY_PROFILE
+	#define PROFILE_CONCAT_INNER(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+	#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+	#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_THREAD_NAME(name)
+#endif
+
+struct ProfileZone
+{
+	// Must outlive the export, string literals and __FUNCTION__ do
+	const char* Name;
+	// Timer ticks (ns)
+	int64_t Start;
+	int64_t End;
+	uint32_t Depth;
+};
+
+class Profiler
+{
+public:
+	// Zones kept per thread, older ones are overwritten
+	static const uint32_t BUFFER_CAPACITY = 1 << 16;
+
+	// SETTER / GETTER
+	static void SetEnabled(bool isEnabled) { s_isEnabled.store(isEnabled, std::memory_order_relaxed); }
+	static bool IsEnabled() { return s_isEnabled.load(std::memory_order_relaxed); }
+	static void SetThreadName(const char* name);
+
+	// RECORDING (used by ProfileScope)
+	static int64_t BeginZone();
+	static void EndZone(const char* name, int64_t start);
+
+	// EXPORT
+	// Writes the zones of every running thread as a Chrome trace JSON file.
+	// Zones recorded while exporting may be missing or torn.
+	static bool ExportChromeTrace(const std::string& path);
+	// Drops every recorded zone. Each thread applies it to its own buffer on its next zone,
+	// the export skips the buffers which did not yet.
+	static void Clear();
+
+private:
+	struct ThreadBuffer
+	{
+		ThreadBuffer() : Zones(BUFFER_CAPACITY), WriteIndex(0) {}
+
+		std::vector<ProfileZone> Zones;
+		// Only written by the owning thread, read with acquire by the exporter
+		std::atomic<uint64_t> WriteIndex;
+		// Last Clear applied by the owning thread, the zones are stale while it differs from s_clearCount
+		std::atomic<uint64_t> ClearCount{ 0 };
+		uint32_t Depth = 0;
+		uint32_t ThreadIndex = 0;
+		std::string ThreadName;
+	};
+
+	// Unregisters and frees the buffer of its thread when the thread exits
+	struct ThreadBufferRelease
+	{
+		bool IsRegistered = false;
+		~ThreadBufferRelease();
+	};
+
+	// First call on a thread registers its buffer (takes a lock once per thread)
+	static ThreadBuffer* GetThreadBuffer();
+	// Zones of pBuffer the exporter can read, none while a Clear is pending on it
+	static uint64_t GetPublishedCount(ThreadBuffer* pBuffer);
+
+	static std::atomic<bool> s_isEnabled;
+	static std::atomic<uint64_t> s_clearCount;
+
+	// A buffer lives as long as its thread: export before joining threads to keep their zones
+	static std::mutex s_registryMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> s_threadBuffers;
+	// Trace thread ids, not reused when threads exit
+	static uint32_t s_nextThreadIndex;
+	static thread_local ThreadBuffer* t_pThreadBuffer;
+	static thread_local ThreadBufferRelease t_threadBufferRelease;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name)
+	{
+		m_name = Profiler::IsEnabled() ? name : nullptr;
+		if (m_name != nullptr)
+			m_start = Profiler::BeginZone();
+	}
+
+	~ProfileScope()
+	{
+		if (m_name != nullptr)
+			Profiler::EndZone(m_name, m_start);
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* m_name;
+	int64_t m_start = 0;
+};
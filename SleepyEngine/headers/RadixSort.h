@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+class JobSystem;
+
+// 64 bit key and the index of the element it sorts
+struct SortKey
+{
+	uint64_t Key;
+	uint32_t Index;
+};
+
+// Stable LSD radix sort of 64 bit keys, one byte per pass. Passes where every key has the same
+// byte are skipped, so keys with unused bits sort in fewer passes. With a job system each pass
+// counts and scatters chunks of the array in parallel.
+class RadixSort
+{
+public:
+	// Under this count the sort stays on the calling thread
+	static const int MIN_PARALLEL_COUNT = 8192;
+
+	// pScratch must hold count keys, the sorted keys end up in pKeys
+	static void Sort(SortKey* pKeys, SortKey* pScratch, int count, JobSystem* pJobSystem = nullptr);
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <vector>
+#include "RadixSort.h"
+#include "Mesh.h"
+
+class RhiPipeline;
+class RhiCommandList;
+class RhiBuffer;
+class JobSystem;
+
+enum class RenderPassType : uint8_t
+{
+	// Sorted by state, then front to back
+	Opaque = 0,
+	// Sorted back to front first, blending needs it
+	Transparent = 1,
+};
+
+// What a draw needs, the payload of its sort key
+struct RenderItem
+{
+	RhiPipeline* pPipeline = nullptr;
+	const Mesh* pMesh = nullptr;
+	// Nothing is bound per material yet, it only groups draws
+	uint16_t MaterialId = 0;
+	InstanceData Instance;
+};
+
+// State changes of recorded batches
+struct RenderQueueStats
+{
+	int ItemCount = 0;
+	// Instanced draws, one per run of items sharing pipeline, material and mesh
+	int DrawCalls = 0;
+	int PipelineChanges = 0;
+	int MaterialChanges = 0;
+	int MeshChanges = 0;
+	// Items which did not get constant memory and were not drawn
+	int DroppedItems = 0;
+
+	void Add(const RenderQueueStats& stats);
+};
+
+// Draws of a frame, sorted by a packed 64 bit key so consecutive draws share as much state as
+// possible. From the most significant bit: pass, pipeline, material, mesh, quantized depth
+// (transparent items put the inverted depth right after the pass instead).
+// Once sorted, consecutive items sharing pipeline, material and mesh are batched into a single
+// instanced draw, their InstanceData packed in one constant buffer range. Record only rebinds what
+// changed between two consecutive draws, and can record ranges of batches on several command lists
+// at once.
+class RenderQueue
+{
+public:
+	static const int PASS_BITS = 4;
+	static const int PIPELINE_BITS = 12;
+	static const int MATERIAL_BITS = 12;
+	static const int MESH_BITS = 12;
+	static const int DEPTH_BITS = 24;
+	// Alignment of constant buffer views, each batch starts on it
+	static const uint64_t CONSTANT_ALIGNMENT = 256;
+	// Size of gInstances in Color.hlsl, longer runs are split
+	static const int MAX_INSTANCES_PER_DRAW = 512;
+	// Below this, instance data is written on the calling thread
+	static const int MIN_PARALLEL_COUNT = 4096;
+
+	RenderQueue();
+	~RenderQueue() {};
+
+	// INIT
+	// pJobSystem can be nullptr to sort on the calling thread
+	void Init(JobSystem* pJobSystem);
+
+	// FRAME
+	void Clear();
+	// depth in [0, 1], 0 is near
+	void Add(RenderPassType pass, float depth, const RenderItem& item);
+	// Sorts the items and batches them
+	void Sort();
+	// Constant memory the batches need, valid after Sort
+	uint64_t GetConstantSize() const { return m_constantSize; }
+	// Copies the instance data of every batch to pConstantData, GetConstantSize() bytes
+	void WriteConstants(uint8_t* pConstantData) const;
+	// Records batches [firstBatch, endBatch), from any thread. Starts from an unknown state so each
+	// range can go on its own command list. pConstantBuffer holds the WriteConstants data at
+	// constantOffset (CONSTANT_ALIGNMENT aligned). Adds its draws and state changes to stats.
+	void Record(RhiCommandList* pCommandList, int firstBatch, int endBatch, RhiBuffer* pConstantBuffer, uint64_t constantOffset, RenderQueueStats& stats) const;
+
+	static uint64_t MakeKey(RenderPassType pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId, float depth);
+	// Splits batchCount batches into at most maxRangeCount contiguous ranges of at least
+	// minBatchesPerRange batches (but one). Range i is [pRangeBegins[i], pRangeBegins[i + 1]),
+	// pRangeBegins holds maxRangeCount + 1 values. Returns the range count, at least 1.
+	static int Partition(int batchCount, int maxRangeCount, int minBatchesPerRange, int* pRangeBegins);
+
+	// SETTER / GETTER
+	int GetItemCount() const { return (int)m_items.size(); }
+	// Valid after Sort
+	int GetBatchCount() const { return (int)m_batches.size(); }
+
+private:
+	// Items m_keys[FirstKey, FirstKey + InstanceCount) drawn at once
+	struct Batch
+	{
+		int FirstKey;
+		int InstanceCount;
+		// From the start of the constant memory of the queue
+		uint64_t ConstantOffset;
+	};
+
+	void BuildBatches();
+	void WriteInstances(int firstBatch, int endBatch, uint8_t* pConstantData) const;
+
+private:
+	JobSystem* m_pJobSystem = nullptr;
+	std::vector<RenderItem> m_items;
+	std::vector<SortKey> m_keys;
+	std::vector<SortKey> m_sortScratch;
+	std::vector<Batch> m_batches;
+	uint64_t m_constantSize = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+// Included by SleepyEngine.h, so it must not rely on pch.h
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+// Box drawn for a collider, in world space
+struct RenderBox
+{
+	DirectX::XMFLOAT3 Center;
+	// Center one fixed step earlier, the box is drawn in between
+	DirectX::XMFLOAT3 PreviousCenter;
+	DirectX::XMFLOAT3 HalfExtents;
+	bool IsSleeping;
+};
+
+// Everything the renderer needs to draw a frame, copied out of the simulation.
+// Once published the simulation does not touch it anymore, so the render thread can
+// read it without locking while the next frame is simulated.
+struct RenderSnapshot
+{
+	uint64_t FrameIndex = 0;
+	// Simulation time the snapshot was taken at (s)
+	double Time = 0.0;
+	// Progress between the last two fixed steps: boxes are drawn at lerp(PreviousCenter, Center, Alpha)
+	float Alpha = 0.0f;
+
+	DirectX::XMFLOAT4 ClearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	// Left handed, y up
+	DirectX::XMFLOAT3 CameraPosition = { 0.0f, 10.0f, -30.0f };
+	DirectX::XMFLOAT3 CameraTarget = { 0.0f, 0.0f, 0.0f };
+	// Vertical field of view (rad)
+	float CameraFovY = 0.785398f;
+	std::vector<RenderBox> Boxes;
+
+	// Keeps the capacity, a snapshot slot stops allocating after a few frames
+	void Clear() { Boxes.clear(); }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include "Rhi.h"
+#include "RenderSnapshot.h"
+#include "RenderQueue.h"
+#include "UploadRing.h"
+#include "PipelineCache.h"
+
+class PhysicsWorld;
+class JobSystem;
+class Mesh;
+
+// Draws snapshots through any RHI backend. Owns the ring of frames in flight and the upload ring
+// they share. Boxes go through a RenderQueue, they are only drawn once a pipeline exists (CreatePipeline).
+// The sorted batches are split into contiguous ranges recorded in parallel, each on its own command
+// list, and submitted at once in order. The first list clears and suspends the render pass, the
+// next ones resume it.
+class Renderer
+{
+public:
+	static const int MAX_COMMAND_LISTS = 8;
+	// Below this, a list is not worth a job
+	static const int MIN_BATCHES_PER_LIST = 16;
+
+	Renderer();
+	~Renderer();
+
+	// INIT
+	// framesInFlight is clamped to [1, FrameRing::MAX_FRAME_COUNT]
+	// pJobSystem can be nullptr to sort and record on the calling thread, with a single command list
+	// The upload ring holds frameUploadSize bytes per frame in flight
+	bool Init(RhiDevice* pDevice, RhiSwapChain* pSwapChain, int framesInFlight, JobSystem* pJobSystem, uint64_t frameUploadSize = 1 << 20);
+	// Pipeline the boxes are drawn with (Color.hlsl). The null and software backends accept empty bytecode.
+	// Asynchronous creation returns right away, the boxes are drawn once the pipeline is ready.
+	bool CreatePipeline(const RhiShaderBytecode& vertexShader, const RhiShaderBytecode& pixelShader, bool isAsync = false);
+
+	// FRAME
+	// Only blocks if the GPU still uses the frame recorded framesInFlight frames ago
+	void Draw(const RenderSnapshot& snapshot);
+	// Waits until the GPU completed every command submitted so far
+	void Flush();
+
+	// UPLOAD
+	// Upload memory for the frame being recorded, from any thread, only valid until the end of
+	// that frame. alignment must be a power of two <= UploadRing::MAX_ALIGNMENT.
+	// Returns false when the ring is full.
+	bool AllocateFrameUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation);
+
+	// Adds a box per collider of the world
+	static void CaptureColliders(const PhysicsWorld& world, RenderSnapshot& snapshot);
+
+	// SETTER / GETTER
+	RhiDevice* GetDevice() { return m_pDevice; }
+	const FrameRing& GetFrameRing() const { return m_frameRing; }
+	const UploadRing& GetUploadRing() const { return m_uploadRing; }
+	PipelineCache& GetPipelineCache() { return m_pipelineCache; }
+	// Draw calls and state changes of the last frame, read it on the thread calling Draw
+	const RenderQueueStats& GetQueueStats() const { return m_queueStats; }
+	// Command lists recorded in parallel by the last frame
+	int GetRecordedListCount() const { return m_recordedListCount; }
+
+private:
+	void QueueBoxes(const RenderSnapshot& snapshot, RhiPipeline* pPipeline);
+	// Records batches [firstBatch, endBatch) on list index, with the render pass flags of its position
+	void RecordList(int index, int firstBatch, int endBatch, const float clearColor[4], const UploadAllocation& constants);
+
+private:
+	RhiDevice* m_pDevice = nullptr;
+	RhiSwapChain* m_pSwapChain = nullptr;
+	JobSystem* m_pJobSystem = nullptr;
+
+	// RECORDING
+	// One per worker, MAX_COMMAND_LISTS at most
+	std::vector<RhiCommandList*> m_commandLists;
+	int m_recordedListCount = 0;
+	// Ranges of batches, m_rangeBegins[i] to m_rangeBegins[i + 1]
+	int m_rangeBegins[MAX_COMMAND_LISTS + 1];
+	RenderQueueStats m_listStats[MAX_COMMAND_LISTS];
+	RenderQueueStats m_queueStats;
+
+	// SCENE
+	RenderQueue m_renderQueue;
+	PipelineCache m_pipelineCache;
+	// Of the box pipeline in m_pipelineCache, 0 before CreatePipeline
+	uint64_t m_pipelineKey = 0;
+	// White, tinted per instance so every box is one instanced draw
+	Mesh* m_pBoxMesh = nullptr;
+
+	// FRAMES IN FLIGHT
+	FrameRing m_frameRing;
+	// Slot of the frame being recorded, for the command list allocators
+	int m_currentFrameSlot = 0;
+	UploadRing m_uploadRing;
+};
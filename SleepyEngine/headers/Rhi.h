@@ -0,0 +1,229 @@
+#pragma once
+// Render hardware interface. Only std on purpose: the null backend and everything recording
+// through these interfaces also builds without D3D12.
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FrameRing.h"
+
+enum class RhiBackend : uint8_t
+{
+	D3D12,
+	// Validates and counts the calls, draws nothing
+	Null,
+	// Rasterizes on the CPU
+	Software,
+};
+
+enum class RhiHeapType : uint8_t
+{
+	// GPU memory, filled by copies
+	Default,
+	// CPU writable, read by the GPU through the bus, can stay mapped
+	Upload,
+};
+
+struct RhiBufferDesc
+{
+	uint64_t Size = 0;
+	RhiHeapType HeapType = RhiHeapType::Upload;
+};
+
+// Compiled shader, only read while the pipeline is created
+struct RhiShaderBytecode
+{
+	const void* pData = nullptr;
+	size_t Size = 0;
+};
+
+// Pipelines use the vertex layout of Color.hlsl (float3 POSITION, float4 COLOR), triangle lists,
+// and one root constant buffer per slot
+struct RhiPipelineDesc
+{
+	RhiShaderBytecode VertexShader;
+	RhiShaderBytecode PixelShader;
+	int ConstantBufferCount = 1;
+	bool IsDepthTested = true;
+	// Driver blob of the same pipeline from a previous run (RhiPipeline::GetCachedBlob), skips the
+	// driver compilation. Ignored when it does not match this device or driver.
+	RhiShaderBytecode CachedBlob;
+};
+
+struct RhiSwapChainDesc
+{
+	// HWND with the D3D12 backend, ignored by the null backend
+	void* pWindow = nullptr;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	int BufferCount = 2;
+};
+
+struct RhiViewport
+{
+	float X = 0.0f;
+	float Y = 0.0f;
+	float Width = 0.0f;
+	float Height = 0.0f;
+	float MinDepth = 0.0f;
+	float MaxDepth = 1.0f;
+};
+
+// Calls recorded by a command list, added to the device stats when it is submitted
+struct RhiStats
+{
+	uint64_t CommandLists = 0;
+	uint64_t RenderPasses = 0;
+	uint64_t DrawCalls = 0;
+	uint64_t Instances = 0;
+	uint64_t Triangles = 0;
+	uint64_t PipelineChanges = 0;
+	uint64_t BufferBindings = 0;
+	// Only counted by the null backend
+	uint64_t ValidationErrors = 0;
+
+	void Add(const RhiStats& stats);
+};
+
+class RhiSwapChain;
+
+class RhiBuffer
+{
+public:
+	virtual ~RhiBuffer() {};
+
+	// nullptr for default heap buffers
+	virtual void* Map() = 0;
+	virtual void Unmap() = 0;
+	virtual uint64_t GetGpuAddress() const = 0;
+
+	const RhiBufferDesc& GetDesc() const { return m_desc; }
+
+protected:
+	RhiBufferDesc m_desc;
+};
+
+class RhiPipeline
+{
+public:
+	RhiPipeline();
+	virtual ~RhiPipeline() {};
+
+	const RhiPipelineDesc& GetDesc() const { return m_desc; }
+	// Small id for sort keys. It wraps, two pipelines sharing one only sort less well.
+	uint32_t GetSortId() const { return m_sortId; }
+	// What the driver compiled, to give back as RhiPipelineDesc::CachedBlob. False when the backend has none.
+	virtual bool GetCachedBlob(std::vector<uint8_t>& /*blob*/) const { return false; }
+	// The CachedBlob of the description was used
+	bool IsFromCachedBlob() const { return m_isFromCachedBlob; }
+
+protected:
+	RhiPipelineDesc m_desc;
+	bool m_isFromCachedBlob = false;
+
+private:
+	uint32_t m_sortId;
+};
+
+// Records the commands of one thread. Each frame slot of the FrameRing gets its own memory,
+// so a list can be recorded again as soon as BeginFrame returned the slot.
+class RhiCommandList
+{
+public:
+	virtual ~RhiCommandList() {};
+
+	// RECORDING
+	// frameSlot must not be in use by the GPU anymore
+	virtual void Begin(int frameSlot) = 0;
+	virtual void End() = 0;
+
+	// Binds the current back buffer and the depth buffer, clears them. A resumed pass continues
+	// the one the previous list of the submission suspended: nothing is cleared (clearColor can
+	// be nullptr), so a pass can be recorded on several lists in parallel.
+	virtual void BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed = false) = 0;
+	// Makes the back buffer presentable, unless the pass is suspended for the next list
+	virtual void EndRenderPass(bool isSuspended = false) = 0;
+
+	// Also sets the scissor rect to the viewport
+	virtual void SetViewport(const RhiViewport& viewport) = 0;
+	virtual void SetPipeline(RhiPipeline* pPipeline) = 0;
+	virtual void SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride) = 0;
+	// 32 bit indices
+	virtual void SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset) = 0;
+	virtual void SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset) = 0;
+	virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex) = 0;
+
+	// SETTER / GETTER
+	// Calls recorded since Begin
+	const RhiStats& GetStats() const { return m_stats; }
+
+protected:
+	RhiStats m_stats;
+};
+
+// Executes command lists in submission order. The fence values it signals are the ones the
+// FrameRing waits on.
+class RhiQueue : public FenceTimeline
+{
+public:
+	virtual ~RhiQueue() {};
+
+	// The lists must be ended, they execute in array order
+	virtual void Submit(RhiCommandList* const* ppCommandLists, int count) = 0;
+	void Submit(RhiCommandList* pCommandList) { Submit(&pCommandList, 1); }
+};
+
+class RhiSwapChain
+{
+public:
+	virtual ~RhiSwapChain() {};
+
+	virtual void Present(bool isVSynced) = 0;
+	virtual int GetBackBufferIndex() const = 0;
+
+	// SETTER / GETTER
+	const RhiSwapChainDesc& GetDesc() const { return m_desc; }
+	uint64_t GetPresentCount() const { return m_presentCount; }
+
+protected:
+	RhiSwapChainDesc m_desc;
+	uint64_t m_presentCount = 0;
+};
+
+// Creates the resources of a backend. The caller owns and deletes what Create* returns,
+// after the GPU stopped using it.
+class RhiDevice
+{
+public:
+	virtual ~RhiDevice() {};
+
+	virtual RhiBackend GetBackend() const = 0;
+	virtual RhiQueue* GetQueue() = 0;
+
+	// CREATION
+	// Return nullptr when the backend rejects the description
+	virtual RhiBuffer* CreateBuffer(const RhiBufferDesc& desc) = 0;
+	virtual RhiPipeline* CreatePipeline(const RhiPipelineDesc& desc) = 0;
+	virtual RhiCommandList* CreateCommandList(int frameSlotCount) = 0;
+	virtual RhiSwapChain* CreateSwapChain(const RhiSwapChainDesc& desc) = 0;
+	// Hash of the state the backend fixes for every pipeline (input layout, blend, rasterizer,
+	// formats), part of the pipeline cache keys
+	virtual uint64_t GetPipelineStateHash() const { return 0; }
+
+	// Why the device stopped working, empty while it works
+	virtual std::string GetErrorReason() { return ""; }
+
+	// SETTER / GETTER
+	// Calls of every list submitted so far
+	const RhiStats& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats = RhiStats(); }
+
+protected:
+	RhiStats m_stats;
+};
+
+class JobSystem;
+
+// nullptr when the backend is not available on this platform.
+// The software backend rasterizes on pJobSystem when given.
+RhiDevice* CreateRhiDevice(RhiBackend backend, JobSystem* pJobSystem = nullptr);
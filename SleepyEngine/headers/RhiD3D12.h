@@ -0,0 +1,316 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+#include "Rhi.h"
+#include "GpuHeapAllocator.h"
+#include "DescriptorAllocator.h"
+
+class RhiD3D12Device;
+
+// Either a committed resource of its own, or a range of the buffer covering a heap
+class RhiD3D12Buffer : public RhiBuffer
+{
+public:
+	RhiD3D12Buffer(const RhiBufferDesc& desc, ID3D12Resource* pResource);
+	// pMappedData is the start of the range for upload heaps, nullptr otherwise
+	RhiD3D12Buffer(const RhiBufferDesc& desc, ID3D12Resource* pHeapBuffer, void* pMappedData, GpuHeapAllocator* pAllocator, const GpuHeapAllocation& allocation);
+	~RhiD3D12Buffer();
+
+	void* Map() override;
+	void Unmap() override;
+	uint64_t GetGpuAddress() const override { return m_pResource->GetGPUVirtualAddress() + m_allocation.Offset; }
+
+	// Shared with other buffers when sub-allocated, see GetOffset
+	ID3D12Resource* GetResource() const { return m_pResource; }
+	uint64_t GetOffset() const { return m_allocation.Offset; }
+
+private:
+	ID3D12Resource* m_pResource;
+	// Upload buffers stay mapped from the first Map until they are destroyed
+	void* m_pMappedData = nullptr;
+	// nullptr for committed resources
+	GpuHeapAllocator* m_pAllocator = nullptr;
+	GpuHeapAllocation m_allocation;
+};
+
+// D3D12 heaps of a GpuHeapAllocator. Each one is covered by a single placed buffer, the
+// sub-allocations are ranges of it: placed buffers are 64 KB aligned, ranges only 256 bytes.
+class RhiD3D12HeapSource : public GpuHeapSource
+{
+public:
+	// Fixed, so buffers can read heaps while another thread creates one
+	static const int MAX_HEAP_COUNT = 64;
+
+	RhiD3D12HeapSource(ID3D12Device* pDevice, D3D12_HEAP_TYPE heapType);
+	~RhiD3D12HeapSource() {};
+
+	bool CreateHeap(int heapIndex, uint64_t size) override;
+	void DestroyHeap(int heapIndex) override;
+
+	// SETTER / GETTER
+	ID3D12Resource* GetBuffer(int heapIndex) const { return m_heaps[heapIndex].pBuffer; }
+	// Upload heaps stay mapped, nullptr for default heaps
+	uint8_t* GetMappedData(int heapIndex) const { return m_heaps[heapIndex].pMappedData; }
+
+private:
+	struct Heap
+	{
+		ID3D12Heap* pHeap = nullptr;
+		ID3D12Resource* pBuffer = nullptr;
+		uint8_t* pMappedData = nullptr;
+	};
+
+	ID3D12Device* m_pDevice;
+	D3D12_HEAP_TYPE m_heapType;
+	Heap m_heaps[MAX_HEAP_COUNT];
+};
+
+// Holds a reference on its root signature, which is shared by the pipelines with the same one
+class RhiD3D12Pipeline : public RhiPipeline
+{
+public:
+	RhiD3D12Pipeline(const RhiPipelineDesc& desc, ID3D12RootSignature* pRootSignature, ID3D12PipelineState* pPipelineState, bool isFromCachedBlob);
+	~RhiD3D12Pipeline();
+
+	bool GetCachedBlob(std::vector<uint8_t>& blob) const override;
+
+	ID3D12RootSignature* GetRootSignature() const { return m_pRootSignature; }
+	ID3D12PipelineState* GetPipelineState() const { return m_pPipelineState; }
+
+private:
+	ID3D12RootSignature* m_pRootSignature;
+	ID3D12PipelineState* m_pPipelineState;
+};
+
+// Descriptors of one heap type. Persistent descriptors are written in a CPU only staging heap,
+// where they can be created and read back cheaply. With a transient count (CBV/SRV/UAV), a shader
+// visible heap holds the tables of each frame: ranges of it are allocated per frame and filled by
+// staged copies from persistent descriptors, batched into one CopyDescriptors call per flush.
+class RhiD3D12DescriptorHeap
+{
+public:
+	RhiD3D12DescriptorHeap();
+	~RhiD3D12DescriptorHeap();
+
+	// INIT
+	void Init(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistentCount, uint32_t transientCount);
+
+	// PERSISTENT
+	// Thread safe, DescriptorAllocator::INVALID_DESCRIPTOR when the heap is full
+	uint32_t AllocatePersistent() { return m_allocator.AllocatePersistent(); }
+	// The GPU only reads copies, but staged copies read the descriptor at FlushCopies: while
+	// some are staged the free is deferred to the next flush
+	void FreePersistent(uint32_t descriptor);
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32_t persistent) const;
+
+	// TRANSIENT
+	// Thread safe, count contiguous shader visible descriptors valid until the frame is retired
+	uint32_t AllocateTransient(uint32_t count) { return m_allocator.AllocateTransient(count); }
+	// Thread safe, copies count persistent descriptors to transient ones at the next flush
+	void StageCopies(uint32_t firstTransient, const uint32_t* pPersistent, uint32_t count);
+	// Executes the staged copies, before submitting lists which read them
+	void FlushCopies();
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(uint32_t transient) const;
+	ID3D12DescriptorHeap* GetShaderVisibleHeap() const { return m_pShaderVisibleHeap; }
+
+	// FRAME
+	// Called by the queue on each signal
+	void Retire(uint64_t completedFenceValue) { m_allocator.Retire(completedFenceValue); }
+	void EndFrame(uint64_t fenceValue) { m_allocator.EndFrame(fenceValue); }
+
+	// SETTER / GETTER
+	DescriptorStats GetStats() const { return m_allocator.GetStats(); }
+
+private:
+	ID3D12Device* m_pDevice = nullptr;
+	D3D12_DESCRIPTOR_HEAP_TYPE m_type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	UINT m_descriptorSize = 0;
+	ID3D12DescriptorHeap* m_pStagingHeap = nullptr;
+	ID3D12DescriptorHeap* m_pShaderVisibleHeap = nullptr;
+	DescriptorAllocator m_allocator;
+
+	// Staged copies, destination and source
+	struct DescriptorCopy
+	{
+		uint32_t Transient;
+		uint32_t Persistent;
+	};
+	std::mutex m_copyMutex;
+	std::vector<DescriptorCopy> m_stagedCopies;
+	// Persistent descriptors freed while copies were staged
+	std::vector<uint32_t> m_deferredFrees;
+	// Ranges of the last flush, kept to stop allocating
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_destinationStarts;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_sourceStarts;
+	std::vector<UINT> m_rangeSizes;
+};
+
+// Back buffers with their render target views, and a depth buffer
+class RhiD3D12SwapChain : public RhiSwapChain
+{
+public:
+	static const DXGI_FORMAT BACK_BUFFER_FORMAT = DXGI_FORMAT_R8G8B8A8_UNORM;
+	static const DXGI_FORMAT DEPTH_STENCIL_FORMAT = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	static const int MAX_BUFFER_COUNT = 3;
+
+	RhiD3D12SwapChain();
+	~RhiD3D12SwapChain();
+
+	// INIT
+	void Init(RhiD3D12Device* pDevice, const RhiSwapChainDesc& desc);
+
+	void Present(bool isVSynced) override;
+	int GetBackBufferIndex() const override { return m_backBufferIndex; }
+
+	// SETTER / GETTER
+	ID3D12Resource* GetCurrentBackBuffer() const { return m_pBuffers[m_backBufferIndex]; }
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentBackBufferView() const;
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView() const;
+
+private:
+	void CreateRenderTargetViews(ID3D12Device* pDevice);
+	void CreateDepthStencilView(ID3D12Device* pDevice);
+
+private:
+	RhiD3D12Device* m_pDevice = nullptr;
+	IDXGISwapChain* m_pSwapChain = nullptr;
+	ID3D12Resource* m_pBuffers[MAX_BUFFER_COUNT] = { nullptr, nullptr, nullptr };
+	int m_backBufferIndex = 0;
+
+	// Persistent descriptors of the device heaps
+	uint32_t m_rtvDescriptors[MAX_BUFFER_COUNT] = { DescriptorAllocator::INVALID_DESCRIPTOR, DescriptorAllocator::INVALID_DESCRIPTOR, DescriptorAllocator::INVALID_DESCRIPTOR };
+	uint32_t m_dsvDescriptor = DescriptorAllocator::INVALID_DESCRIPTOR;
+
+	ID3D12Resource* m_pDepthStencilBuffer = nullptr;
+};
+
+// One graphics command list, with a command allocator per frame slot
+class RhiD3D12CommandList : public RhiCommandList
+{
+public:
+	RhiD3D12CommandList();
+	~RhiD3D12CommandList();
+
+	// INIT
+	// pDescriptorHeap is bound at Begin, its tables can be used by any draw
+	void Init(ID3D12Device* pDevice, int frameSlotCount, ID3D12DescriptorHeap* pDescriptorHeap);
+
+	void Begin(int frameSlot) override;
+	void End() override;
+	void BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed) override;
+	void EndRenderPass(bool isSuspended) override;
+	void SetViewport(const RhiViewport& viewport) override;
+	void SetPipeline(RhiPipeline* pPipeline) override;
+	void SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride) override;
+	void SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset) override;
+	void SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex) override;
+
+	// SETTER / GETTER
+	ID3D12GraphicsCommandList* GetCommandList() const { return m_pCommandList; }
+
+private:
+	std::vector<ID3D12CommandAllocator*> m_allocators;
+	ID3D12GraphicsCommandList* m_pCommandList = nullptr;
+	ID3D12DescriptorHeap* m_pDescriptorHeap = nullptr;
+	// Transitioned back to present by EndRenderPass
+	RhiD3D12SwapChain* m_pRenderPassSwapChain = nullptr;
+	RhiPipeline* m_pPipeline = nullptr;
+};
+
+// Direct command queue and its fence
+class RhiD3D12Queue : public RhiQueue
+{
+public:
+	RhiD3D12Queue();
+	~RhiD3D12Queue();
+
+	// INIT
+	void Init(RhiD3D12Device* pDevice);
+
+	using RhiQueue::Submit;
+	void Submit(RhiCommandList* const* ppCommandLists, int count) override;
+
+	uint64_t Signal() override;
+	uint64_t GetCompletedValue() override;
+	void WaitFor(uint64_t value) override;
+
+	// SETTER / GETTER
+	ID3D12CommandQueue* GetCommandQueue() const { return m_pCommandQueue; }
+
+private:
+	RhiD3D12Device* m_pDevice = nullptr;
+	ID3D12CommandQueue* m_pCommandQueue = nullptr;
+	ID3D12Fence* m_pFence = nullptr;
+	uint64_t m_lastSignaledValue = 0;
+	// Created once, not for every wait
+	HANDLE m_eventHandle = nullptr;
+	// Reused by every submission
+	std::vector<ID3D12CommandList*> m_commandLists;
+};
+
+// Backend over D3D12, errors are thrown as HResultException
+class RhiD3D12Device : public RhiDevice
+{
+public:
+	RhiD3D12Device();
+	~RhiD3D12Device();
+
+	// INIT
+	void Init();
+
+	RhiBackend GetBackend() const override { return RhiBackend::D3D12; }
+	RhiQueue* GetQueue() override { return &m_queue; }
+
+	// CREATION
+	RhiBuffer* CreateBuffer(const RhiBufferDesc& desc) override;
+	RhiPipeline* CreatePipeline(const RhiPipelineDesc& desc) override;
+	RhiCommandList* CreateCommandList(int frameSlotCount) override;
+	RhiSwapChain* CreateSwapChain(const RhiSwapChainDesc& desc) override;
+	uint64_t GetPipelineStateHash() const override { return m_pipelineStateHash; }
+
+	std::string GetErrorReason() override;
+
+	// SETTER / GETTER
+	ID3D12Device* GetDevice() const { return m_pDevice; }
+	IDXGIFactory4* GetDxgiFactory() const { return m_pDxgiFactory; }
+	// Per heap usage and fragmentation
+	const GpuHeapAllocator* GetHeapAllocator(RhiHeapType heapType) const { return m_pHeapAllocators[(int)heapType]; }
+	// Persistent and transient descriptors, with their churn stats
+	RhiD3D12DescriptorHeap* GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) { return m_pDescriptorHeaps[type]; }
+
+private:
+	friend class RhiD3D12Queue;
+
+	void EnableAdditionalD3D12Debug();
+	// Everything but the shaders and the root signature comes from the backend, see GetPipelineStateHash
+	void FillPipelineStateDesc(const RhiPipelineDesc& desc, ID3D12RootSignature* pRootSignature, D3D12_GRAPHICS_PIPELINE_STATE_DESC& psoDesc) const;
+	// Shared by the pipelines with the same root parameters, one more reference for the caller.
+	// nullptr when it can't be serialized or created.
+	ID3D12RootSignature* GetRootSignature(int constantBufferCount);
+
+private:
+	// Buffers from this size on get a committed resource of their own
+	static const uint64_t DEDICATED_BUFFER_SIZE = 16 << 20;
+	static const uint64_t HEAP_SIZE = 64 << 20;
+	static const uint32_t PERSISTENT_CBV_SRV_UAV_COUNT = 4096;
+	static const uint32_t TRANSIENT_CBV_SRV_UAV_COUNT = 16384;
+	static const uint32_t RTV_COUNT = 64;
+	static const uint32_t DSV_COUNT = 16;
+
+	IDXGIFactory4* m_pDxgiFactory = nullptr;
+	ID3D12Device* m_pDevice = nullptr;
+	RhiD3D12Queue m_queue;
+
+	// Indexed by RhiHeapType
+	RhiD3D12HeapSource* m_pHeapSources[2] = {};
+	GpuHeapAllocator* m_pHeapAllocators[2] = {};
+	// Indexed by D3D12_DESCRIPTOR_HEAP_TYPE, no samplers yet
+	RhiD3D12DescriptorHeap* m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] = {};
+
+	// PIPELINES
+	uint64_t m_pipelineStateHash = 0;
+	// By hash of the root signature description, pipelines may be created from several threads
+	std::mutex m_rootSignatureMutex;
+	std::unordered_map<uint64_t, ID3D12RootSignature*> m_rootSignatures;
+};
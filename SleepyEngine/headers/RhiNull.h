@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "Rhi.h"
+
+class RhiNullDevice;
+
+class RhiNullBuffer : public RhiBuffer
+{
+public:
+	RhiNullBuffer(const RhiBufferDesc& desc, uint64_t gpuAddress);
+	~RhiNullBuffer() {};
+
+	void* Map() override;
+	void Unmap() override {};
+	uint64_t GetGpuAddress() const override { return m_gpuAddress; }
+
+private:
+	std::vector<uint8_t> m_data;
+	uint64_t m_gpuAddress;
+};
+
+// Its cached blob is a fixed tag, to exercise pipeline caches without a driver
+class RhiNullPipeline : public RhiPipeline
+{
+public:
+	static const uint32_t CACHED_BLOB_TAG = 0x4C4C554E;
+
+	RhiNullPipeline(const RhiPipelineDesc& desc);
+	~RhiNullPipeline() {};
+
+	bool GetCachedBlob(std::vector<uint8_t>& blob) const override;
+};
+
+class RhiNullSwapChain : public RhiSwapChain
+{
+public:
+	RhiNullSwapChain(const RhiSwapChainDesc& desc) { m_desc = desc; }
+	~RhiNullSwapChain() {};
+
+	void Present(bool isVSynced) override;
+	int GetBackBufferIndex() const override { return m_backBufferIndex; }
+
+private:
+	int m_backBufferIndex = 0;
+};
+
+class RhiNullCommandList : public RhiCommandList
+{
+public:
+	RhiNullCommandList(RhiNullDevice* pDevice, int frameSlotCount);
+	~RhiNullCommandList() {};
+
+	void Begin(int frameSlot) override;
+	void End() override;
+	void BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed) override;
+	void EndRenderPass(bool isSuspended) override;
+	void SetViewport(const RhiViewport& viewport) override;
+	void SetPipeline(RhiPipeline* pPipeline) override;
+	void SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride) override;
+	void SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset) override;
+	void SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex) override;
+
+	// SETTER / GETTER
+	bool IsRecording() const { return m_isRecording; }
+	// Between End and the submission, a list must be recorded again before each submission
+	bool WasRecorded() const { return m_wasRecorded; }
+	// Checked against the submission order by the queue
+	bool IsFirstPassResumed() const { return m_isFirstPassResumed; }
+	bool IsLastPassSuspended() const { return m_isLastPassSuspended; }
+
+private:
+	friend class RhiNullQueue;
+
+	// Counts the error, returns false so calls can bail out with it
+	bool Fail(const char* call, const char* message);
+	bool CheckRecording(const char* call);
+
+private:
+	RhiNullDevice* m_pDevice;
+	int m_frameSlotCount;
+
+	bool m_isRecording = false;
+	bool m_wasRecorded = false;
+	bool m_isInRenderPass = false;
+	bool m_hasRenderPass = false;
+	bool m_isFirstPassResumed = false;
+	bool m_isLastPassSuspended = false;
+	bool m_hasViewport = false;
+	RhiPipeline* m_pPipeline = nullptr;
+	// Elements the bound buffers hold after their offset, 0 when unbound
+	uint64_t m_vertexCount = 0;
+	uint64_t m_indexCount = 0;
+	// Bit per bound constant buffer slot
+	uint32_t m_constantBufferMask = 0;
+};
+
+class RhiNullQueue : public RhiQueue
+{
+public:
+	RhiNullQueue(RhiNullDevice* pDevice) : m_pDevice(pDevice) {}
+	~RhiNullQueue() {};
+
+	using RhiQueue::Submit;
+	void Submit(RhiCommandList* const* ppCommandLists, int count) override;
+
+	// The work is done as soon as it is submitted
+	uint64_t Signal() override { return ++m_lastSignaledValue; }
+	uint64_t GetCompletedValue() override { return m_lastSignaledValue; }
+	void WaitFor(uint64_t /*value*/) override {};
+
+private:
+	RhiNullDevice* m_pDevice;
+	uint64_t m_lastSignaledValue = 0;
+};
+
+// Backend which draws nothing: calls are validated and counted, buffers live in CPU memory and
+// the fences complete as soon as they are signaled. Runs the whole frame loop without a GPU
+// (CPU benchmarks, soak tests, platforms without D3D12).
+class RhiNullDevice : public RhiDevice
+{
+public:
+	// Command lists only bind constant buffers at this alignment, like D3D12
+	static const uint64_t CONSTANT_BUFFER_ALIGNMENT = 256;
+	static const int MAX_CONSTANT_BUFFERS = 16;
+
+	RhiNullDevice();
+	~RhiNullDevice() {};
+
+	RhiBackend GetBackend() const override { return RhiBackend::Null; }
+	RhiQueue* GetQueue() override { return &m_queue; }
+
+	// CREATION
+	RhiBuffer* CreateBuffer(const RhiBufferDesc& desc) override;
+	RhiPipeline* CreatePipeline(const RhiPipelineDesc& desc) override;
+	RhiCommandList* CreateCommandList(int frameSlotCount) override;
+	RhiSwapChain* CreateSwapChain(const RhiSwapChainDesc& desc) override;
+
+	// VALIDATION
+	// Called from any recording thread, only keeps the message
+	void ReportError(const std::string& message);
+	std::string GetLastError();
+
+private:
+	friend class RhiNullQueue;
+
+	// Counts the error in the device stats and keeps the message
+	void Fail(const std::string& message);
+
+private:
+	RhiNullQueue m_queue;
+	// Fake addresses, never 0 so they cannot be mistaken for a null binding.
+	// Buffers and pipelines can be created from workers (PipelineCache), so is m_stats.
+	std::atomic<uint64_t> m_nextGpuAddress;
+	std::mutex m_statsMutex;
+
+	std::mutex m_errorMutex;
+	std::string m_lastError;
+};
@@ -0,0 +1,242 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "Rhi.h"
+
+class JobSystem;
+class RhiSoftwareDevice;
+
+class RhiSoftwareBuffer : public RhiBuffer
+{
+public:
+	RhiSoftwareBuffer(const RhiBufferDesc& desc, uint64_t gpuAddress);
+	~RhiSoftwareBuffer() {};
+
+	// nullptr for default heap buffers, like the other backends
+	void* Map() override;
+	void Unmap() override {};
+	uint64_t GetGpuAddress() const override { return m_gpuAddress; }
+
+	// What the rasterizer reads, whatever the heap type
+	const uint8_t* GetData() const { return m_data.data(); }
+
+private:
+	std::vector<uint8_t> m_data;
+	uint64_t m_gpuAddress;
+};
+
+// The bytecode is ignored: every pipeline runs Color.hlsl natively
+class RhiSoftwarePipeline : public RhiPipeline
+{
+public:
+	RhiSoftwarePipeline(const RhiPipelineDesc& desc);
+	~RhiSoftwarePipeline() {};
+};
+
+// RGBA8 back buffers (R in the lowest byte) and a D24S8 depth buffer, in CPU memory
+class RhiSoftwareSwapChain : public RhiSwapChain
+{
+public:
+	RhiSoftwareSwapChain(const RhiSwapChainDesc& desc);
+	~RhiSoftwareSwapChain() {};
+
+	void Present(bool isVSynced) override;
+	int GetBackBufferIndex() const override { return m_backBufferIndex; }
+
+	// SETTER / GETTER
+	uint32_t* GetBuffer(int index) { return m_buffers[index].data(); }
+	uint32_t* GetDepthBuffer() { return m_depthBuffer.data(); }
+	// Last presented buffer, nullptr before the first Present
+	const uint32_t* GetPresentedBuffer() const;
+
+	// Writes the last presented buffer
+	bool SavePng(const std::string& path) const;
+
+private:
+	std::vector<std::vector<uint32_t>> m_buffers;
+	// Depth in the low 24 bits, stencil (unused) in the high 8
+	std::vector<uint32_t> m_depthBuffer;
+	int m_backBufferIndex = 0;
+};
+
+// Records commands, they are executed when the list is submitted
+class RhiSoftwareCommandList : public RhiCommandList
+{
+public:
+	RhiSoftwareCommandList() {};
+	~RhiSoftwareCommandList() {};
+
+	void Begin(int frameSlot) override;
+	void End() override {};
+	void BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed) override;
+	void EndRenderPass(bool isSuspended) override {};
+	void SetViewport(const RhiViewport& viewport) override;
+	void SetPipeline(RhiPipeline* pPipeline) override;
+	void SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride) override;
+	void SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset) override;
+	void SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset) override;
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex) override;
+
+private:
+	friend class RhiSoftwareDevice;
+
+	// State captured by a draw call
+	struct Draw
+	{
+		RhiViewport Viewport;
+		const RhiSoftwarePipeline* pPipeline = nullptr;
+		const RhiSoftwareBuffer* pVertexBuffer = nullptr;
+		uint64_t VertexOffset = 0;
+		uint32_t VertexStride = 0;
+		const RhiSoftwareBuffer* pIndexBuffer = nullptr;
+		uint64_t IndexOffset = 0;
+		// gInstances
+		const RhiSoftwareBuffer* pConstantBuffer = nullptr;
+		uint64_t ConstantOffset = 0;
+		uint32_t IndexCount = 0;
+		uint32_t InstanceCount = 0;
+		uint32_t FirstIndex = 0;
+		int32_t BaseVertex = 0;
+	};
+
+	struct RenderPass
+	{
+		RhiSoftwareSwapChain* pSwapChain = nullptr;
+		int BackBufferIndex = 0;
+		float ClearColor[4];
+		// Resumed passes keep what the previous list drew
+		bool IsCleared = true;
+		int FirstDraw = 0;
+		int DrawCount = 0;
+	};
+
+	std::vector<RenderPass> m_renderPasses;
+	std::vector<Draw> m_draws;
+	// Current state, copied into each draw
+	Draw m_state;
+};
+
+// Executes submissions right away, so the fences complete as soon as they are signaled
+class RhiSoftwareQueue : public RhiQueue
+{
+public:
+	RhiSoftwareQueue(RhiSoftwareDevice* pDevice) : m_pDevice(pDevice) {}
+	~RhiSoftwareQueue() {};
+
+	using RhiQueue::Submit;
+	void Submit(RhiCommandList* const* ppCommandLists, int count) override;
+
+	uint64_t Signal() override { return ++m_lastSignaledValue; }
+	uint64_t GetCompletedValue() override { return m_lastSignaledValue; }
+	void WaitFor(uint64_t /*value*/) override {};
+
+private:
+	RhiSoftwareDevice* m_pDevice;
+	uint64_t m_lastSignaledValue = 0;
+};
+
+// What the rasterizer did since the last ResetRasterStats
+struct SoftwareRasterStats
+{
+	// Before clipping and culling, instances included
+	uint64_t TrianglesSubmitted = 0;
+	// Left after clipping and culling
+	uint64_t TrianglesRasterized = 0;
+	uint64_t PixelsWritten = 0;
+	// Wall clock time spent executing submissions
+	int64_t Ticks = 0;
+
+	double GetTrianglesPerSecond() const;
+};
+
+// CPU backend for pixels without a GPU (golden images, render farms). Runs the Color.hlsl
+// pipeline: the vertex stage transforms float3 positions by the WorldViewProj matrix of the instance
+// in constant buffer 0 (stored transposed, as HLSL reads it) and multiplies the float4 color by the
+// instance color, the pixel stage outputs the perspective corrected color. Back faces (counter clockwise) are culled and
+// the depth test is LESS against a 24 bit depth buffer.
+// Triangles of a render pass are set up, then binned into TILE_SIZE screen tiles which are
+// rasterized in parallel on the job system, 4 pixels at a time with SIMD edge functions.
+class RhiSoftwareDevice : public RhiDevice
+{
+public:
+	static const int TILE_SIZE = 64;
+	// InstanceData of Color.hlsl: float4x4 WorldViewProj, float4 Color
+	static const int INSTANCE_STRIDE = 80;
+
+	// pJobSystem can be nullptr to rasterize on the submitting thread
+	RhiSoftwareDevice(JobSystem* pJobSystem);
+	~RhiSoftwareDevice() {};
+
+	RhiBackend GetBackend() const override { return RhiBackend::Software; }
+	RhiQueue* GetQueue() override { return &m_queue; }
+
+	// CREATION
+	RhiBuffer* CreateBuffer(const RhiBufferDesc& desc) override;
+	RhiPipeline* CreatePipeline(const RhiPipelineDesc& desc) override;
+	RhiCommandList* CreateCommandList(int frameSlotCount) override;
+	RhiSwapChain* CreateSwapChain(const RhiSwapChainDesc& desc) override;
+
+	// SETTER / GETTER
+	const SoftwareRasterStats& GetRasterStats() const { return m_rasterStats; }
+	void ResetRasterStats() { m_rasterStats = SoftwareRasterStats(); }
+
+private:
+	friend class RhiSoftwareQueue;
+
+	// Screen space triangle ready to rasterize
+	struct Triangle
+	{
+		// Edge i is opposite to vertex i: E(x, y) = A * x + B * y + C, >= 0 inside
+		float EdgeA[3];
+		float EdgeB[3];
+		float EdgeC[3];
+		// Top-left fill rule: pixels exactly on the edge are only covered by top and left edges
+		bool IsTopLeft[3];
+		float InvArea;
+		float Z[3];
+		float InvW[3];
+		// Color divided by w, interpolated linearly in screen space
+		float ColorOverW[3][4];
+		// Inclusive pixel bounds, clamped to the viewport
+		int MinX;
+		int MinY;
+		int MaxX;
+		int MaxY;
+		bool IsDepthTested;
+	};
+
+	// Clip space vertex, output of the vertex stage
+	struct ClipVertex
+	{
+		float Position[4];
+		float Color[4];
+	};
+
+	void Execute(const RhiSoftwareCommandList& commandList);
+	void ExecuteRenderPass(const RhiSoftwareCommandList& commandList, const RhiSoftwareCommandList::RenderPass& renderPass);
+	// Transforms, clips and sets up one triangle of a draw, writes up to 2 triangles
+	int SetupTriangle(const RhiSoftwareCommandList::Draw& draw, uint32_t triangleIndex, Triangle* pOut) const;
+	int ClipAndProject(const ClipVertex vertices[3], const RhiViewport& viewport, bool isDepthTested, Triangle* pOut) const;
+	bool ProjectTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const RhiViewport& viewport, bool isDepthTested, Triangle& triangle) const;
+	// clearColor is nullptr to keep the tile
+	void RasterizeTile(int tileIndex, RhiSoftwareSwapChain* pSwapChain, int backBufferIndex, const float clearColor[4]);
+
+private:
+	RhiSoftwareQueue m_queue;
+	JobSystem* m_pJobSystem;
+	// Buffers can be created from any thread
+	std::atomic<uint64_t> m_nextGpuAddress;
+
+	// RENDER PASS SCRATCH
+	// Reused between passes, they stop allocating once the scene is stable
+	std::vector<Triangle> m_triangles;
+	// Triangles written by each setup range, 2 slots per source triangle
+	std::vector<uint8_t> m_triangleCounts;
+	// Triangle indices per tile, in submission order
+	std::vector<std::vector<uint32_t>> m_tileBins;
+	std::vector<uint64_t> m_tilePixels;
+	int m_tileCountX = 0;
+	int m_tileCountY = 0;
+
+	SoftwareRasterStats m_rasterStats;
+};
@@ -1,16 +1,37 @@
 #pragma once
+#include <vector>
 #include "Component.h"
+#include "ScriptTask.h"
+
+struct ContactEvent;
+class ScriptScheduler;
 
 class Script : public Component
 {
 public:
 	Script();
-	~Script() {};
+	~Script();
 
 	// INIT
 	void Init() override;
 
+	// CONTACTS
+	// Called once per physics step with every contact that began and ended during the step,
+	// when the script is registered with PhysicsWorld::AddContactListener
+	virtual void OnContacts(const std::vector<ContactEvent>& beginEvents, const std::vector<ContactEvent>& endEvents) {};
+
+	// COROUTINES
+	// Runs task until its first co_await, the scheduler resumes it from there.
+	// The script must be attached to a scheduler first (ScriptScheduler::Attach, SleepyEngine::AttachScript).
+	// The coroutines of a script are stopped with it.
+	void StartCoroutine(ScriptTask task);
+	void StopCoroutines();
+
+	// SETTER / GETTER
+	void SetScheduler(ScriptScheduler* pScheduler) { m_pScheduler = pScheduler; }
+	ScriptScheduler* GetScheduler() const { return m_pScheduler; }
+
 private:
+	ScriptScheduler* m_pScheduler = nullptr;
 
 };
-
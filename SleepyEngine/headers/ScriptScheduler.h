@@ -0,0 +1,83 @@
+#pragma once
+#include "ScriptTask.h"
+
+// Resumes the suspended script coroutines, once per frame from the Run loop.
+// Each kind of wait has its own queue which is processed as a batch: coroutines resumed by an
+// update and suspending again are only looked at on the next update.
+class ScriptScheduler
+{
+public:
+	ScriptScheduler();
+	// Destroys the suspended coroutines and detaches the scripts, which can outlive it
+	~ScriptScheduler();
+
+	// INIT
+	void Init();
+
+	// TASKS
+	// Coroutines started by the script run on this scheduler. Those already running on another one are stopped.
+	void Attach(Script* pScript);
+	// Called by ~Script, stops its coroutines
+	void Detach(Script* pScript);
+	// Runs the task until its first suspension. pOwner can be nullptr.
+	void Start(ScriptTask task, Script* pOwner);
+	// Stops every coroutine started for pOwner, their frames are destroyed on the next update
+	void StopAll(Script* pOwner);
+
+	// UPDATE
+	// time: total time of the frame (s)
+	void Update(double time);
+
+	// WAITS (used by the awaitables)
+	void WaitNextFrame(ScriptTask::Handle handle);
+	void WaitUntilTime(ScriptTask::Handle handle, double wakeTime);
+	void WaitUntil(ScriptTask::Handle handle, std::function<bool()> condition);
+	void WaitForJob(ScriptTask::Handle handle, JobCounter* pCounter);
+
+	// SETTER / GETTER
+	double GetTime() const { return m_time; }
+	// Started and not finished yet, stopped ones included until destroyed
+	int GetTaskCount() const { return m_taskCount; }
+
+private:
+	struct TimedWait
+	{
+		double WakeTime;
+		ScriptTask::Handle Handle;
+
+		// Min heap on the wake time
+		bool operator<(const TimedWait& other) const { return WakeTime > other.WakeTime; }
+	};
+
+	struct ConditionWait
+	{
+		std::function<bool()> Condition;
+		ScriptTask::Handle Handle;
+	};
+
+	struct JobWait
+	{
+		JobCounter* pCounter;
+		ScriptTask::Handle Handle;
+	};
+
+	// Resumes, or destroys if stopped or finished
+	void Resume(ScriptTask::Handle handle);
+	void Destroy(ScriptTask::Handle handle);
+	void ResumeBatch();
+
+private:
+	double m_time = 0.0;
+	int m_taskCount = 0;
+	std::vector<Script*> m_scripts;
+
+	std::vector<ScriptTask::Handle> m_nextFrameWaits;
+	std::vector<TimedWait> m_timedWaits;
+	std::vector<ConditionWait> m_conditionWaits;
+	std::vector<JobWait> m_jobWaits;
+
+	// Coroutines to resume in the current update, reused between updates
+	std::vector<ScriptTask::Handle> m_resumeBatch;
+	// Coroutine being resumed, it is in no queue
+	ScriptTask::Handle m_running;
+};
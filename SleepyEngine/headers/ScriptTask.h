@@ -0,0 +1,134 @@
+#pragma once
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ScriptScheduler;
+class Script;
+class JobCounter;
+
+// Recycles coroutine frames by size class instead of going through the heap for every coroutine.
+// Blocks are carved from chunks which are kept for reuse, so once warmed up starting and
+// finishing coroutines does not allocate. Frames must be freed on the thread which allocated them.
+class CoroutineFramePool
+{
+public:
+	static const size_t SIZE_CLASS = 64;
+	// Up to 1 KB, bigger frames use the heap
+	static const int CLASS_COUNT = 16;
+	static const size_t CHUNK_SIZE = 64 * 1024;
+
+	static void* Allocate(size_t size);
+	static void Free(void* pBlock, size_t size);
+
+	// SETTER / GETTER
+	static int GetLiveCount() { return t_pool.LiveCount; }
+	static size_t GetReservedBytes() { return t_pool.Chunks.size() * CHUNK_SIZE; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	struct Pool
+	{
+		FreeBlock* pFreeLists[CLASS_COUNT] = {};
+		std::vector<std::unique_ptr<char[]>> Chunks;
+		char* pChunkCursor = nullptr;
+		size_t ChunkLeft = 0;
+		int LiveCount = 0;
+	};
+
+	static thread_local Pool t_pool;
+};
+
+// Return type of script coroutines:
+//     ScriptTask Blink() { while (true) { co_await WaitForSeconds(0.5f); Toggle(); } }
+// A task does nothing until it is given to Script::StartCoroutine or ScriptScheduler::Start,
+// the scheduler owns it from there and destroys it when it finishes or is stopped.
+class ScriptTask
+{
+public:
+	struct promise_type
+	{
+		ScriptScheduler* pScheduler = nullptr;
+		Script* pOwner = nullptr;
+		// Stopped while suspended, destroyed instead of resumed
+		bool IsCancelled = false;
+
+		static void* operator new(size_t size) { return CoroutineFramePool::Allocate(size); }
+		static void operator delete(void* pFrame, size_t size) { CoroutineFramePool::Free(pFrame, size); }
+
+		ScriptTask get_return_object() { return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		// Suspended at the end so the scheduler sees done() and destroys it
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+	typedef std::coroutine_handle<promise_type> Handle;
+
+	ScriptTask() {}
+	ScriptTask(ScriptTask&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+	ScriptTask& operator=(ScriptTask&& other) noexcept;
+	ScriptTask(const ScriptTask&) = delete;
+	ScriptTask& operator=(const ScriptTask&) = delete;
+	// Only destroys tasks which were never started
+	~ScriptTask();
+
+	// Gives up ownership of the coroutine
+	Handle Release();
+
+private:
+	explicit ScriptTask(Handle handle) : m_handle(handle) {}
+
+	Handle m_handle;
+};
+
+// AWAITABLES
+
+// Resumes on the next scheduler update
+struct NextFrame
+{
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(ScriptTask::Handle handle);
+	void await_resume() const noexcept {}
+};
+
+// Resumes on the first scheduler update at least seconds later
+struct WaitForSeconds
+{
+	WaitForSeconds(float seconds) : Seconds(seconds) {}
+
+	bool await_ready() const noexcept { return Seconds <= 0.0f; }
+	void await_suspend(ScriptTask::Handle handle);
+	void await_resume() const noexcept {}
+
+	float Seconds;
+};
+
+// Checked once per scheduler update, resumes on the update where it returns true
+struct WaitUntil
+{
+	WaitUntil(std::function<bool()> condition) : Condition(std::move(condition)) {}
+
+	bool await_ready() const { return Condition(); }
+	void await_suspend(ScriptTask::Handle handle);
+	void await_resume() const noexcept {}
+
+	std::function<bool()> Condition;
+};
+
+// Resumes on the first scheduler update after every job of the counter finished
+struct WaitForJob
+{
+	WaitForJob(JobCounter& counter) : pCounter(&counter) {}
+
+	bool await_ready() const;
+	void await_suspend(ScriptTask::Handle handle);
+	void await_resume() const noexcept {}
+
+	JobCounter* pCounter;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderCompiler.h"
+#include "BlobCache.h"
+#include "Rhi.h"
+
+class JobSystem;
+
+struct CompiledShader
+{
+	// Empty when the shader failed to compile
+	std::vector<uint8_t> Bytecode;
+	// Compiler output of the shaders compiled by this run, nothing for cache hits
+	std::string Errors;
+	uint64_t Key = 0;
+	bool IsFromCache = false;
+
+	bool IsValid() const { return !Bytecode.empty(); }
+	RhiShaderBytecode GetBytecode() const { return { Bytecode.data(), Bytecode.size() }; }
+};
+
+struct ShaderCacheStats
+{
+	int Hits = 0;
+	int Compiled = 0;
+	int Failed = 0;
+};
+
+// On-disk cache of shader bytecode, keyed by a hash of what the bytecode depends on: the source,
+// the content of every file it includes (recursively), the defines, the entry point, the target
+// and the compiler version. The path itself is not part of the key, moving the shaders keeps the cache.
+// Each shader is a BlobCache file named after its key. Misses are compiled in parallel on the job
+// system, then written to the cache.
+class ShaderCache
+{
+public:
+	// Deeper includes are not followed, they do not change the key
+	static const int MAX_INCLUDE_DEPTH = 16;
+
+	ShaderCache();
+	~ShaderCache() {};
+
+	// INIT
+	// cacheDirectory is created if needed, empty to always compile.
+	// pJobSystem can be nullptr to compile on the calling thread.
+	bool Init(ShaderCompiler* pCompiler, const std::string& cacheDirectory, JobSystem* pJobSystem);
+
+	// Loads or compiles count shaders into pShaders. Shaders sharing a key are compiled once.
+	// Returns false if any of them failed.
+	bool Build(const ShaderDesc* pDescs, CompiledShader* pShaders, int count);
+
+	// 0 when the source can't be read
+	uint64_t ComputeKey(const ShaderDesc& desc) const;
+
+	// SETTER / GETTER
+	// Since Init, read it on the thread calling Build
+	const ShaderCacheStats& GetStats() const { return m_stats; }
+
+private:
+	// Adds the content of path and of its includes to hash, false if path can't be read
+	bool HashFile(const std::string& path, int depth, std::vector<std::string>& visited, uint64_t& hash) const;
+
+private:
+	ShaderCompiler* m_pCompiler = nullptr;
+	JobSystem* m_pJobSystem = nullptr;
+	BlobCache m_blobCache;
+	ShaderCacheStats m_stats;
+};
@@ -0,0 +1,33 @@
+#pragma once
+// Only std: the cache and its tests run without Windows, with a stub compiler
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ShaderDefine
+{
+	std::string Name;
+	std::string Value;
+};
+
+// One entry point of an HLSL file
+struct ShaderDesc
+{
+	std::string Path;
+	std::string EntryPoint;
+	// Profile, "vs_5_0"
+	std::string Target;
+	std::vector<ShaderDefine> Defines;
+};
+
+// Turns HLSL into bytecode. Implementations are called from several worker threads at once.
+class ShaderCompiler
+{
+public:
+	virtual ~ShaderCompiler() {};
+
+	// Reads desc.Path and its includes itself. errors gets the compiler output, warnings included.
+	virtual bool Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) = 0;
+	// Part of every cache key: another compiler or other flags invalidate the cached bytecode
+	virtual std::string GetVersion() const = 0;
+};
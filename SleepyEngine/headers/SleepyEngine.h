@@ -12,81 +12,126 @@
 
 #include <DirectXColors.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "RenderSnapshot.h"
+#include "SnapshotChannel.h"
+#include "Rhi.h"
+
 #include <DXGI.h>
 
 #define MAX_LOADSTRING 100
 #define SWAP_CHAIN_BUFFER_COUNT 2
 
+class PhysicsWorld;
+class FrameStats;
+class JobSystem;
+class Renderer;
+class ScriptScheduler;
+class Script;
+class Input;
+class ActionMap;
+
 class SleepyEngine
 {
 public:
     SleepyEngine(HINSTANCE hInstance);
+    ~SleepyEngine();
     int Initialize();
     int Run();
+
+    // SETTER / GETTER
+    PhysicsWorld* GetPhysicsWorld() { return m_pPhysicsWorld; }
+    FrameStats* GetFrameStats() { return m_pFrameStats; }
+    JobSystem* GetJobSystem() { return m_pJobSystem; }
+    ScriptScheduler* GetScriptScheduler() { return m_pScriptScheduler; }
+    // Lets the script start coroutines, resumed by the Run loop. Call after Initialize.
+    void AttachScript(Script* pScript);
+    Input* GetInput() { return m_pInput; }
+    ActionMap* GetActionMap() { return m_pActionMap; }
+    // <= 0 to draw as fast as possible, applied when Run starts
+    void SetTargetFrameRate(double targetFrameRate) { m_targetFrameRate = targetFrameRate; }
+    // Pipelined: a render thread draws frame N while Run simulates frame N+1.
+    // Otherwise each frame is simulated then drawn on the main thread. Applied when Run starts.
+    void SetPipelined(bool isPipelined) { m_isPipelined = isPipelined; }
+    void SetClearColor(const DirectX::XMFLOAT4& clearColor) { m_clearColor = clearColor; }
+    // Frames the CPU can record ahead of the GPU (1 to 3), applied by Initialize
+    void SetFramesInFlight(int framesInFlight) { m_framesInFlight = framesInFlight; }
+    // > 0 samples input on a dedicated thread at this rate (Hz) instead of using window messages.
+    // Applied when Run starts.
+    void SetInputSamplingRate(double sampleRate) { m_inputSamplingRate = sampleRate; }
+    // Non empty: Run records the input events and timer deltas of every frame to this file,
+    // for HeadlessRunner to replay
+    void SetInputRecordPath(const std::string& path) { m_inputRecordPath = path; }
+
+    // Backend created by Initialize, D3D12 by default. The null backend draws nothing,
+    // the software one rasterizes on the job system.
+    void SetRenderBackend(RhiBackend backend) { m_renderBackend = backend; }
+    RhiDevice* GetRhiDevice() { return m_pRhiDevice; }
+    Renderer* GetRenderer() { return m_pRenderer; }
 private:
     void InitWindow(int nCmdShow);
     ATOM RegisterWindowClass();
 
-    // D3DX12 Initialization
-    void InitD3D();
-    void EnableAdditionalD3D12Debug();
-    void CreateDevice();
-    void CreateFence();
-    void RecoverDescriptorsSize();
-    void Check4xMSAAQualitySupport();
-    void CreateCommandObjects();
-    void CreateSwapChain();
-    void CreateDescriptorHeaps();
-    void CreateRenderTargetView();
-    void CreateDepthStencilView();
-    void SetViewport();
-    void SetScissorRect();
+    // Creates the RHI device, the swap chain of the window and the renderer
+    void InitRenderer();
 
     void FlushCommandQueue();
-    void Draw();
+    void Draw(const RenderSnapshot& snapshot);
+
+    // FRAME PIPELINE
+    // Copies the simulation state the renderer needs
+    void BuildSnapshot(RenderSnapshot& snapshot, double time, float alpha);
+    void PublishSnapshot();
+    void StartRenderThread();
+    void StopRenderThread();
+    void RenderThreadMain();
 
-    // GETTERS / SETTERS
-    D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentBackBufferView()const;
-    D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView()const;
-    ID3D12Resource* GetCurrentBackBuffer()const;
 private:
     WCHAR m_szTitle[MAX_LOADSTRING];                  // The title bar text
     WCHAR m_szWindowClass[MAX_LOADSTRING];            // the main window class name
 
-    ID3D12Device* m_pDevice = nullptr;
-
-    ID3D12Fence* m_pFence = nullptr;
-    UINT64 m_currentFence = 0;
-
-    UINT m_rtvDescriptorSize = 0;
-    UINT m_dsvDescriptorSize = 0;
-    UINT m_cbvSrvUavDescriptorSize = 0;
+    // RENDERING
+    RhiBackend m_renderBackend = RhiBackend::D3D12;
+    RhiDevice* m_pRhiDevice = nullptr;
+    RhiSwapChain* m_pSwapChain = nullptr;
+    Renderer* m_pRenderer = nullptr;
+    // Frames the CPU can record ahead of the GPU
+    int m_framesInFlight = 3;
 
-    ID3D12DescriptorHeap* m_pRtvHeap = nullptr;
-    ID3D12DescriptorHeap* m_pDsvHeap = nullptr;
-
-    DXGI_FORMAT m_backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    int m_currentBackBufferOffset = 0;
+    int m_clientWidth = 640;
+    int m_clientHeight = 480;
 
-    D3D12_VIEWPORT* m_pViewPort = new D3D12_VIEWPORT();
+    PhysicsWorld* m_pPhysicsWorld = nullptr;
 
-    UINT m_4xMsaaQuality = 0;
-    bool m_4xMsaaState = false;
+    FrameStats* m_pFrameStats = nullptr;
 
-    ID3D12Resource* m_pDepthStencilBuffer = nullptr;
+    JobSystem* m_pJobSystem = nullptr;
 
-    ID3D12CommandQueue* m_pCommandQueue = nullptr;
-    ID3D12CommandAllocator* m_pDirectCmdListAlloc = nullptr;
-    ID3D12GraphicsCommandList* m_pCommandList = nullptr;
+    ScriptScheduler* m_pScriptScheduler = nullptr;
 
-    IDXGIFactory4* m_pDxgiFactory = nullptr;
-    IDXGISwapChain* m_pSwapChain = nullptr;
-    ID3D12Resource* m_pSwapChainBuffer[SWAP_CHAIN_BUFFER_COUNT] = {nullptr, nullptr};
+    // Fed by the WndProc, which finds the engine through the window user data
+    Input* m_pInput = nullptr;
+    double m_inputSamplingRate = 0.0;
+    std::string m_inputRecordPath;
+    // Evaluated right after the input update
+    ActionMap* m_pActionMap = nullptr;
 
-    int m_clientWidth = 640;
-    int m_clientHeight = 480;
+    double m_targetFrameRate = 60.0;
 
-    tagRECT m_scissorRect;
+    // FRAME PIPELINE
+    bool m_isPipelined = true;
+    uint64_t m_frameIndex = 0;
+    DirectX::XMFLOAT4 m_clearColor = { 0.690196097f, 0.768627524f, 0.870588303f, 1.0f }; // LightSteelBlue
+    SnapshotChannel<RenderSnapshot> m_snapshotChannel;
+    std::thread m_renderThread;
+    std::atomic<bool> m_isRenderThreadRunning{ false };
+    // Only used to sleep the render thread until a snapshot is published
+    std::mutex m_snapshotMutex;
+    std::condition_variable m_snapshotCondition;
 
     HWND mhMainWnd = nullptr;
     HINSTANCE m_hAppInstance = nullptr;
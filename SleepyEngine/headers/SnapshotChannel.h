@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer.
+// The producer fills the write slot then publishes it, the consumer acquires the most recent
+// published slot. Each side owns one slot and the third one is exchanged through a single atomic,
+// so neither side ever waits for the other. Snapshots the consumer was too slow to take are skipped.
+template<typename T>
+class SnapshotChannel
+{
+public:
+	SnapshotChannel() : m_writeIndex(0), m_readIndex(1), m_shared(2), m_publishedCount(0), m_skippedCount(0) {}
+
+	// PRODUCER
+	T& GetWriteSlot() { return m_slots[m_writeIndex]; }
+	// Hands the write slot to the consumer and takes back the shared one
+	void Publish()
+	{
+		int previous = m_shared.exchange(m_writeIndex | NEW_FLAG, std::memory_order_acq_rel);
+		if (previous & NEW_FLAG)
+			m_skippedCount.fetch_add(1, std::memory_order_relaxed);
+		m_writeIndex = previous & INDEX_MASK;
+		m_publishedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// CONSUMER
+	bool HasNew() const { return (m_shared.load(std::memory_order_acquire) & NEW_FLAG) != 0; }
+	// Returns the latest published slot, or nullptr when nothing was published since the last call.
+	// The slot stays valid until the next successful Acquire.
+	const T* Acquire()
+	{
+		if (!HasNew())
+			return nullptr;
+
+		int previous = m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+		m_readIndex = previous & INDEX_MASK;
+		return &m_slots[m_readIndex];
+	}
+
+	// SETTER / GETTER
+	uint64_t GetPublishedCount() const { return m_publishedCount.load(std::memory_order_relaxed); }
+	uint64_t GetSkippedCount() const { return m_skippedCount.load(std::memory_order_relaxed); }
+
+private:
+	static const int INDEX_MASK = 3;
+	static const int NEW_FLAG = 4;
+
+	T m_slots[3];
+	// Only touched by their own side
+	int m_writeIndex;
+	int m_readIndex;
+	// Index of the slot in between, plus NEW_FLAG when it was published and not acquired yet
+	std::atomic<int> m_shared;
+
+	std::atomic<uint64_t> m_publishedCount;
+	std::atomic<uint64_t> m_skippedCount;
+};
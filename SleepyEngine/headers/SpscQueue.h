@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to a power of two. Push fails instead of blocking when full.
+template<typename T>
+class SpscQueue
+{
+public:
+	SpscQueue() : m_head(0), m_tail(0) {}
+
+	// INIT
+	// Not thread safe, call before both threads use the queue
+	void Init(uint32_t capacity)
+	{
+		uint32_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		m_items.assign(size, T());
+		m_mask = size - 1;
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+	// PRODUCER
+	bool Push(const T& item)
+	{
+		uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+			return false;
+
+		m_items[tail & m_mask] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// CONSUMER
+	bool Pop(T& item)
+	{
+		uint32_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+
+		item = m_items[head & m_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+private:
+	std::vector<T> m_items;
+	uint32_t m_mask = 0;
+	// Read by the other side, kept on separate cache lines
+	alignas(64) std::atomic<uint32_t> m_head;
+	alignas(64) std::atomic<uint32_t> m_tail;
+};
@@ -1,5 +1,12 @@
 #pragma once
+#include <chrono>
 
+class FrameStats;
+
+// Monotonic 64 bit tick based timer (std::chrono::steady_clock, QueryPerformanceCounter on Windows).
+// Ticks are nanoseconds, totals are kept in double so they do not lose precision over long uptimes.
+// Also owns the fixed timestep accumulator: the simulation consumes fixed steps while
+// rendering uses GetAlpha() to interpolate between the last two simulated states.
 class Timer
 {
 	public:
@@ -7,22 +14,48 @@ class Timer
 		bool Init();
 
 		void UpdateTimer();
-		void UpdateFPS(HWND Window);
-
-		float GetTotalTime();
+		// Advances by deltaTicks instead of reading the clock, for replays
+		void UpdateTimer(int64_t deltaTicks);
+#ifdef _WIN32
+		// Shows the frame rate and, when given, the frame time percentiles in the window title
+		void UpdateFPS(HWND Window, FrameStats* pFrameStats = nullptr);
+#endif
+
+		double GetTotalTime();
 		float GetDeltaTime();
+		// Ticks of the last update and since the one before
+		int64_t GetFrameTicks() { return CurrTicks; }
+		int64_t GetDeltaTicks() { return DeltaTicks; }
+
+		// FIXED STEP
+		void SetFixedDeltaTime(double seconds);
+		double GetFixedDeltaTime();
+		// Consumes one fixed step from the accumulator, call in a loop until it returns false
+		bool ConsumeFixedStep();
+		// Fraction of a fixed step left in the accumulator, in [0, 1)
+		float GetAlpha();
+
+		// TICKS
+		static int64_t GetTicks();
+		static double TicksToSeconds(int64_t ticks);
+		static int64_t SecondsToTicks(double seconds);
 
 	private:
 
-		float StartTime;
+		int64_t StartTicks;
+		int64_t PrevTicks;
+		int64_t CurrTicks;
 
+		int64_t DeltaTicks;
 		float DeltaTime;
-		float TotalTime;
+		double TotalTime;
 
-		float currTime;
-		float prevTime;
+		// Kept in ticks so repeated fixed steps never drift
+		int64_t FixedStepTicks;
+		int64_t Accumulator;
+		// Upper bound of the accumulator, avoids spiraling when a frame takes too long
+		int MaxFixedSteps;
 
-		float FPSTimer;
+		double FPSTimer;
 		int FrameCount;
-		int MaxFPS;
 };
\ No newline at end of file
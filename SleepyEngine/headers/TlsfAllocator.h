@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// What a TlsfAllocator looks like right now
+struct TlsfStats
+{
+	uint64_t TotalSize = 0;
+	uint64_t UsedSize = 0;
+	uint64_t LargestFreeBlock = 0;
+	int AllocationCount = 0;
+	int FreeBlockCount = 0;
+
+	uint64_t GetFreeSize() const { return TotalSize - UsedSize; }
+	// 0 when the free space is one block, close to 1 when it is scattered in small ones
+	float GetFragmentation() const;
+};
+
+// Two Level Segregated Fit allocator of offsets in a range, the memory itself lives elsewhere
+// (a GPU heap). Free blocks are kept in lists by size class: the first level is the power of two,
+// the second one splits it in SECOND_LEVEL_COUNT linear steps. Bitmaps of the non empty lists
+// find a big enough block with two bit scans, so Allocate and Free are O(1), and freed blocks
+// are merged with their free neighbors right away.
+// Not thread safe.
+class TlsfAllocator
+{
+public:
+	// Sizes and offsets are multiples of it, alignments up to it are free
+	static const uint64_t GRANULARITY = 256;
+	static const int SECOND_LEVEL_LOG2 = 4;
+	static const int SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_LOG2;
+	// Enough for ranges up to 2^(FIRST_LEVEL_COUNT + SECOND_LEVEL_LOG2 - 1) granules
+	static const int FIRST_LEVEL_COUNT = 40;
+	// Returned when nothing fits
+	static const uint32_t INVALID_ALLOCATION = 0xFFFFFFFF;
+
+	TlsfAllocator();
+	~TlsfAllocator() {};
+
+	// INIT
+	// size is rounded down to GRANULARITY
+	bool Init(uint64_t size);
+
+	// ALLOCATION
+	// alignment must be a power of two. Returns an id for Free and GetOffset.
+	uint32_t Allocate(uint64_t size, uint64_t alignment = GRANULARITY);
+	void Free(uint32_t allocation);
+
+	// SETTER / GETTER
+	uint64_t GetOffset(uint32_t allocation) const { return m_blocks[allocation].Offset; }
+	uint64_t GetSize(uint32_t allocation) const { return m_blocks[allocation].Size; }
+	uint64_t GetTotalSize() const { return m_totalSize; }
+	uint64_t GetUsedSize() const { return m_usedSize; }
+	int GetAllocationCount() const { return m_allocationCount; }
+	bool IsEmpty() const { return m_allocationCount == 0; }
+	// Walks the free lists of the largest size class, not O(1)
+	TlsfStats GetStats() const;
+
+	// Allocations in offset order, for defragmentation. Pass INVALID_ALLOCATION to get the first one.
+	uint32_t GetNextAllocation(uint32_t allocation) const;
+
+private:
+	// Free or used, chained to its physical neighbors
+	struct Block
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t PrevPhysical = INVALID_ALLOCATION;
+		uint32_t NextPhysical = INVALID_ALLOCATION;
+		// Free list of its size class, or the pool of unused blocks
+		uint32_t PrevFree = INVALID_ALLOCATION;
+		uint32_t NextFree = INVALID_ALLOCATION;
+		bool IsFree = false;
+		bool IsUsed = false;
+	};
+
+	// Size class of a free block of this size
+	static void GetSizeClass(uint64_t size, int& firstLevel, int& secondLevel);
+	uint32_t FindFreeBlock(uint64_t size) const;
+	void InsertFreeBlock(uint32_t block);
+	void RemoveFreeBlock(uint32_t block);
+	// Cuts block at size, the rest becomes a new free block
+	void Split(uint32_t block, uint64_t size);
+	// Absorbs next, which is free and follows block
+	void Merge(uint32_t block, uint32_t next);
+	uint32_t NewBlock();
+	void ReleaseBlock(uint32_t block);
+
+private:
+	std::vector<Block> m_blocks;
+	// Unused entries of m_blocks, chained by NextFree
+	uint32_t m_firstUnusedBlock = INVALID_ALLOCATION;
+	uint32_t m_firstPhysicalBlock = INVALID_ALLOCATION;
+
+	uint64_t m_firstLevelBitmap = 0;
+	uint32_t m_secondLevelBitmaps[FIRST_LEVEL_COUNT];
+	uint32_t m_freeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+
+	uint64_t m_totalSize = 0;
+	uint64_t m_usedSize = 0;
+	int m_allocationCount = 0;
+	int m_freeBlockCount = 0;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include "LinearRing.h"
+
+class RhiDevice;
+class RhiBuffer;
+
+// Sub-allocation of the upload ring, valid until the frame it was made in is retired
+struct UploadAllocation
+{
+	uint8_t* pData = nullptr;
+	RhiBuffer* pBuffer = nullptr;
+	// From the start of pBuffer, what SetConstantBuffer and friends take
+	uint64_t Offset = 0;
+	uint64_t GpuAddress = 0;
+};
+
+// One persistently mapped upload buffer shared by the frames in flight, allocated from any
+// thread without locking and retired by fence value (LinearRing).
+class UploadRing
+{
+public:
+	// Constant buffer views, and the largest alignment the ring guarantees
+	static const uint64_t MAX_ALIGNMENT = 256;
+
+	UploadRing();
+	~UploadRing();
+
+	// INIT
+	// capacity is rounded up to MAX_ALIGNMENT
+	bool Init(RhiDevice* pDevice, uint64_t capacity);
+
+	// FRAME
+	// See LinearRing
+	void Retire(uint64_t completedFenceValue) { m_ring.Retire(completedFenceValue); }
+	void EndFrame(uint64_t fenceValue) { m_ring.EndFrame(fenceValue); }
+
+	// ALLOCATION
+	// Thread safe. alignment must be a power of two <= MAX_ALIGNMENT.
+	// Returns false when the GPU still reads the memory it would need.
+	bool Allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation);
+
+	// SETTER / GETTER
+	uint64_t GetCapacity() const { return m_ring.GetCapacity(); }
+	uint64_t GetUsedSize() const { return m_ring.GetUsedSize(); }
+	uint64_t GetFailedCount() const { return m_ring.GetFailedCount(); }
+	int GetPendingFrameCount() const { return m_ring.GetPendingFrameCount(); }
+
+private:
+	RhiBuffer* m_pBuffer = nullptr;
+	uint8_t* m_pData = nullptr;
+	LinearRing m_ring;
+};
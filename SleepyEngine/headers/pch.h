@@ -5,6 +5,7 @@ class Entity;
 class Component;
 class Mesh;
 
+#ifdef _WIN32
 // LIBS
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
@@ -16,6 +17,7 @@ class Mesh;
 #ifdef _DEBUG
 	#include <crtdbg.h>
 #endif
+#endif
 
 // STD
 #include <string>
@@ -34,16 +36,21 @@ class Mesh;
 #include <cmath>
 
 // DIRECTX
+// Headless builds (replays on Linux CI) only get DirectXMath, which is portable
+#ifdef _WIN32
 #include <comdef.h> 
 #include <dxgi1_4.h>
 #include <DXGI.h>
 #include <d3d12.h>
 #include <D3Dcompiler.h>
+#endif
 #include <DirectXMath.h>
 #include <DirectXPackedVector.h>
 #include <DirectXColors.h>
 #include <DirectXCollision.h>
+#ifdef _WIN32
 #include "../src/utils/d3dx12.h"
+#endif
 
 
 
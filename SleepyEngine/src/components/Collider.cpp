@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Collider.h"
+#include "PhysicsWorld.h"
 
 Collider::Collider()
 {
@@ -9,4 +10,65 @@ Collider::Collider()
 void Collider::Init()
 {
 
-}
\ No newline at end of file
+}
+
+void Collider::WakeUp()
+{
+	if (IsStatic())
+		return;
+
+	m_sleepTimer = 0.0f;
+	if (m_isSleeping && m_pWorld != nullptr)
+		m_pWorld->RequestWake(this);
+}
+
+void Collider::OnTransformChanged()
+{
+	if (!IsStatic())
+	{
+		WakeUp();
+		return;
+	}
+	// Nothing else refreshes the bounds of a static collider while the scene sleeps
+	if (m_pWorld != nullptr)
+		m_pWorld->RequestWake(this);
+}
+
+void Collider::ApplyImpulse(const XMFLOAT3& impulse)
+{
+	if (IsStatic())
+		return;
+
+	XMVECTOR velocity = XMLoadFloat3(&m_velocity);
+	velocity = XMVectorAdd(velocity, XMVectorScale(XMLoadFloat3(&impulse), m_inverseMass));
+	XMStoreFloat3(&m_velocity, velocity);
+	WakeUp();
+}
+
+void Collider::SetMass(float mass)
+{
+	bool wasStatic = IsStatic();
+	m_inverseMass = mass > 0.0f ? 1.0f / mass : 0.0f;
+	if (IsStatic())
+		m_velocity = { 0.0f, 0.0f, 0.0f };
+
+	// Static and dynamic bodies are not tracked the same way by the world, and two static bodies never pair
+	if (m_pWorld != nullptr)
+		m_pWorld->RefreshFilter(this, wasStatic);
+	WakeUp();
+}
+
+void Collider::SetCollisionLayer(uint32_t layer)
+{
+	m_collisionLayer = layer;
+	// Only the pairs whose filter result changed are added or ended
+	if (m_pWorld != nullptr)
+		m_pWorld->RefreshFilter(this, IsStatic());
+}
+
+void Collider::SetCollisionMask(uint32_t mask)
+{
+	m_collisionMask = mask;
+	if (m_pWorld != nullptr)
+		m_pWorld->RefreshFilter(this, IsStatic());
+}
@@ -1,11 +1,35 @@
 #include "pch.h"
 #include "Script.h"
+#include "ScriptScheduler.h"
 
 Script::Script()
 {
 
 }
 
+Script::~Script()
+{
+	if (m_pScheduler != nullptr)
+		m_pScheduler->Detach(this);
+}
+
 void Script::Init()
 {
 }
+
+void Script::StartCoroutine(ScriptTask task)
+{
+	// Nothing would ever resume it, the task is destroyed with its frame
+	if (m_pScheduler == nullptr)
+	{
+		std::cout << "Script::StartCoroutine: the script is not attached to a scheduler, the coroutine is dropped" << std::endl;
+		return;
+	}
+	m_pScheduler->Start(std::move(task), this);
+}
+
+void Script::StopCoroutines()
+{
+	if (m_pScheduler != nullptr)
+		m_pScheduler->StopAll(this);
+}
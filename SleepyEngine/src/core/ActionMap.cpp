@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "ActionMap.h"
+#include "Input.h"
+#include "Profiler.h"
+#include <cstring>
+
+ActionMap::ActionMap()
+{
+}
+
+void ActionMap::Init()
+{
+	m_actionNames.clear();
+	m_actionIds.clear();
+	m_bindings.clear();
+	m_table.clear();
+	m_isDirty = false;
+	m_active.reset();
+	m_activated.reset();
+	m_deactivated.reset();
+}
+
+int ActionMap::RegisterAction(const std::string& name)
+{
+	auto it = m_actionIds.find(name);
+	if (it != m_actionIds.end())
+		return it->second;
+
+	if (m_actionNames.size() >= MAX_ACTIONS)
+		return -1;
+
+	int action = (int)m_actionNames.size();
+	m_actionNames.push_back(name);
+	m_actionIds[name] = action;
+	return action;
+}
+
+int ActionMap::FindAction(const std::string& name) const
+{
+	auto it = m_actionIds.find(name);
+	if (it == m_actionIds.end())
+		return -1;
+	return it->second;
+}
+
+bool ActionMap::Bind(int action, int key)
+{
+	return BindChord(action, { key });
+}
+
+bool ActionMap::BindChord(int action, std::initializer_list<int> keys)
+{
+	if (action < 0 || action >= m_actionNames.size() || keys.size() == 0 || keys.size() > MAX_CHORD_KEYS)
+		return false;
+
+	Binding binding = {};
+	binding.Action = (uint8_t)action;
+	for (int key : keys)
+	{
+		if (key < 0 || key >= Input::KEY_COUNT)
+			return false;
+		binding.Keys[binding.KeyCount++] = (uint8_t)key;
+	}
+	// Same chord whatever the order the keys were given in, so Compile drops duplicates
+	std::sort(binding.Keys, binding.Keys + binding.KeyCount);
+	binding.KeyCount = (uint8_t)(std::unique(binding.Keys, binding.Keys + binding.KeyCount) - binding.Keys);
+
+	m_bindings.push_back(binding);
+	m_isDirty = true;
+	return true;
+}
+
+void ActionMap::ClearBindings(int action)
+{
+	int count = 0;
+	for (int i = 0; i < m_bindings.size(); i++)
+	{
+		if (m_bindings[i].Action != action)
+			m_bindings[count++] = m_bindings[i];
+	}
+	m_bindings.resize(count);
+	m_isDirty = true;
+}
+
+void ActionMap::Compile()
+{
+	m_table = m_bindings;
+
+	// Duplicates would only cost time
+	std::sort(m_table.begin(), m_table.end(), [](const Binding& a, const Binding& b)
+	{
+		if (a.Action != b.Action)
+			return a.Action < b.Action;
+		if (a.KeyCount != b.KeyCount)
+			return a.KeyCount < b.KeyCount;
+		return memcmp(a.Keys, b.Keys, a.KeyCount) < 0;
+	});
+	auto last = std::unique(m_table.begin(), m_table.end(), [](const Binding& a, const Binding& b)
+	{
+		return a.Action == b.Action && a.KeyCount == b.KeyCount && memcmp(a.Keys, b.Keys, a.KeyCount) == 0;
+	});
+	m_table.erase(last, m_table.end());
+	m_isDirty = false;
+}
+
+void ActionMap::Evaluate(const Input& input)
+{
+	PROFILE_FUNCTION();
+	if (m_isDirty)
+		Compile();
+
+	std::bitset<MAX_ACTIONS> previous = m_active;
+	m_active.reset();
+
+	for (int i = 0; i < m_table.size(); i++)
+	{
+		const Binding& binding = m_table[i];
+		// Sorted by action, the other bindings of an active action can be skipped
+		if (m_active[binding.Action])
+			continue;
+
+		// Pressed with hold also counts keys tapped and released within the frame
+		bool isActive = true;
+		for (int k = 0; k < binding.KeyCount && isActive; k++)
+			isActive = input.IsPressed(binding.Keys[k], true);
+
+		if (isActive)
+			m_active[binding.Action] = true;
+	}
+
+	m_activated = m_active & ~previous;
+	m_deactivated = previous & ~m_active;
+}
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "FramePacer.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+FramePacer::FramePacer()
+{
+}
+
+FramePacer::~FramePacer()
+{
+	if (m_hasTimerPeriod)
+		timeEndPeriod(1);
+}
+
+bool FramePacer::Init(double targetFrameRate)
+{
+	// 1 ms scheduler granularity instead of the default 15.6 ms, so Sleep() is usable for pacing
+	if (!m_hasTimerPeriod)
+		m_hasTimerPeriod = timeBeginPeriod(1) == TIMERR_NOERROR;
+
+	SetTargetFrameRate(targetFrameRate);
+	SetSpinTime(m_hasTimerPeriod ? 0.002 : 0.016);
+	return true;
+}
+
+void FramePacer::SetTargetFrameRate(double targetFrameRate)
+{
+	m_frameTicks = targetFrameRate > 0.0 ? Timer::SecondsToTicks(1.0 / targetFrameRate) : 0;
+	m_nextFrameTicks = Timer::GetTicks();
+}
+
+void FramePacer::SetSpinTime(double seconds)
+{
+	m_spinTicks = Timer::SecondsToTicks(seconds);
+}
+
+void FramePacer::WaitForNextFrame()
+{
+	if (m_frameTicks == 0)
+		return;
+
+	PROFILE_FUNCTION();
+	int64_t now = Timer::GetTicks();
+	m_nextFrameTicks += m_frameTicks;
+
+	// Already late: start the next frame right away and restart the schedule from now,
+	// instead of rushing frames to catch up
+	if (now >= m_nextFrameTicks)
+	{
+		m_nextFrameTicks = now;
+		return;
+	}
+
+	// Sleep for most of the remaining time...
+	int64_t remaining = m_nextFrameTicks - now;
+	if (remaining > m_spinTicks)
+	{
+		DWORD sleepMs = (DWORD)((remaining - m_spinTicks) / 1000000);
+		if (sleepMs > 0)
+			Sleep(sleepMs);
+	}
+
+	// ...and spin for the last fraction
+	while (Timer::GetTicks() < m_nextFrameTicks)
+		YieldProcessor();
+}
+
+bool FramePacer::WaitWhileIdle(HWND window)
+{
+	bool isMinimized = IsIconic(window) != FALSE;
+	bool isUnfocused = GetForegroundWindow() != window;
+	if (!isMinimized && !isUnfocused)
+	{
+		m_isIdle = false;
+		return false;
+	}
+
+	int64_t now = Timer::GetTicks();
+	if (!m_isIdle)
+	{
+		m_isIdle = true;
+		m_nextIdleFrameTicks = now;
+	}
+
+	// Nothing is visible when minimized: block until the window gets a message.
+	// Unfocused: wait for a message or for the next idle frame, whichever comes first.
+	DWORD timeout = INFINITE;
+	if (!isMinimized && m_idleFrameRate > 0.0)
+	{
+		int64_t remaining = m_nextIdleFrameTicks - now;
+		timeout = remaining > 0 ? (DWORD)(remaining / 1000000) : 0;
+	}
+
+	if (MsgWaitForMultipleObjects(0, nullptr, FALSE, timeout, QS_ALLINPUT) == WAIT_OBJECT_0)
+		return true;
+
+	// Time for an idle frame, the regular schedule restarts after it
+	now = Timer::GetTicks();
+	m_nextIdleFrameTicks = now + Timer::SecondsToTicks(1.0 / m_idleFrameRate);
+	m_nextFrameTicks = now;
+	return false;
+}
@@ -0,0 +1,80 @@
+#include "FrameRing.h"
+
+uint64_t MockFenceTimeline::Signal()
+{
+	m_lastSignaledValue++;
+	if (m_lastSignaledValue > (uint64_t)m_latency)
+		Complete(m_lastSignaledValue - m_latency);
+	return m_lastSignaledValue;
+}
+
+void MockFenceTimeline::WaitFor(uint64_t value)
+{
+	if (m_completedValue >= value)
+		return;
+
+	m_waitCount++;
+	Complete(value);
+}
+
+void MockFenceTimeline::Complete(uint64_t value)
+{
+	// Cannot complete work which was not submitted
+	if (value > m_lastSignaledValue)
+		value = m_lastSignaledValue;
+	if (value > m_completedValue)
+		m_completedValue = value;
+}
+
+FrameRing::FrameRing()
+{
+}
+
+bool FrameRing::Init(FenceTimeline* pTimeline, int frameCount)
+{
+	if (pTimeline == nullptr)
+		return false;
+
+	if (frameCount < 1)
+		frameCount = 1;
+	if (frameCount > MAX_FRAME_COUNT)
+		frameCount = MAX_FRAME_COUNT;
+
+	m_pTimeline = pTimeline;
+	m_frameCount = frameCount;
+	m_frameIndex = -1;
+	for (int i = 0; i < MAX_FRAME_COUNT; i++)
+		m_fenceValues[i] = 0;
+	m_submittedCount = 0;
+	m_waitCount = 0;
+	return true;
+}
+
+int FrameRing::BeginFrame()
+{
+	m_frameIndex = (m_frameIndex + 1) % m_frameCount;
+
+	// The slot was last used m_frameCount frames ago, usually the GPU is done with it
+	uint64_t fenceValue = m_fenceValues[m_frameIndex];
+	if (fenceValue != 0 && m_pTimeline->GetCompletedValue() < fenceValue)
+	{
+		m_waitCount++;
+		m_pTimeline->WaitFor(fenceValue);
+	}
+	return m_frameIndex;
+}
+
+void FrameRing::EndFrame()
+{
+	m_fenceValues[m_frameIndex] = m_pTimeline->Signal();
+	m_submittedCount++;
+}
+
+void FrameRing::WaitIdle()
+{
+	for (int i = 0; i < m_frameCount; i++)
+	{
+		if (m_fenceValues[i] != 0)
+			m_pTimeline->WaitFor(m_fenceValues[i]);
+	}
+}
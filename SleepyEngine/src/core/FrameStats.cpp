@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "FrameStats.h"
+#include "MathHelper.h"
+
+FrameStats::FrameStats()
+{
+}
+
+bool FrameStats::Init(double budgetSeconds)
+{
+	m_window.assign(WINDOW_SIZE, 0.0f);
+	m_sortScratch.reserve(WINDOW_SIZE);
+	m_windowCount = 0;
+	m_writeIndex = 0;
+
+	for (int i = 0; i < BUCKET_COUNT; i++)
+		m_histogram[i] = 0;
+	m_totalFrameCount = 0;
+	m_totalOverBudgetCount = 0;
+	m_totalMs = 0.0;
+	m_maxMs = 0.0f;
+
+	SetBudget(budgetSeconds);
+	return true;
+}
+
+void FrameStats::AddFrame(double seconds)
+{
+	float milliseconds = (float)(seconds * 1000.0);
+
+	m_window[m_writeIndex] = milliseconds;
+	m_writeIndex = (m_writeIndex + 1) % WINDOW_SIZE;
+	m_windowCount = MathHelper::Min(m_windowCount + 1, WINDOW_SIZE);
+
+	m_histogram[GetBucket(milliseconds)]++;
+	m_totalFrameCount++;
+	m_totalMs += milliseconds;
+	m_maxMs = MathHelper::Max(m_maxMs, milliseconds);
+	if (milliseconds > m_budgetMs)
+		m_totalOverBudgetCount++;
+}
+
+FrameStats::Summary FrameStats::GetSummary()
+{
+	Summary summary = {};
+	summary.FrameCount = m_windowCount;
+	if (m_windowCount == 0)
+		return summary;
+
+	m_sortScratch.assign(m_window.begin(), m_window.begin() + m_windowCount);
+
+	double total = 0.0;
+	for (int i = 0; i < m_windowCount; i++)
+	{
+		total += m_sortScratch[i];
+		if (m_sortScratch[i] > m_budgetMs)
+			summary.OverBudgetCount++;
+	}
+	summary.Mean = total / m_windowCount;
+
+	// Nearest rank percentiles, nth_element keeps it linear
+	auto percentile = [this](double p)
+	{
+		int rank = (int)std::ceil(p * m_windowCount) - 1;
+		rank = MathHelper::Clamp(rank, 0, m_windowCount - 1);
+		std::nth_element(m_sortScratch.begin(), m_sortScratch.begin() + rank, m_sortScratch.end());
+		return (double)m_sortScratch[rank];
+	};
+	summary.P50 = percentile(0.50);
+	summary.P95 = percentile(0.95);
+	summary.P99 = percentile(0.99);
+	summary.Max = *std::max_element(m_sortScratch.begin(), m_sortScratch.end());
+	return summary;
+}
+
+bool FrameStats::ExportCsv(const std::string& path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	Summary summary = GetSummary();
+
+	file << "stat,value\n";
+	file << "total_frames," << m_totalFrameCount << "\n";
+	file << "total_over_budget," << m_totalOverBudgetCount << "\n";
+	file << "total_mean_ms," << (m_totalFrameCount > 0 ? m_totalMs / m_totalFrameCount : 0.0) << "\n";
+	file << "total_max_ms," << m_maxMs << "\n";
+	file << "budget_ms," << m_budgetMs << "\n";
+	file << "window_frames," << summary.FrameCount << "\n";
+	file << "window_mean_ms," << summary.Mean << "\n";
+	file << "window_p50_ms," << summary.P50 << "\n";
+	file << "window_p95_ms," << summary.P95 << "\n";
+	file << "window_p99_ms," << summary.P99 << "\n";
+	file << "window_max_ms," << summary.Max << "\n";
+	file << "window_over_budget," << summary.OverBudgetCount << "\n";
+
+	file << "\nbucket_low_ms,bucket_high_ms,frames\n";
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		file << GetBucketLowerBound(i) << ",";
+		if (i + 1 < BUCKET_COUNT)
+			file << GetBucketLowerBound(i + 1);
+		else
+			file << "inf";
+		file << "," << m_histogram[i] << "\n";
+	}
+
+	// Oldest to newest
+	file << "\nframe,duration_ms\n";
+	int first = (m_writeIndex - m_windowCount + WINDOW_SIZE) % WINDOW_SIZE;
+	for (int i = 0; i < m_windowCount; i++)
+		file << i << "," << m_window[(first + i) % WINDOW_SIZE] << "\n";
+
+	return file.good();
+}
+
+double FrameStats::GetBucketLowerBound(int bucket)
+{
+	if (bucket == 0)
+		return 0.0;
+	return 0.25 * std::pow(2.0, (double)bucket / BUCKETS_PER_OCTAVE);
+}
+
+int FrameStats::GetBucket(double milliseconds)
+{
+	if (milliseconds <= 0.25)
+		return 0;
+
+	int bucket = (int)(std::log2(milliseconds / 0.25) * BUCKETS_PER_OCTAVE);
+	return MathHelper::Clamp(bucket, 0, BUCKET_COUNT - 1);
+}
@@ -0,0 +1,116 @@
+#include "pch.h"
+#include "HeadlessRunner.h"
+#include "Input.h"
+#include "InputLog.h"
+#include "ActionMap.h"
+#include "Timer.h"
+#include "PhysicsWorld.h"
+#include "ScriptScheduler.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "RenderSnapshot.h"
+
+HeadlessRunner::HeadlessRunner()
+{
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+	delete m_pRenderer;
+	delete m_pSwapChain;
+	delete m_pRhiDevice;
+	delete m_pScriptScheduler;
+	delete m_pPhysicsWorld;
+	delete m_pFrameStats;
+	delete m_pActionMap;
+	delete m_pInput;
+	delete m_pJobSystem;
+}
+
+bool HeadlessRunner::Init(int workerCount, RhiBackend backend)
+{
+	m_pJobSystem = new JobSystem();
+	m_pJobSystem->Init(workerCount);
+
+	m_pInput = new Input();
+	m_pInput->Init();
+	m_pActionMap = new ActionMap();
+	m_pActionMap->Init();
+
+	m_pPhysicsWorld = new PhysicsWorld();
+	m_pPhysicsWorld->Init();
+	m_pPhysicsWorld->SetJobSystem(m_pJobSystem);
+
+	m_pScriptScheduler = new ScriptScheduler();
+	m_pScriptScheduler->Init();
+
+	m_pFrameStats = new FrameStats();
+	m_pFrameStats->Init(1.0 / 60.0);
+
+	m_pRhiDevice = CreateRhiDevice(backend, m_pJobSystem);
+	if (m_pRhiDevice == nullptr)
+		return false;
+	RhiSwapChainDesc swapChainDesc;
+	swapChainDesc.Width = 640;
+	swapChainDesc.Height = 480;
+	m_pSwapChain = m_pRhiDevice->CreateSwapChain(swapChainDesc);
+	m_pRenderer = new Renderer();
+	if (!m_pRenderer->Init(m_pRhiDevice, m_pSwapChain, FrameRing::MAX_FRAME_COUNT, m_pJobSystem))
+		return false;
+	// Null and software backends ignore the bytecode
+	return backend == RhiBackend::D3D12 || m_pRenderer->CreatePipeline(RhiShaderBytecode(), RhiShaderBytecode());
+}
+
+int HeadlessRunner::Run(const std::string& replayPath)
+{
+	InputReplay replay;
+	if (!replay.Open(replayPath))
+		return -1;
+
+	PROFILE_THREAD_NAME("Main");
+
+	Timer timer = Timer();
+	timer.Init();
+
+	std::vector<InputEvent> events;
+	events.reserve(256);
+	int64_t deltaTicks = 0;
+	RenderSnapshot snapshot;
+	uint64_t frameIndex = 0;
+
+	// Same order as SleepyEngine::Run, minus the window and the pacing. Drawing stays on this thread.
+	while (replay.NextFrame(timer.GetFrameTicks(), deltaTicks, events))
+	{
+		int64_t frameStart = Timer::GetTicks();
+		{
+			PROFILE_SCOPE("Frame");
+			timer.UpdateTimer(deltaTicks);
+
+			for (int i = 0; i < events.size(); i++)
+				m_pInput->PushEvent(events[i]);
+			m_pInput->Update();
+			m_pActionMap->Evaluate(*m_pInput);
+
+			m_pScriptScheduler->Update(timer.GetTotalTime());
+
+			while (timer.ConsumeFixedStep())
+				m_pPhysicsWorld->Step((float)timer.GetFixedDeltaTime());
+
+			snapshot.Clear();
+			snapshot.FrameIndex = frameIndex++;
+			snapshot.Time = timer.GetTotalTime();
+			snapshot.Alpha = timer.GetAlpha();
+			Renderer::CaptureColliders(*m_pPhysicsWorld, snapshot);
+			m_pRenderer->Draw(snapshot);
+		}
+		m_pFrameStats->AddFrame(Timer::TicksToSeconds(Timer::GetTicks() - frameStart));
+	}
+	return replay.GetFramesRead();
+}
+
+bool HeadlessRunner::ExportFrameStats(const std::string& csvPath)
+{
+	return m_pFrameStats->ExportCsv(csvPath);
+}
@@ -1,102 +1,210 @@
 #include "pch.h"
 #include "Input.h"
-//#include <vector>
-//#include <iostream>
-//#include <Windows.h>
+#include "Timer.h"
+#include "Profiler.h"
+#ifdef _WIN32
+	#include "InputSampler.h"
+#endif
 
-template<typename Key, typename Value>
-std::ostream& operator << (std::ostream& os, std::map<Key, Value>& map)
+Input::Input()
+{}
+
+Input::~Input()
+{
+	StopSampling();
+}
+
+bool Input::Init()
 {
-	os << "{\n";
-	for (const auto& pair : map)
+	for (int i = 0; i < KEY_COUNT; i++)
 	{
-		os << "\t{" << pair.first << " => " << pair.second << "}\n";
+		m_keyStates[i] = 0;
+		m_pressedTimes[i] = 0;
+		m_releasedTimes[i] = 0;
 	}
-	os << "}";
+	m_pressed.reset();
+	m_released.reset();
 
-	return os;
+	m_eventQueue.clear();
+	m_frameEvents.clear();
+	m_eventQueue.reserve(256);
+	m_frameEvents.reserve(256);
+	return true;
 }
 
-Input::Input()
-{}
+void Input::Update()
+{
+	PROFILE_FUNCTION();
+	m_pressed.reset();
+	m_released.reset();
 
-bool Input::Init()
+#ifdef _WIN32
+	if (m_pSampler != nullptr)
+	{
+		InputEvent event;
+		while (m_pSampler->PopEvent(event))
+			m_eventQueue.push_back(event);
+	}
+#endif
+
+	m_frameEvents.clear();
+	m_frameEvents.swap(m_eventQueue);
+	for (int i = 0; i < m_frameEvents.size(); i++)
+		ApplyEvent(m_frameEvents[i]);
+}
+
+void Input::PushEvent(const InputEvent& event)
 {
-	std::vector<int> GodDamnLongInputIdList = {
-		'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'M', 'N', 'L', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
-		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
-		// Left, right and middle buttons. Have a gamer mouse with 14 buttons? Too bad!
-		VK_LBUTTON, VK_RBUTTON, VK_MBUTTON,
-		VK_RETURN, VK_SPACE, VK_DELETE,
-		VK_CONTROL, VK_SHIFT, VK_MENU, VK_TAB, VK_ESCAPE
-	};
-
-	for (int i = 0; i < GodDamnLongInputIdList.size(); i++)
+	m_eventQueue.push_back(event);
+}
+
+#ifdef _WIN32
+void Input::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+	InputEvent event = {};
+	event.Time = Timer::GetTicks();
+
+	switch (message)
 	{
-		InputList.insert({ GodDamnLongInputIdList[i], 0 });
+	case WM_KEYDOWN:
+	case WM_SYSKEYDOWN:
+		// Bit 30: the key was already down, auto repeat
+		if (lParam & (1 << 30))
+			return;
+		event.Type = InputEventType::KeyDown;
+		event.Key = (uint8_t)wParam;
+		break;
+	case WM_KEYUP:
+	case WM_SYSKEYUP:
+		event.Type = InputEventType::KeyUp;
+		event.Key = (uint8_t)wParam;
+		break;
+	case WM_LBUTTONDOWN:
+	case WM_RBUTTONDOWN:
+	case WM_MBUTTONDOWN:
+		event.Type = InputEventType::KeyDown;
+		event.Key = message == WM_LBUTTONDOWN ? VK_LBUTTON : message == WM_RBUTTONDOWN ? VK_RBUTTON : VK_MBUTTON;
+		break;
+	case WM_LBUTTONUP:
+	case WM_RBUTTONUP:
+	case WM_MBUTTONUP:
+		event.Type = InputEventType::KeyUp;
+		event.Key = message == WM_LBUTTONUP ? VK_LBUTTON : message == WM_RBUTTONUP ? VK_RBUTTON : VK_MBUTTON;
+		break;
+	case WM_MOUSEMOVE:
+		event.Type = InputEventType::MouseMove;
+		event.X = (int16_t)LOWORD(lParam);
+		event.Y = (int16_t)HIWORD(lParam);
+		break;
+	case WM_KILLFOCUS:
+		// The key ups will go to another window
+		ReleaseAll();
+		return;
+	default:
+		return;
 	}
-	std::cout << InputList << std::endl;
-	return true;
+
+	// The sampler sees the same changes for the keys it watches and the mouse, the others
+	// (function keys, punctuation, numpad...) still come from the messages
+	if (m_pSampler != nullptr && (event.Type == InputEventType::MouseMove || m_pSampler->IsWatched(event.Key)))
+		return;
+	PushEvent(event);
 }
 
-void Input::Update()
+bool Input::StartSampling(HWND window, double sampleRate)
 {
-	for (auto& pair : InputList)
+	StopSampling();
+
+	m_pSampler = new InputSampler();
+	if (!m_pSampler->Init(window, sampleRate))
 	{
-		SHORT keyState = GetAsyncKeyState(pair.first);
-		if (keyState & 0x8000 && pair.second >= 1)
-			pair.second = 2;
-		else if (keyState & 0x1 && pair.second == 0)
-			pair.second = 1;
-		else if (pair.second > 0)
-			pair.second = -1;
-		else
-			pair.second = 0;
-
-		if (pair.second > 0)
-			OnKeyPressed(pair.first);
-		else if (pair.second == -1)
-			OnKeyReleased(pair.first);
+		delete m_pSampler;
+		m_pSampler = nullptr;
+		return false;
 	}
+	m_pSampler->Start();
+	return true;
 }
 
-//#include <map>
-std::pair<int, int> getKeyPair(int key, std::map<int, int> InputList)
+#endif
+
+void Input::StopSampling()
 {
-	for (const auto& pair : InputList)
+#ifdef _WIN32
+	if (m_pSampler == nullptr)
+		return;
+
+	m_pSampler->Stop();
+	delete m_pSampler;
+	m_pSampler = nullptr;
+#endif
+}
+
+void Input::ReleaseAll()
+{
+	InputEvent event = {};
+	event.Time = Timer::GetTicks();
+	event.Type = InputEventType::KeyUp;
+	for (int i = 0; i < KEY_COUNT; i++)
 	{
-		if (pair.first == key) {
-			return pair;
-		}
+		if (m_keyStates[i] == 0)
+			continue;
+
+		event.Key = (uint8_t)i;
+		PushEvent(event);
 	}
 }
 
-bool Input::IsPressed(int key, bool allow_hold)
+bool Input::IsPressed(int key, bool allowHold) const
 {
-	std::pair<int, int> pair = getKeyPair(key, InputList);
-	if (allow_hold)
-		return pair.second > 0;
-	return pair.second == 1;
+	if (!IsValid(key))
+		return false;
+	if (allowHold)
+		return m_keyStates[key] != 0 || m_pressed[key];
+	return m_pressed[key];
 }
 
-bool Input::IsHeld(int key)
+bool Input::IsHeld(int key) const
 {
-	std::pair<int, int> pair = getKeyPair(key, InputList);
-	return pair.second == 2;
+	return IsValid(key) && m_keyStates[key] != 0 && !m_pressed[key];
 }
 
-bool Input::GotReleased(int key)
+bool Input::GotReleased(int key) const
 {
-	std::pair<int, int> pair = getKeyPair(key, InputList);
-	return pair.second == -1;
+	return IsValid(key) && m_released[key];
+}
+
+void Input::ApplyEvent(const InputEvent& event)
+{
+	switch (event.Type)
+	{
+	case InputEventType::KeyDown:
+		if (m_keyStates[event.Key] != 0)
+			return;
+		m_keyStates[event.Key] = 1;
+		m_pressed[event.Key] = true;
+		m_pressedTimes[event.Key] = event.Time;
+		OnKeyPressed(event.Key);
+		break;
+	case InputEventType::KeyUp:
+		if (m_keyStates[event.Key] == 0)
+			return;
+		m_keyStates[event.Key] = 0;
+		m_released[event.Key] = true;
+		m_releasedTimes[event.Key] = event.Time;
+		OnKeyReleased(event.Key);
+		break;
+	case InputEventType::MouseMove:
+		m_mouseX = event.X;
+		m_mouseY = event.Y;
+		break;
+	}
 }
 
 void Input::OnKeyPressed(int key)
 {
-	std::cout << "Key pressed: " << key << std::endl;
 }
 
 void Input::OnKeyReleased(int key)
 {
-	std::cout << "Key released: " << key << std::endl;
-}
\ No newline at end of file
+}
@@ -0,0 +1,183 @@
+#include "InputLog.h"
+
+static const char LOG_MAGIC[4] = { 'S', 'L', 'I', 'L' };
+static const uint32_t LOG_VERSION = 1;
+static const size_t LOG_HEADER_SIZE = 8;
+
+InputRecorder::InputRecorder()
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+bool InputRecorder::Open(const std::string& path)
+{
+	Close();
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open())
+		return false;
+
+	m_file.write(LOG_MAGIC, 4);
+	uint8_t version[4] = { (uint8_t)LOG_VERSION, (uint8_t)(LOG_VERSION >> 8), (uint8_t)(LOG_VERSION >> 16), (uint8_t)(LOG_VERSION >> 24) };
+	m_file.write((const char*)version, 4);
+
+	m_buffer.reserve(1024);
+	m_frameCount = 0;
+	return true;
+}
+
+void InputRecorder::RecordFrame(int64_t frameTicks, int64_t deltaTicks, const std::vector<InputEvent>& events)
+{
+	if (!m_file.is_open())
+		return;
+
+	m_buffer.clear();
+	WriteVarint((uint64_t)(deltaTicks > 0 ? deltaTicks : 0));
+	WriteVarint(events.size());
+	for (int i = 0; i < events.size(); i++)
+	{
+		const InputEvent& event = events[i];
+		m_buffer.push_back((uint8_t)event.Type);
+		if (event.Type == InputEventType::MouseMove)
+		{
+			WriteSigned(event.X);
+			WriteSigned(event.Y);
+		}
+		else
+		{
+			m_buffer.push_back(event.Key);
+		}
+		// Usually a little before the frame, small either way
+		WriteSigned(event.Time - frameTicks);
+	}
+
+	m_file.write((const char*)m_buffer.data(), m_buffer.size());
+	m_frameCount++;
+}
+
+void InputRecorder::Close()
+{
+	if (m_file.is_open())
+		m_file.close();
+}
+
+void InputRecorder::WriteVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		m_buffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	m_buffer.push_back((uint8_t)value);
+}
+
+void InputRecorder::WriteSigned(int64_t value)
+{
+	// Zigzag: small negative values stay small
+	WriteVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+InputReplay::InputReplay()
+{
+}
+
+bool InputReplay::Open(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (m_data.size() < LOG_HEADER_SIZE)
+		return false;
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (m_data[i] != (uint8_t)LOG_MAGIC[i])
+			return false;
+	}
+	uint32_t version = m_data[4] | (m_data[5] << 8) | (m_data[6] << 16) | ((uint32_t)m_data[7] << 24);
+	if (version != LOG_VERSION)
+		return false;
+
+	Rewind();
+	return true;
+}
+
+bool InputReplay::NextFrame(int64_t previousFrameTicks, int64_t& deltaTicks, std::vector<InputEvent>& events)
+{
+	events.clear();
+
+	uint64_t delta;
+	uint64_t count;
+	if (!ReadVarint(delta) || !ReadVarint(count))
+		return false;
+	deltaTicks = (int64_t)delta;
+
+	for (uint64_t i = 0; i < count; i++)
+	{
+		if (m_readOffset >= m_data.size())
+			return false;
+
+		InputEvent event = {};
+		event.Type = (InputEventType)m_data[m_readOffset++];
+		if (event.Type == InputEventType::MouseMove)
+		{
+			int64_t x;
+			int64_t y;
+			if (!ReadSigned(x) || !ReadSigned(y))
+				return false;
+			event.X = (int16_t)x;
+			event.Y = (int16_t)y;
+		}
+		else
+		{
+			if (m_readOffset >= m_data.size())
+				return false;
+			event.Key = m_data[m_readOffset++];
+		}
+
+		int64_t timeOffset;
+		if (!ReadSigned(timeOffset))
+			return false;
+		event.Time = previousFrameTicks + deltaTicks + timeOffset;
+		events.push_back(event);
+	}
+
+	m_framesRead++;
+	return true;
+}
+
+void InputReplay::Rewind()
+{
+	m_readOffset = LOG_HEADER_SIZE;
+	m_framesRead = 0;
+}
+
+bool InputReplay::ReadVarint(uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (m_readOffset >= m_data.size())
+			return false;
+
+		uint8_t byte = m_data[m_readOffset++];
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+bool InputReplay::ReadSigned(int64_t& value)
+{
+	uint64_t encoded;
+	if (!ReadVarint(encoded))
+		return false;
+	value = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+	return true;
+}
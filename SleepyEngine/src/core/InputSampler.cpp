@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "InputSampler.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+	#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+InputSampler::InputSampler() : m_isRunning(false), m_droppedCount(0)
+{
+}
+
+InputSampler::~InputSampler()
+{
+	Stop();
+	if (m_waitTimer != nullptr)
+		CloseHandle(m_waitTimer);
+}
+
+bool InputSampler::Init(HWND window, double sampleRate)
+{
+	if (sampleRate <= 0.0)
+		return false;
+
+	m_window = window;
+	m_periodTicks = Timer::SecondsToTicks(1.0 / sampleRate);
+	m_moveCoalesceTicks = Timer::SecondsToTicks(MOVE_COALESCE_SECONDS);
+	m_hasPendingMove = false;
+	m_events.Init(QUEUE_CAPACITY);
+
+	// Plain waitable timers and Sleep are rounded to the scheduler period, too coarse at 1 kHz
+	m_waitTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	for (int i = 0; i < 256; i++)
+	{
+		m_isWatched[i] = false;
+		m_keyStates[i] = 0;
+	}
+	m_watchedKeys.clear();
+
+	// Same keys the polling Input used to know about
+	const char* keys = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+	for (int i = 0; keys[i] != 0; i++)
+		Watch(keys[i]);
+	int virtualKeys[] = {
+		VK_LBUTTON, VK_RBUTTON, VK_MBUTTON,
+		VK_RETURN, VK_SPACE, VK_DELETE, VK_BACK,
+		VK_CONTROL, VK_SHIFT, VK_MENU, VK_TAB, VK_ESCAPE,
+		VK_LEFT, VK_RIGHT, VK_UP, VK_DOWN
+	};
+	for (int i = 0; i < _countof(virtualKeys); i++)
+		Watch(virtualKeys[i]);
+	return true;
+}
+
+void InputSampler::Watch(int key)
+{
+	if (key < 0 || key >= 256 || m_isWatched[key])
+		return;
+
+	m_isWatched[key] = true;
+	m_watchedKeys.push_back((uint8_t)key);
+}
+
+void InputSampler::Start()
+{
+	if (m_isRunning.exchange(true))
+		return;
+
+	m_thread = std::thread(&InputSampler::ThreadMain, this);
+}
+
+void InputSampler::Stop()
+{
+	if (!m_isRunning.exchange(false))
+		return;
+
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+void InputSampler::ThreadMain()
+{
+	PROFILE_THREAD_NAME("Input");
+	// Late samples are late timestamps, this thread must win against the game threads
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+	int64_t nextSampleTicks = Timer::GetTicks();
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		int64_t now = Timer::GetTicks();
+		Sample(now);
+
+		nextSampleTicks += m_periodTicks;
+		// Too far behind (debugger, suspended machine): start over instead of catching up
+		if (now - nextSampleTicks > 8 * m_periodTicks)
+			nextSampleTicks = now + m_periodTicks;
+		WaitUntil(nextSampleTicks);
+	}
+	FlushMove();
+}
+
+void InputSampler::Sample(int64_t time)
+{
+	InputEvent event = {};
+	event.Time = time;
+
+	if (GetForegroundWindow() != m_window)
+	{
+		if (!m_wasForeground)
+			return;
+
+		// Keys released in another window would stay down
+		if (!FlushMove())
+			return;
+		bool isReleased = true;
+		event.Type = InputEventType::KeyUp;
+		for (int i = 0; i < m_watchedKeys.size(); i++)
+		{
+			uint8_t key = m_watchedKeys[i];
+			if (m_keyStates[key] == 0)
+				continue;
+
+			event.Key = key;
+			if (Emit(event))
+				m_keyStates[key] = 0;
+			else
+				isReleased = false;
+		}
+		// Retried on the next sample until every key made it to the queue
+		m_wasForeground = !isReleased;
+		return;
+	}
+	m_wasForeground = true;
+
+	for (int i = 0; i < m_watchedKeys.size(); i++)
+	{
+		uint8_t key = m_watchedKeys[i];
+		uint8_t isDown = (GetAsyncKeyState(key) & 0x8000) != 0 ? 1 : 0;
+		if (isDown == m_keyStates[key])
+			continue;
+
+		// The move happened before this edge
+		if (!FlushMove())
+			break;
+		event.Type = isDown ? InputEventType::KeyDown : InputEventType::KeyUp;
+		event.Key = key;
+		if (Emit(event))
+			m_keyStates[key] = isDown;
+	}
+
+	POINT cursor;
+	if (GetCursorPos(&cursor) && ScreenToClient(m_window, &cursor) && (cursor.x != m_cursor.x || cursor.y != m_cursor.y))
+	{
+		m_cursor = cursor;
+		// Replaces the pending one, the window starts at the first move
+		if (!m_hasPendingMove)
+			m_pendingMoveStart = time;
+		m_pendingMove.Time = time;
+		m_pendingMove.Type = InputEventType::MouseMove;
+		m_pendingMove.Key = 0;
+		m_pendingMove.X = (int16_t)cursor.x;
+		m_pendingMove.Y = (int16_t)cursor.y;
+		m_hasPendingMove = true;
+	}
+	if (m_hasPendingMove && time - m_pendingMoveStart >= m_moveCoalesceTicks)
+		FlushMove();
+}
+
+bool InputSampler::Emit(const InputEvent& event)
+{
+	if (m_events.Push(event))
+		return true;
+
+	m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+bool InputSampler::FlushMove()
+{
+	if (!m_hasPendingMove)
+		return true;
+	if (!Emit(m_pendingMove))
+		return false;
+
+	m_hasPendingMove = false;
+	return true;
+}
+
+void InputSampler::WaitUntil(int64_t ticks)
+{
+	int64_t remaining = ticks - Timer::GetTicks();
+	if (remaining <= 0)
+		return;
+
+	if (m_waitTimer == nullptr)
+	{
+		Sleep(1);
+		return;
+	}
+
+	// Relative due time, in 100 ns units
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -(remaining / 100);
+	if (SetWaitableTimer(m_waitTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(m_waitTimer, INFINITE);
+	else
+		Sleep(1);
+}
@@ -0,0 +1,406 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "MathHelper.h"
+
+thread_local int JobSystem::t_workerIndex = -1;
+thread_local JobSystem::JobPool* JobSystem::t_pJobPool = nullptr;
+thread_local uint64_t JobSystem::t_jobPoolGeneration = 0;
+std::atomic<uint64_t> JobSystem::s_nextGeneration(1);
+
+WorkStealingDeque::WorkStealingDeque() : m_top(0), m_bottom(0)
+{
+	for (int i = 0; i < CAPACITY; i++)
+		m_jobs[i].store(nullptr, std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::Push(Job* pJob)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= CAPACITY)
+		return false;
+
+	m_jobs[bottom & (CAPACITY - 1)].store(pJob, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	return true;
+}
+
+Job* WorkStealingDeque::Pop()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* pJob = m_jobs[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last job: race against the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			pJob = nullptr;
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+bool WorkStealingDeque::IsEmpty() const
+{
+	return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+}
+
+Job* WorkStealingDeque::Steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+
+	Job* pJob = m_jobs[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	// Lost the race against the owner or another thief
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return pJob;
+}
+
+JobSystem::JobSystem() : m_isRunning(false), m_sharedQueueSize(0), m_sleepingCount(0)
+{
+	m_generation = s_nextGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+bool JobSystem::Init(int workerCount)
+{
+	if (workerCount <= 0)
+		workerCount = MathHelper::Max((int)std::thread::hardware_concurrency(), 1);
+
+	m_workerCount = workerCount;
+	m_isRunning.store(true);
+
+	m_workers.clear();
+	for (int i = 0; i < m_workerCount; i++)
+	{
+		m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+		m_workers[i]->Random = 0x9E3779B9u * (i + 1);
+	}
+
+	// The calling thread is worker 0
+	t_workerIndex = 0;
+	for (int i = 1; i < m_workerCount; i++)
+		m_workers[i]->Thread = std::thread(&JobSystem::WorkerMain, this, i);
+
+	return true;
+}
+
+void JobSystem::Shutdown()
+{
+	if (!m_isRunning.exchange(false))
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.notify_all();
+	}
+	for (int i = 1; i < m_workers.size(); i++)
+	{
+		if (m_workers[i]->Thread.joinable())
+			m_workers[i]->Thread.join();
+	}
+	m_workers.clear();
+	m_workerCount = 0;
+	t_workerIndex = -1;
+	if (t_jobPoolGeneration == m_generation)
+	{
+		t_pJobPool = nullptr;
+		t_jobPoolGeneration = 0;
+	}
+}
+
+void JobSystem::Run(JobFunction function, void* pData, JobCounter* pCounter)
+{
+	Submit(function, pData, 0, 0, 0, pCounter);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, JobFunction function, void* pData, JobCounter* pCounter)
+{
+	Job* pJob = AllocateJob();
+	pJob->Function = function;
+	pJob->pData = pData;
+	pJob->Begin = 0;
+	pJob->End = 0;
+	pJob->GrainSize = 0;
+	pJob->pCounter = pCounter;
+	if (pCounter != nullptr)
+		pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		// Finish() takes the same lock before starting the continuations, after the count reached 0
+		std::lock_guard<std::mutex> lock(dependency.m_continuationMutex);
+		if (dependency.m_value.load(std::memory_order_acquire) != 0)
+		{
+			dependency.m_continuations.push_back(pJob);
+			return;
+		}
+	}
+	// Same as Finish: the last jobs of dependency leave it before the continuation can complete
+	while (!dependency.IsDone())
+		std::this_thread::yield();
+	Push(pJob);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	PROFILE_FUNCTION();
+	// Help instead of blocking
+	while (!counter.IsDone())
+	{
+		Job* pJob = GetJob();
+		if (pJob != nullptr)
+			Execute(pJob);
+		else
+			std::this_thread::yield();
+	}
+}
+
+int JobSystem::GetWorkerIndex()
+{
+	return t_workerIndex;
+}
+
+void JobSystem::Submit(JobFunction function, void* pData, int begin, int end, int grainSize, JobCounter* pCounter)
+{
+	Job* pJob = AllocateJob();
+	pJob->Function = function;
+	pJob->pData = pData;
+	pJob->Begin = begin;
+	pJob->End = end;
+	pJob->GrainSize = grainSize;
+	pJob->pCounter = pCounter;
+	if (pCounter != nullptr)
+		pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+	Push(pJob);
+}
+
+void JobSystem::Push(Job* pJob)
+{
+	int workerIndex = t_workerIndex;
+	if (workerIndex >= 0 && workerIndex < m_workerCount)
+	{
+		// Full deque: run it right away rather than dropping it
+		if (!m_workers[workerIndex]->Deque.Push(pJob))
+		{
+			Execute(pJob);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_sharedQueueMutex);
+		m_sharedQueue.push_back(pJob);
+		m_sharedQueueSize.fetch_add(1, std::memory_order_release);
+	}
+
+	if (m_sleepingCount.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.notify_one();
+	}
+}
+
+JobSystem::JobPool* JobSystem::GetJobPool()
+{
+	if (t_pJobPool != nullptr && t_jobPoolGeneration == m_generation)
+		return t_pJobPool;
+
+	// One pool per thread and job system: a thread switching between systems finds its pool back
+	std::lock_guard<std::mutex> lock(m_poolMutex);
+	JobPool*& pPool = m_threadPools[std::this_thread::get_id()];
+	if (pPool == nullptr)
+	{
+		m_pools.push_back(std::unique_ptr<JobPool>(new JobPool()));
+		pPool = m_pools.back().get();
+	}
+	t_pJobPool = pPool;
+	t_jobPoolGeneration = m_generation;
+	return pPool;
+}
+
+Job* JobSystem::AllocateJob()
+{
+	// Ring allocation, a slot is reused after MAX_JOBS_IN_FLIGHT allocations on the same thread.
+	// Slots still in flight are skipped, and when the whole ring is, the thread runs jobs until one finishes.
+	while (true)
+	{
+		JobPool* pPool = GetJobPool();
+		for (int i = 0; i < MAX_JOBS_IN_FLIGHT; i++)
+		{
+			Job* pJob = &pPool->Jobs[pPool->NextIndex % MAX_JOBS_IN_FLIGHT];
+			pPool->NextIndex++;
+			if (pJob->IsInFlight.load(std::memory_order_acquire))
+				continue;
+
+			pJob->IsInFlight.store(true, std::memory_order_relaxed);
+			return pJob;
+		}
+
+		Job* pJob = GetJob();
+		if (pJob != nullptr)
+			Execute(pJob);
+		else
+			std::this_thread::yield();
+	}
+}
+
+Job* JobSystem::GetJob()
+{
+	int workerIndex = t_workerIndex;
+	if (workerIndex >= 0 && workerIndex < m_workerCount)
+	{
+		Job* pJob = m_workers[workerIndex]->Deque.Pop();
+		if (pJob != nullptr)
+			return pJob;
+	}
+
+	if (m_sharedQueueSize.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sharedQueueMutex);
+		if (!m_sharedQueue.empty())
+		{
+			Job* pJob = m_sharedQueue.back();
+			m_sharedQueue.pop_back();
+			m_sharedQueueSize.fetch_sub(1, std::memory_order_relaxed);
+			return pJob;
+		}
+	}
+
+	if (workerIndex < 0 || workerIndex >= m_workerCount)
+		return nullptr;
+
+	// Steal, starting from a random victim so thieves do not all hit the same worker
+	uint32_t& random = m_workers[workerIndex]->Random;
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	int start = (int)(random % (uint32_t)m_workerCount);
+	for (int i = 0; i < m_workerCount; i++)
+	{
+		int victim = (start + i) % m_workerCount;
+		if (victim == workerIndex)
+			continue;
+
+		Job* pJob = m_workers[victim]->Deque.Steal();
+		if (pJob != nullptr)
+			return pJob;
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* pJob)
+{
+	if (pJob->GrainSize <= 0)
+	{
+		pJob->Function(pJob->pData, pJob->Begin, pJob->End);
+		Finish(pJob);
+		return;
+	}
+
+	// Lazy binary splitting: the upper half of the range is only given away when the local
+	// deque is empty, which means other workers took everything and may be starving
+	int begin = pJob->Begin;
+	int end = pJob->End;
+	int workerIndex = t_workerIndex;
+	bool canSplit = workerIndex >= 0 && workerIndex < m_workerCount;
+	while (begin < end)
+	{
+		if (canSplit && end - begin > pJob->GrainSize && m_workers[workerIndex]->Deque.IsEmpty())
+		{
+			int middle = begin + (end - begin) / 2;
+			Submit(pJob->Function, pJob->pData, middle, end, pJob->GrainSize, pJob->pCounter);
+			end = middle;
+			continue;
+		}
+
+		int chunkEnd = MathHelper::Min(begin + pJob->GrainSize, end);
+		pJob->Function(pJob->pData, begin, chunkEnd);
+		begin = chunkEnd;
+	}
+	Finish(pJob);
+}
+
+void JobSystem::Finish(Job* pJob)
+{
+	JobCounter* pCounter = pJob->pCounter;
+	// The slot can be reused from here
+	pJob->IsInFlight.store(false, std::memory_order_release);
+	if (pCounter == nullptr)
+		return;
+
+	// Keeps IsDone false until the continuations are detached, a waiter may free the counter right after
+	pCounter->m_finishingCount.fetch_add(1, std::memory_order_acq_rel);
+	std::vector<Job*> continuations;
+	if (pCounter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		// Last job of the group: start what was waiting on it
+		{
+			std::lock_guard<std::mutex> lock(pCounter->m_continuationMutex);
+			continuations.swap(pCounter->m_continuations);
+		}
+		// The other jobs of the group may still be in here. Whoever waits on the continuations
+		// can free the counter, so they only start once this is the last job touching it.
+		// Without continuations there is nothing to hold: the count also drops to 0 between
+		// two Run calls of a group still being submitted.
+		while (!continuations.empty() && pCounter->m_finishingCount.load(std::memory_order_acquire) != 1)
+			std::this_thread::yield();
+	}
+	// Last access to the counter
+	pCounter->m_finishingCount.fetch_sub(1, std::memory_order_acq_rel);
+
+	for (int i = 0; i < continuations.size(); i++)
+		Push(continuations[i]);
+}
+
+void JobSystem::WorkerMain(int workerIndex)
+{
+	t_workerIndex = workerIndex;
+	PROFILE_THREAD_NAME(("Worker " + std::to_string(workerIndex)).c_str());
+
+	int idleLoops = 0;
+	while (m_isRunning.load(std::memory_order_acquire))
+	{
+		Job* pJob = GetJob();
+		if (pJob != nullptr)
+		{
+			Execute(pJob);
+			idleLoops = 0;
+			continue;
+		}
+
+		// Spin a little before sleeping, jobs often come in bursts
+		if (++idleLoops < 64)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingCount.fetch_add(1, std::memory_order_acq_rel);
+		// Timeout: a push racing with the sleep may not see this worker as sleeping
+		m_wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+		m_sleepingCount.fetch_sub(1, std::memory_order_acq_rel);
+		idleLoops = 0;
+	}
+}
@@ -0,0 +1,73 @@
+#include "LinearRing.h"
+
+LinearRing::LinearRing() : m_head(0), m_tail(0), m_failedCount(0)
+{
+}
+
+void LinearRing::Init(uint64_t capacity)
+{
+	m_capacity = capacity;
+	m_head.store(0);
+	m_tail.store(0);
+	m_failedCount.store(0);
+	m_pendingFirst = 0;
+	m_pendingCount = 0;
+}
+
+void LinearRing::Retire(uint64_t completedFenceValue)
+{
+	while (m_pendingCount > 0)
+	{
+		const PendingFrame& frame = m_pendingFrames[m_pendingFirst];
+		if (frame.FenceValue > completedFenceValue)
+			break;
+		m_tail.store(frame.End, std::memory_order_release);
+		m_pendingFirst = (m_pendingFirst + 1) % MAX_PENDING_FRAMES;
+		m_pendingCount--;
+	}
+}
+
+void LinearRing::EndFrame(uint64_t fenceValue)
+{
+	uint64_t end = m_head.load(std::memory_order_acquire);
+	if (m_pendingCount == MAX_PENDING_FRAMES)
+	{
+		PendingFrame& last = m_pendingFrames[(m_pendingFirst + m_pendingCount - 1) % MAX_PENDING_FRAMES];
+		last.FenceValue = fenceValue;
+		last.End = end;
+		return;
+	}
+
+	PendingFrame& frame = m_pendingFrames[(m_pendingFirst + m_pendingCount) % MAX_PENDING_FRAMES];
+	frame.FenceValue = fenceValue;
+	frame.End = end;
+	m_pendingCount++;
+}
+
+uint64_t LinearRing::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (m_capacity == 0 || size > m_capacity)
+	{
+		m_failedCount.fetch_add(1, std::memory_order_relaxed);
+		return INVALID_OFFSET;
+	}
+
+	uint64_t head = m_head.load(std::memory_order_relaxed);
+	uint64_t offset;
+	while (true)
+	{
+		offset = (head + alignment - 1) & ~(alignment - 1);
+		// Skips the end of the ring rather than splitting the allocation
+		uint64_t physicalOffset = offset % m_capacity;
+		if (physicalOffset + size > m_capacity)
+			offset += m_capacity - physicalOffset;
+
+		if (offset + size - m_tail.load(std::memory_order_acquire) > m_capacity)
+		{
+			m_failedCount.fetch_add(1, std::memory_order_relaxed);
+			return INVALID_OFFSET;
+		}
+		if (m_head.compare_exchange_weak(head, offset + size, std::memory_order_acq_rel, std::memory_order_relaxed))
+			return offset % m_capacity;
+	}
+}
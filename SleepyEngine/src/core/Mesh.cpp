@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "Mesh.h"
+#include "Rhi.h"
+#include <cstring>
+
+std::atomic<uint32_t> Mesh::s_nextSortId{ 0 };
+
+Mesh::Mesh()
+{
+	m_sortId = s_nextSortId.fetch_add(1, std::memory_order_relaxed);
+}
+
+Mesh::~Mesh()
+{
+	delete m_pVertexBuffer;
+	delete m_pIndexBuffer;
+}
+
+bool Mesh::Init(RhiDevice* pDevice, const Vertex* pVertices, int vertexCount, const uint32_t* pIndices, int indexCount)
+{
+	RhiBufferDesc desc;
+	desc.HeapType = RhiHeapType::Upload;
+
+	desc.Size = sizeof(Vertex) * vertexCount;
+	m_pVertexBuffer = pDevice->CreateBuffer(desc);
+	desc.Size = sizeof(uint32_t) * indexCount;
+	m_pIndexBuffer = pDevice->CreateBuffer(desc);
+	if (m_pVertexBuffer == nullptr || m_pIndexBuffer == nullptr)
+		return false;
+
+	// The null backend keeps no memory for its buffers
+	void* pVertexData = m_pVertexBuffer->Map();
+	void* pIndexData = m_pIndexBuffer->Map();
+	if (pVertexData != nullptr)
+		memcpy(pVertexData, pVertices, sizeof(Vertex) * vertexCount);
+	if (pIndexData != nullptr)
+		memcpy(pIndexData, pIndices, sizeof(uint32_t) * indexCount);
+
+	m_vertexCount = vertexCount;
+	m_indexCount = indexCount;
+	return true;
+}
+
+Mesh* Mesh::CreateBox(RhiDevice* pDevice, const DirectX::XMFLOAT4& color)
+{
+	Vertex vertices[8];
+	for (int i = 0; i < 8; i++)
+	{
+		vertices[i].Pos = DirectX::XMFLOAT3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+		vertices[i].Color = color;
+	}
+
+	// Clockwise seen from outside, x = bit 0, y = bit 1, z = bit 2
+	uint32_t indices[36] =
+	{
+		0, 2, 3, 0, 3, 1, // -z
+		4, 5, 7, 4, 7, 6, // +z
+		0, 4, 6, 0, 6, 2, // -x
+		1, 3, 7, 1, 7, 5, // +x
+		0, 1, 5, 0, 5, 4, // -y
+		2, 6, 7, 2, 7, 3, // +y
+	};
+
+	Mesh* pMesh = new Mesh();
+	if (!pMesh->Init(pDevice, vertices, 8, indices, 36))
+	{
+		delete pMesh;
+		return nullptr;
+	}
+	return pMesh;
+}
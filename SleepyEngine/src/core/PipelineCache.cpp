@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "PipelineCache.h"
+#include "JobSystem.h"
+#include "Hash.h"
+#include "Profiler.h"
+
+struct PipelineCache::Entry
+{
+	PipelineCache* pCache;
+	uint64_t Key;
+	// Points to the copies below
+	RhiPipelineDesc Desc;
+	std::vector<uint8_t> VertexShader;
+	std::vector<uint8_t> PixelShader;
+	std::atomic<RhiPipeline*> pPipeline{ nullptr };
+	std::atomic<bool> IsReady{ false };
+	// Creation job, when there is one
+	JobCounter Counter;
+};
+
+PipelineCache::PipelineCache()
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+	// Also waits for the creation jobs to finish with their counter, before deleting the entries
+	WaitAll();
+	for (auto& entry : m_entries)
+	{
+		delete entry.second->pPipeline.load();
+		delete entry.second;
+	}
+}
+
+void PipelineCache::Init(RhiDevice* pDevice, JobSystem* pJobSystem)
+{
+	m_pDevice = pDevice;
+	m_pJobSystem = pJobSystem;
+}
+
+bool PipelineCache::SetCacheDirectory(const std::string& directory)
+{
+	return m_blobCache.Init(directory, ".pso");
+}
+
+RhiPipeline* PipelineCache::GetOrCreate(const RhiPipelineDesc& desc)
+{
+	bool isNew;
+	Entry* pEntry = FindOrAdd(desc, isNew);
+	if (isNew)
+		Create(pEntry);
+	else
+		WaitFor(pEntry);
+	return pEntry->pPipeline.load(std::memory_order_acquire);
+}
+
+uint64_t PipelineCache::CreateAsync(const RhiPipelineDesc& desc)
+{
+	bool isNew;
+	Entry* pEntry = FindOrAdd(desc, isNew);
+	if (isNew && m_pJobSystem != nullptr)
+		m_pJobSystem->Run(&CreateJob, pEntry, &pEntry->Counter);
+	else if (isNew)
+		Create(pEntry);
+	return pEntry->Key;
+}
+
+RhiPipeline* PipelineCache::Find(uint64_t key) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_entries.find(key);
+	if (found == m_entries.end())
+		return nullptr;
+	return found->second->pPipeline.load(std::memory_order_acquire);
+}
+
+void PipelineCache::WaitAll()
+{
+	std::vector<Entry*> entries;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& entry : m_entries)
+			entries.push_back(entry.second);
+	}
+	for (int i = 0; i < entries.size(); i++)
+		WaitFor(entries[i]);
+}
+
+uint64_t PipelineCache::ComputeKey(const RhiPipelineDesc& desc) const
+{
+	uint64_t hash = Hash::Integer((uint64_t)m_pDevice->GetBackend());
+	hash = Hash::Integer(m_pDevice->GetPipelineStateHash(), hash);
+	hash = Hash::Integer(desc.VertexShader.Size, hash);
+	hash = Hash::Bytes(desc.VertexShader.pData, desc.VertexShader.Size, hash);
+	hash = Hash::Integer(desc.PixelShader.Size, hash);
+	hash = Hash::Bytes(desc.PixelShader.pData, desc.PixelShader.Size, hash);
+	hash = Hash::Integer(desc.ConstantBufferCount, hash);
+	hash = Hash::Integer(desc.IsDepthTested ? 1 : 0, hash);
+	// The cached blob is an input of the driver, not of the pipeline
+	return hash != 0 ? hash : 1;
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+	PipelineCacheStats stats;
+	stats.Hits = m_hitCount.load(std::memory_order_relaxed);
+	stats.Created = m_createdCount.load(std::memory_order_relaxed);
+	stats.FromDisk = m_fromDiskCount.load(std::memory_order_relaxed);
+	stats.Failed = m_failedCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
+int PipelineCache::GetPipelineCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_entries.size();
+}
+
+PipelineCache::Entry* PipelineCache::FindOrAdd(const RhiPipelineDesc& desc, bool& isNew)
+{
+	// Hashed outside the lock, the bytecode can be a few KB
+	uint64_t key = ComputeKey(desc);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_entries.find(key);
+	isNew = found == m_entries.end();
+	if (!isNew)
+	{
+		m_hitCount.fetch_add(1, std::memory_order_relaxed);
+		return found->second;
+	}
+
+	Entry* pEntry = new Entry();
+	pEntry->pCache = this;
+	pEntry->Key = key;
+	const uint8_t* pVertexShader = (const uint8_t*)desc.VertexShader.pData;
+	const uint8_t* pPixelShader = (const uint8_t*)desc.PixelShader.pData;
+	pEntry->VertexShader.assign(pVertexShader, pVertexShader + desc.VertexShader.Size);
+	pEntry->PixelShader.assign(pPixelShader, pPixelShader + desc.PixelShader.Size);
+	pEntry->Desc = desc;
+	// Empty bytecode stays nullptr, backends check it
+	pEntry->Desc.VertexShader.pData = desc.VertexShader.pData != nullptr ? pEntry->VertexShader.data() : nullptr;
+	pEntry->Desc.PixelShader.pData = desc.PixelShader.pData != nullptr ? pEntry->PixelShader.data() : nullptr;
+	pEntry->Desc.CachedBlob = RhiShaderBytecode();
+	m_entries[key] = pEntry;
+	return pEntry;
+}
+
+void PipelineCache::Create(Entry* pEntry)
+{
+	PROFILE_FUNCTION();
+	RhiPipelineDesc desc = pEntry->Desc;
+	std::vector<uint8_t> blob;
+	if (m_blobCache.Load(pEntry->Key, blob))
+		desc.CachedBlob = { blob.data(), blob.size() };
+
+	// Can run on a worker: an exception would end the program, and WaitFor needs IsReady either way
+	RhiPipeline* pPipeline = nullptr;
+	try
+	{
+		pPipeline = m_pDevice->CreatePipeline(desc);
+	}
+	catch (...)
+	{
+		pPipeline = nullptr;
+	}
+	if (pPipeline == nullptr)
+	{
+		// Nothing is drawn with it, at least say why. Written at once without a flush, like the
+		// D3D12 backend does from the workers.
+		std::ostringstream message;
+		message << "PipelineCache: the backend rejected pipeline " << std::hex << pEntry->Key << "\n";
+		std::cout << message.str();
+		m_failedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	else if (pPipeline->IsFromCachedBlob())
+		m_fromDiskCount.fetch_add(1, std::memory_order_relaxed);
+	else if (m_blobCache.IsEnabled() && pPipeline->GetCachedBlob(blob))
+		m_blobCache.Store(pEntry->Key, blob.data(), blob.size());
+	if (pPipeline != nullptr)
+		m_createdCount.fetch_add(1, std::memory_order_relaxed);
+
+	pEntry->pPipeline.store(pPipeline, std::memory_order_release);
+	pEntry->IsReady.store(true, std::memory_order_release);
+}
+
+void PipelineCache::WaitFor(Entry* pEntry)
+{
+	// Created by a job, or by GetOrCreate on another thread
+	while (!pEntry->IsReady.load(std::memory_order_acquire))
+	{
+		if (m_pJobSystem != nullptr && !pEntry->Counter.IsDone())
+			m_pJobSystem->Wait(pEntry->Counter);
+		else
+			std::this_thread::yield();
+	}
+	// IsReady is set inside the job, the worker still touches Counter after it
+	if (m_pJobSystem != nullptr)
+		m_pJobSystem->Wait(pEntry->Counter);
+}
+
+void PipelineCache::CreateJob(void* pData, int begin, int end)
+{
+	Entry* pEntry = (Entry*)pData;
+	pEntry->pCache->Create(pEntry);
+}
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "RenderQueue.h"
+#include "Rhi.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include <cstring>
+
+void RenderQueueStats::Add(const RenderQueueStats& stats)
+{
+	ItemCount += stats.ItemCount;
+	DrawCalls += stats.DrawCalls;
+	PipelineChanges += stats.PipelineChanges;
+	MaterialChanges += stats.MaterialChanges;
+	MeshChanges += stats.MeshChanges;
+	DroppedItems += stats.DroppedItems;
+}
+
+RenderQueue::RenderQueue()
+{
+}
+
+void RenderQueue::Init(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+void RenderQueue::Clear()
+{
+	m_items.clear();
+	m_keys.clear();
+	m_batches.clear();
+	m_constantSize = 0;
+}
+
+uint64_t RenderQueue::MakeKey(RenderPassType pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId, float depth)
+{
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	uint64_t quantizedDepth = (uint64_t)(depth * (float)((1 << DEPTH_BITS) - 1));
+	uint64_t pipeline = pipelineId & ((1 << PIPELINE_BITS) - 1);
+	uint64_t material = materialId & ((1 << MATERIAL_BITS) - 1);
+	uint64_t mesh = meshId & ((1 << MESH_BITS) - 1);
+
+	uint64_t key = (uint64_t)pass << (64 - PASS_BITS);
+	if (pass == RenderPassType::Transparent)
+	{
+		// Far first, state only breaks ties
+		uint64_t invertedDepth = ((1 << DEPTH_BITS) - 1) - quantizedDepth;
+		key |= invertedDepth << (64 - PASS_BITS - DEPTH_BITS);
+		key |= pipeline << (MATERIAL_BITS + MESH_BITS);
+		key |= material << MESH_BITS;
+		key |= mesh;
+	}
+	else
+	{
+		key |= pipeline << (MATERIAL_BITS + MESH_BITS + DEPTH_BITS);
+		key |= material << (MESH_BITS + DEPTH_BITS);
+		key |= mesh << DEPTH_BITS;
+		key |= quantizedDepth;
+	}
+	return key;
+}
+
+int RenderQueue::Partition(int batchCount, int maxRangeCount, int minBatchesPerRange, int* pRangeBegins)
+{
+	int rangeCount = minBatchesPerRange > 0 ? batchCount / minBatchesPerRange : batchCount;
+	rangeCount = rangeCount < maxRangeCount ? rangeCount : maxRangeCount;
+	rangeCount = rangeCount > 1 ? rangeCount : 1;
+
+	// Recording costs about the same per batch, the first ranges get the remainder
+	int rangeSize = batchCount / rangeCount;
+	int remainder = batchCount % rangeCount;
+	pRangeBegins[0] = 0;
+	for (int i = 0; i < rangeCount; i++)
+		pRangeBegins[i + 1] = pRangeBegins[i] + rangeSize + (i < remainder ? 1 : 0);
+	return rangeCount;
+}
+
+void RenderQueue::Add(RenderPassType pass, float depth, const RenderItem& item)
+{
+	SortKey key;
+	key.Key = MakeKey(pass, item.pPipeline->GetSortId(), item.MaterialId, item.pMesh->GetSortId(), depth);
+	key.Index = (uint32_t)m_items.size();
+	m_keys.push_back(key);
+	m_items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	PROFILE_FUNCTION();
+	m_sortScratch.resize(m_keys.size());
+	RadixSort::Sort(m_keys.data(), m_sortScratch.data(), (int)m_keys.size(), m_pJobSystem);
+	BuildBatches();
+}
+
+void RenderQueue::BuildBatches()
+{
+	m_batches.clear();
+	m_constantSize = 0;
+	int keyCount = (int)m_keys.size();
+	int i = 0;
+	while (i < keyCount)
+	{
+		// Pointers and not the ids of the key, they may wrap
+		const RenderItem& first = m_items[m_keys[i].Index];
+		int count = 1;
+		while (i + count < keyCount && count < MAX_INSTANCES_PER_DRAW)
+		{
+			const RenderItem& item = m_items[m_keys[i + count].Index];
+			if (item.pPipeline != first.pPipeline || item.MaterialId != first.MaterialId || item.pMesh != first.pMesh)
+				break;
+			count++;
+		}
+
+		Batch batch;
+		batch.FirstKey = i;
+		batch.InstanceCount = count;
+		batch.ConstantOffset = m_constantSize;
+		m_batches.push_back(batch);
+		m_constantSize += (count * sizeof(InstanceData) + CONSTANT_ALIGNMENT - 1) & ~(CONSTANT_ALIGNMENT - 1);
+		i += count;
+	}
+}
+
+void RenderQueue::WriteInstances(int firstBatch, int endBatch, uint8_t* pConstantData) const
+{
+	for (int i = firstBatch; i < endBatch; i++)
+	{
+		const Batch& batch = m_batches[i];
+		InstanceData* pInstances = (InstanceData*)(pConstantData + batch.ConstantOffset);
+		for (int j = 0; j < batch.InstanceCount; j++)
+			memcpy(&pInstances[j], &m_items[m_keys[batch.FirstKey + j].Index].Instance, sizeof(InstanceData));
+	}
+}
+
+void RenderQueue::WriteConstants(uint8_t* pConstantData) const
+{
+	PROFILE_FUNCTION();
+	// Batches write disjoint ranges
+	int batchCount = (int)m_batches.size();
+	if (m_pJobSystem != nullptr && (int)m_keys.size() >= MIN_PARALLEL_COUNT)
+		m_pJobSystem->ParallelFor(batchCount, 1, [this, pConstantData](int begin, int end) { WriteInstances(begin, end, pConstantData); });
+	else
+		WriteInstances(0, batchCount, pConstantData);
+}
+
+void RenderQueue::Record(RhiCommandList* pCommandList, int firstBatch, int endBatch, RhiBuffer* pConstantBuffer, uint64_t constantOffset, RenderQueueStats& stats) const
+{
+	PROFILE_FUNCTION();
+	RhiPipeline* pPipeline = nullptr;
+	const Mesh* pMesh = nullptr;
+	int materialId = -1;
+	for (int i = firstBatch; i < endBatch; i++)
+	{
+		const Batch& batch = m_batches[i];
+		const RenderItem& item = m_items[m_keys[batch.FirstKey].Index];
+		if (item.pPipeline != pPipeline)
+		{
+			pCommandList->SetPipeline(item.pPipeline);
+			pPipeline = item.pPipeline;
+			stats.PipelineChanges++;
+		}
+		if (item.MaterialId != materialId)
+		{
+			materialId = item.MaterialId;
+			stats.MaterialChanges++;
+		}
+		if (item.pMesh != pMesh)
+		{
+			pCommandList->SetVertexBuffer(item.pMesh->GetVertexBuffer(), 0, sizeof(Vertex));
+			pCommandList->SetIndexBuffer(item.pMesh->GetIndexBuffer(), 0);
+			pMesh = item.pMesh;
+			stats.MeshChanges++;
+		}
+
+		pCommandList->SetConstantBuffer(0, pConstantBuffer, constantOffset + batch.ConstantOffset);
+		pCommandList->DrawIndexed(pMesh->GetIndexCount(), batch.InstanceCount, 0, 0);
+		stats.ItemCount += batch.InstanceCount;
+		stats.DrawCalls++;
+	}
+}
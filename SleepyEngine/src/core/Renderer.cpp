@@ -0,0 +1,192 @@
+#include "pch.h"
+#include "Renderer.h"
+#include "PhysicsWorld.h"
+#include "Collider.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+
+Renderer::Renderer()
+{
+}
+
+Renderer::~Renderer()
+{
+	// The command lists and the upload ring may still be used by frames in flight
+	if (m_pDevice != nullptr)
+		Flush();
+	for (int i = 0; i < m_commandLists.size(); i++)
+		delete m_commandLists[i];
+	delete m_pBoxMesh;
+}
+
+bool Renderer::Init(RhiDevice* pDevice, RhiSwapChain* pSwapChain, int framesInFlight, JobSystem* pJobSystem, uint64_t frameUploadSize)
+{
+	if (pDevice == nullptr || pSwapChain == nullptr)
+		return false;
+
+	m_pDevice = pDevice;
+	m_pSwapChain = pSwapChain;
+	m_pJobSystem = pJobSystem;
+	m_frameRing.Init(pDevice->GetQueue(), framesInFlight);
+
+	int commandListCount = pJobSystem != nullptr ? pJobSystem->GetWorkerCount() : 1;
+	commandListCount = commandListCount < MAX_COMMAND_LISTS ? commandListCount : MAX_COMMAND_LISTS;
+	for (int i = 0; i < commandListCount; i++)
+		m_commandLists.push_back(pDevice->CreateCommandList(m_frameRing.GetFrameCount()));
+	if (!m_uploadRing.Init(pDevice, frameUploadSize * m_frameRing.GetFrameCount()))
+		return false;
+
+	m_renderQueue.Init(pJobSystem);
+	m_pipelineCache.Init(pDevice, pJobSystem);
+	m_pBoxMesh = Mesh::CreateBox(pDevice, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	return m_pBoxMesh != nullptr;
+}
+
+bool Renderer::CreatePipeline(const RhiShaderBytecode& vertexShader, const RhiShaderBytecode& pixelShader, bool isAsync)
+{
+	RhiPipelineDesc desc;
+	desc.VertexShader = vertexShader;
+	desc.PixelShader = pixelShader;
+	// The cache keeps the previous pipelines alive, frames in flight can still use them
+	if (isAsync)
+	{
+		m_pipelineKey = m_pipelineCache.CreateAsync(desc);
+		return true;
+	}
+	if (m_pipelineCache.GetOrCreate(desc) == nullptr)
+		return false;
+	m_pipelineKey = m_pipelineCache.ComputeKey(desc);
+	return true;
+}
+
+void Renderer::Draw(const RenderSnapshot& snapshot)
+{
+	PROFILE_FUNCTION();
+	m_currentFrameSlot = m_frameRing.BeginFrame();
+	m_uploadRing.Retire(m_pDevice->GetQueue()->GetCompletedValue());
+
+	m_renderQueue.Clear();
+	RhiPipeline* pPipeline = m_pipelineKey != 0 ? m_pipelineCache.Find(m_pipelineKey) : nullptr;
+	if (pPipeline != nullptr)
+		QueueBoxes(snapshot, pPipeline);
+	m_renderQueue.Sort();
+
+	// Everything or nothing: when the frame budget is exhausted, the items are counted as dropped
+	UploadAllocation constants;
+	if (m_renderQueue.GetConstantSize() > 0)
+		AllocateFrameUpload(m_renderQueue.GetConstantSize(), RenderQueue::CONSTANT_ALIGNMENT, constants);
+	int batchCount = 0;
+	if (constants.pData != nullptr)
+	{
+		m_renderQueue.WriteConstants(constants.pData);
+		batchCount = m_renderQueue.GetBatchCount();
+	}
+
+	m_recordedListCount = RenderQueue::Partition(batchCount, (int)m_commandLists.size(), MIN_BATCHES_PER_LIST, m_rangeBegins);
+	const float* clearColor = &snapshot.ClearColor.x;
+	if (m_recordedListCount > 1)
+	{
+		m_pJobSystem->ParallelFor(m_recordedListCount, 1, [this, clearColor, &constants](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				RecordList(i, m_rangeBegins[i], m_rangeBegins[i + 1], clearColor, constants);
+		});
+	}
+	else
+		RecordList(0, 0, batchCount, clearColor, constants);
+
+	m_queueStats = RenderQueueStats();
+	for (int i = 0; i < m_recordedListCount; i++)
+		m_queueStats.Add(m_listStats[i]);
+	m_queueStats.DroppedItems = m_renderQueue.GetItemCount() - m_queueStats.ItemCount;
+	m_queueStats.ItemCount = m_renderQueue.GetItemCount();
+
+	m_pDevice->GetQueue()->Submit(m_commandLists.data(), m_recordedListCount);
+	// swap the back and front buffers
+	m_pSwapChain->Present(false);
+	// No wait here, the fence of the frame is checked when its slot comes back around
+	m_frameRing.EndFrame();
+	m_uploadRing.EndFrame(m_frameRing.GetFenceValue(m_currentFrameSlot));
+}
+
+void Renderer::Flush()
+{
+	PROFILE_FUNCTION();
+	FenceTimeline* pQueue = m_pDevice->GetQueue();
+	pQueue->WaitFor(pQueue->Signal());
+}
+
+bool Renderer::AllocateFrameUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+{
+	return m_uploadRing.Allocate(size, alignment, allocation);
+}
+
+void Renderer::RecordList(int index, int firstBatch, int endBatch, const float clearColor[4], const UploadAllocation& constants)
+{
+	PROFILE_FUNCTION();
+	RhiCommandList* pCommandList = m_commandLists[index];
+	pCommandList->Begin(m_currentFrameSlot);
+
+	// Nothing carries over between lists
+	RhiViewport viewport;
+	viewport.Width = (float)m_pSwapChain->GetDesc().Width;
+	viewport.Height = (float)m_pSwapChain->GetDesc().Height;
+	pCommandList->SetViewport(viewport);
+
+	bool isResumed = index > 0;
+	bool isSuspended = index < m_recordedListCount - 1;
+	pCommandList->BeginRenderPass(m_pSwapChain, isResumed ? nullptr : clearColor, isResumed);
+	m_listStats[index] = RenderQueueStats();
+	m_renderQueue.Record(pCommandList, firstBatch, endBatch, constants.pBuffer, constants.Offset, m_listStats[index]);
+	pCommandList->EndRenderPass(isSuspended);
+
+	pCommandList->End();
+}
+
+void Renderer::QueueBoxes(const RenderSnapshot& snapshot, RhiPipeline* pPipeline)
+{
+	PROFILE_FUNCTION();
+	const RhiSwapChainDesc& swapChainDesc = m_pSwapChain->GetDesc();
+	float aspectRatio = (float)swapChainDesc.Width / (float)swapChainDesc.Height;
+	XMVECTOR eye = XMLoadFloat3(&snapshot.CameraPosition);
+	XMVECTOR target = XMLoadFloat3(&snapshot.CameraTarget);
+	XMMATRIX view = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(snapshot.CameraFovY, aspectRatio, 0.1f, 1000.0f);
+	XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	RenderItem item;
+	item.pPipeline = pPipeline;
+	item.pMesh = m_pBoxMesh;
+	XMFLOAT4 awakeColor = XMFLOAT4(0.2f, 0.8f, 0.2f, 1.0f);
+	XMFLOAT4 sleepingColor = XMFLOAT4(0.4f, 0.4f, 0.5f, 1.0f);
+	for (int i = 0; i < snapshot.Boxes.size(); i++)
+	{
+		const RenderBox& box = snapshot.Boxes[i];
+		// The simulation runs at a fixed rate, drawing the last step as is would stutter
+		XMVECTOR center = XMVectorLerp(XMLoadFloat3(&box.PreviousCenter), XMLoadFloat3(&box.Center), snapshot.Alpha);
+		XMMATRIX world = XMMatrixMultiply(
+			XMMatrixScaling(box.HalfExtents.x, box.HalfExtents.y, box.HalfExtents.z),
+			XMMatrixTranslationFromVector(center));
+		XMStoreFloat4x4(&item.Instance.WorldViewProj, XMMatrixTranspose(XMMatrixMultiply(world, viewProj)));
+		item.Instance.Color = box.IsSleeping ? sleepingColor : awakeColor;
+
+		// Depth of the center, good enough to order boxes front to back
+		XMVECTOR projectedCenter = XMVector3TransformCoord(center, viewProj);
+		m_renderQueue.Add(RenderPassType::Opaque, XMVectorGetZ(projectedCenter), item);
+	}
+}
+
+void Renderer::CaptureColliders(const PhysicsWorld& world, RenderSnapshot& snapshot)
+{
+	for (int i = 0; i < world.GetColliderCount(); i++)
+	{
+		const Collider* pCollider = world.GetCollider(i);
+		RenderBox box;
+		box.Center = pCollider->GetCenter();
+		box.PreviousCenter = pCollider->GetPreviousCenter();
+		box.HalfExtents = pCollider->GetHalfExtents();
+		box.IsSleeping = pCollider->IsSleeping();
+		snapshot.Boxes.push_back(box);
+	}
+}
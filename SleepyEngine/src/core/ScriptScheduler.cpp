@@ -0,0 +1,317 @@
+#include "pch.h"
+#include "ScriptScheduler.h"
+#include "Script.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+thread_local CoroutineFramePool::Pool CoroutineFramePool::t_pool;
+
+void* CoroutineFramePool::Allocate(size_t size)
+{
+	int sizeClass = (int)((size + SIZE_CLASS - 1) / SIZE_CLASS) - 1;
+	if (sizeClass >= CLASS_COUNT)
+		return ::operator new(size);
+
+	Pool& pool = t_pool;
+	pool.LiveCount++;
+
+	FreeBlock* pBlock = pool.pFreeLists[sizeClass];
+	if (pBlock != nullptr)
+	{
+		pool.pFreeLists[sizeClass] = pBlock->pNext;
+		return pBlock;
+	}
+
+	size_t blockSize = (sizeClass + 1) * SIZE_CLASS;
+	if (pool.ChunkLeft < blockSize)
+	{
+		// The end of the previous chunk is lost, at most one block
+		pool.Chunks.push_back(std::unique_ptr<char[]>(new char[CHUNK_SIZE]));
+		pool.pChunkCursor = pool.Chunks.back().get();
+		pool.ChunkLeft = CHUNK_SIZE;
+	}
+
+	void* pMemory = pool.pChunkCursor;
+	pool.pChunkCursor += blockSize;
+	pool.ChunkLeft -= blockSize;
+	return pMemory;
+}
+
+void CoroutineFramePool::Free(void* pBlock, size_t size)
+{
+	int sizeClass = (int)((size + SIZE_CLASS - 1) / SIZE_CLASS) - 1;
+	if (sizeClass >= CLASS_COUNT)
+	{
+		::operator delete(pBlock);
+		return;
+	}
+
+	Pool& pool = t_pool;
+	pool.LiveCount--;
+
+	FreeBlock* pFree = (FreeBlock*)pBlock;
+	pFree->pNext = pool.pFreeLists[sizeClass];
+	pool.pFreeLists[sizeClass] = pFree;
+}
+
+ScriptTask& ScriptTask::operator=(ScriptTask&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (m_handle)
+			m_handle.destroy();
+		m_handle = other.m_handle;
+		other.m_handle = nullptr;
+	}
+	return *this;
+}
+
+ScriptTask::~ScriptTask()
+{
+	if (m_handle)
+		m_handle.destroy();
+}
+
+ScriptTask::Handle ScriptTask::Release()
+{
+	Handle handle = m_handle;
+	m_handle = nullptr;
+	return handle;
+}
+
+void NextFrame::await_suspend(ScriptTask::Handle handle)
+{
+	handle.promise().pScheduler->WaitNextFrame(handle);
+}
+
+void WaitForSeconds::await_suspend(ScriptTask::Handle handle)
+{
+	ScriptScheduler* pScheduler = handle.promise().pScheduler;
+	pScheduler->WaitUntilTime(handle, pScheduler->GetTime() + Seconds);
+}
+
+void WaitUntil::await_suspend(ScriptTask::Handle handle)
+{
+	handle.promise().pScheduler->WaitUntil(handle, std::move(Condition));
+}
+
+bool WaitForJob::await_ready() const
+{
+	return pCounter->IsDone();
+}
+
+void WaitForJob::await_suspend(ScriptTask::Handle handle)
+{
+	handle.promise().pScheduler->WaitForJob(handle, pCounter);
+}
+
+ScriptScheduler::ScriptScheduler()
+{
+}
+
+ScriptScheduler::~ScriptScheduler()
+{
+	for (int i = 0; i < m_nextFrameWaits.size(); i++)
+		Destroy(m_nextFrameWaits[i]);
+	for (int i = 0; i < m_timedWaits.size(); i++)
+		Destroy(m_timedWaits[i].Handle);
+	for (int i = 0; i < m_conditionWaits.size(); i++)
+		Destroy(m_conditionWaits[i].Handle);
+	for (int i = 0; i < m_jobWaits.size(); i++)
+		Destroy(m_jobWaits[i].Handle);
+
+	// Their destructor would stop coroutines here
+	for (int i = 0; i < m_scripts.size(); i++)
+		m_scripts[i]->SetScheduler(nullptr);
+}
+
+void ScriptScheduler::Init()
+{
+	m_time = 0.0;
+	m_nextFrameWaits.reserve(1024);
+	m_resumeBatch.reserve(1024);
+}
+
+void ScriptScheduler::Attach(Script* pScript)
+{
+	if (pScript->GetScheduler() == this)
+		return;
+
+	if (pScript->GetScheduler() != nullptr)
+		pScript->GetScheduler()->Detach(pScript);
+	pScript->SetScheduler(this);
+	m_scripts.push_back(pScript);
+}
+
+void ScriptScheduler::Detach(Script* pScript)
+{
+	if (pScript->GetScheduler() != this)
+		return;
+
+	StopAll(pScript);
+	pScript->SetScheduler(nullptr);
+	m_scripts.erase(std::remove(m_scripts.begin(), m_scripts.end(), pScript), m_scripts.end());
+}
+
+void ScriptScheduler::Start(ScriptTask task, Script* pOwner)
+{
+	ScriptTask::Handle handle = task.Release();
+	if (!handle)
+		return;
+
+	handle.promise().pScheduler = this;
+	handle.promise().pOwner = pOwner;
+	m_taskCount++;
+	Resume(handle);
+}
+
+void ScriptScheduler::StopAll(Script* pOwner)
+{
+	// Only marked: a stopped coroutine may be running or about to be resumed by the current
+	// update, and it can only be destroyed once it is back in a queue
+	for (int i = 0; i < m_nextFrameWaits.size(); i++)
+	{
+		if (m_nextFrameWaits[i].promise().pOwner == pOwner)
+			m_nextFrameWaits[i].promise().IsCancelled = true;
+	}
+	for (int i = 0; i < m_timedWaits.size(); i++)
+	{
+		if (m_timedWaits[i].Handle.promise().pOwner == pOwner)
+			m_timedWaits[i].Handle.promise().IsCancelled = true;
+	}
+	for (int i = 0; i < m_conditionWaits.size(); i++)
+	{
+		if (m_conditionWaits[i].Handle.promise().pOwner == pOwner)
+			m_conditionWaits[i].Handle.promise().IsCancelled = true;
+	}
+	for (int i = 0; i < m_jobWaits.size(); i++)
+	{
+		if (m_jobWaits[i].Handle.promise().pOwner == pOwner)
+			m_jobWaits[i].Handle.promise().IsCancelled = true;
+	}
+	for (int i = 0; i < m_resumeBatch.size(); i++)
+	{
+		if (m_resumeBatch[i].promise().pOwner == pOwner)
+			m_resumeBatch[i].promise().IsCancelled = true;
+	}
+	if (m_running && m_running.promise().pOwner == pOwner)
+		m_running.promise().IsCancelled = true;
+
+	// Timers can be far away, free them now instead of when they expire
+	int count = 0;
+	for (int i = 0; i < m_timedWaits.size(); i++)
+	{
+		if (m_timedWaits[i].Handle.promise().IsCancelled)
+			Destroy(m_timedWaits[i].Handle);
+		else
+			m_timedWaits[count++] = m_timedWaits[i];
+	}
+	if (count != m_timedWaits.size())
+	{
+		m_timedWaits.resize(count);
+		std::make_heap(m_timedWaits.begin(), m_timedWaits.end());
+	}
+}
+
+void ScriptScheduler::Update(double time)
+{
+	PROFILE_FUNCTION();
+	m_time = time;
+
+	// Everything is collected before resuming, a coroutine waiting again lands in the next update
+	m_resumeBatch.swap(m_nextFrameWaits);
+
+	while (!m_timedWaits.empty() && m_timedWaits.front().WakeTime <= m_time)
+	{
+		std::pop_heap(m_timedWaits.begin(), m_timedWaits.end());
+		m_resumeBatch.push_back(m_timedWaits.back().Handle);
+		m_timedWaits.pop_back();
+	}
+
+	int count = 0;
+	for (int i = 0; i < m_conditionWaits.size(); i++)
+	{
+		ConditionWait& wait = m_conditionWaits[i];
+		// The condition may reference a stopped script, it is not called anymore
+		if (wait.Handle.promise().IsCancelled || wait.Condition())
+			m_resumeBatch.push_back(wait.Handle);
+		else if (count != i)
+			m_conditionWaits[count++] = std::move(wait);
+		else
+			count++;
+	}
+	m_conditionWaits.resize(count);
+
+	count = 0;
+	for (int i = 0; i < m_jobWaits.size(); i++)
+	{
+		if (m_jobWaits[i].Handle.promise().IsCancelled || m_jobWaits[i].pCounter->IsDone())
+			m_resumeBatch.push_back(m_jobWaits[i].Handle);
+		else
+			m_jobWaits[count++] = m_jobWaits[i];
+	}
+	m_jobWaits.resize(count);
+
+	ResumeBatch();
+}
+
+void ScriptScheduler::WaitNextFrame(ScriptTask::Handle handle)
+{
+	m_nextFrameWaits.push_back(handle);
+}
+
+void ScriptScheduler::WaitUntilTime(ScriptTask::Handle handle, double wakeTime)
+{
+	TimedWait wait;
+	wait.WakeTime = wakeTime;
+	wait.Handle = handle;
+	m_timedWaits.push_back(wait);
+	std::push_heap(m_timedWaits.begin(), m_timedWaits.end());
+}
+
+void ScriptScheduler::WaitUntil(ScriptTask::Handle handle, std::function<bool()> condition)
+{
+	ConditionWait wait;
+	wait.Condition = std::move(condition);
+	wait.Handle = handle;
+	m_conditionWaits.push_back(std::move(wait));
+}
+
+void ScriptScheduler::WaitForJob(ScriptTask::Handle handle, JobCounter* pCounter)
+{
+	JobWait wait;
+	wait.pCounter = pCounter;
+	wait.Handle = handle;
+	m_jobWaits.push_back(wait);
+}
+
+void ScriptScheduler::Resume(ScriptTask::Handle handle)
+{
+	if (handle.promise().IsCancelled)
+	{
+		Destroy(handle);
+		return;
+	}
+
+	// Coroutines can start other coroutines, which are resumed right away
+	ScriptTask::Handle previous = m_running;
+	m_running = handle;
+	handle.resume();
+	m_running = previous;
+
+	if (handle.done())
+		Destroy(handle);
+}
+
+void ScriptScheduler::Destroy(ScriptTask::Handle handle)
+{
+	handle.destroy();
+	m_taskCount--;
+}
+
+void ScriptScheduler::ResumeBatch()
+{
+	for (int i = 0; i < m_resumeBatch.size(); i++)
+		Resume(m_resumeBatch[i]);
+	m_resumeBatch.clear();
+}
@@ -1,6 +1,6 @@
 // SleepyEngine.cpp : Defines the entry point for the application.
 //
-//#include "pch.h"
+#include "pch.h"
 #include "SleepyEngine.h"
 #include "Utils/HResultException.h"
 #include <comdef.h>
@@ -9,6 +9,22 @@
 // I don't know where to put them
 #include "Input.h"
 #include "Timer.h"
+#include "PhysicsWorld.h"
+#include "FramePacer.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Renderer.h"
+#include "ScriptScheduler.h"
+#include "InputLog.h"
+#include "ActionMap.h"
+#include "ShaderCache.h"
+#include "D3DShaderCompiler.h"
+
+// Relative to the game project, the working directory when launched from Visual Studio
+#define COLOR_SHADER_PATH "../SleepyEngine/src/shaders/Color.hlsl"
+#define SHADER_CACHE_DIRECTORY "ShaderCache"
+#define PIPELINE_CACHE_DIRECTORY "PipelineCache"
 
 // Global Variables:
 
@@ -21,206 +37,64 @@ SleepyEngine::SleepyEngine(HINSTANCE hInstance)
     m_hAppInstance = hInstance;
 }
 
-void SleepyEngine::InitD3D()
-{
-#if defined(DEBUG) || defined(_DEBUG)
-    EnableAdditionalD3D12Debug();
-#endif
-    CreateDevice();
-    CreateFence();
-    RecoverDescriptorsSize();
-    Check4xMSAAQualitySupport();
-    CreateCommandObjects();
-    CreateSwapChain();
-    CreateDescriptorHeaps();
-    CreateRenderTargetView();
-    ThrowIfFailed(m_pCommandList->Reset(m_pDirectCmdListAlloc, nullptr));
-    CreateDepthStencilView();
-    SetViewport();
-    SetScissorRect();
-    ThrowIfFailed(m_pCommandList->Close()); 
-    ID3D12CommandList* cmdsLists[] = { m_pCommandList };
-    m_pCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-    FlushCommandQueue();
-}
-
-void SleepyEngine::EnableAdditionalD3D12Debug()
-{
-    ID3D12Debug* pDebugController;
-    ThrowIfFailed(D3D12GetDebugInterface(__uuidof(ID3D12Debug), (void**)&pDebugController)); //should throw error
-    pDebugController->EnableDebugLayer();
-    std::cout << "Debug Layer Enabled" << std::endl;
-}
-
-void SleepyEngine::CreateDevice()
-{
-    ThrowIfFailed(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&m_pDxgiFactory));
-    ThrowIfFailed(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, _uuidof(ID3D12Device), (void**)&m_pDevice));
-    //if failed, check book for "WARP_Adapters".
-}
-
-void SleepyEngine::CreateFence()
-{
-    ThrowIfFailed(m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence), (void**)&m_pFence));
-}
-
-void SleepyEngine::RecoverDescriptorsSize()
-{
-    m_rtvDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    m_dsvDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-    m_cbvSrvUavDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-}
-
-void SleepyEngine::Check4xMSAAQualitySupport()
-{
-    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msQualityLevels; //will likely be moved to private member attribute
-    msQualityLevels.Format = m_backBufferFormat;
-    msQualityLevels.SampleCount = 4;
-    msQualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
-    msQualityLevels.NumQualityLevels = 0;
-    ThrowIfFailed(m_pDevice->CheckFeatureSupport(D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &msQualityLevels, sizeof(msQualityLevels)));
-    m_4xMsaaQuality = msQualityLevels.NumQualityLevels;
-    assert(m_4xMsaaQuality > 0 && "Unexpected MSAA quality level.");
-}
-
-void SleepyEngine::CreateCommandObjects()
-{
-    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    ThrowIfFailed(m_pDevice->CreateCommandQueue(&queueDesc, __uuidof(ID3D12CommandQueue), (void**)&m_pCommandQueue));
-    ThrowIfFailed(m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator), (void**)&m_pDirectCmdListAlloc));
-    ThrowIfFailed(m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_pDirectCmdListAlloc, nullptr, __uuidof(ID3D12CommandList), (void**)&m_pCommandList));
-    
-    // Start off in a closed state. This is because the first time we 
-    // refer to the command list we will Reset it, and it needs to be 
-    // closed before calling Reset.
-
-    ThrowIfFailed(m_pCommandList->Close()); 
-}
-
-void SleepyEngine::CreateSwapChain()
+SleepyEngine::~SleepyEngine()
 {
+    // Destroys the coroutines still suspended, before the systems they may wait on
+    delete m_pScriptScheduler;
+    delete m_pPhysicsWorld;
+    delete m_pFrameStats;
+    delete m_pActionMap;
+    delete m_pInput;
+    // Nothing is in flight on the GPU anymore once Run returned. The renderer waits for its
+    // pipeline jobs and the software device rasterizes on the workers: both before the job system.
+    delete m_pRenderer;
     delete m_pSwapChain;
-    DXGI_SWAP_CHAIN_DESC swapChainDescriptor;
-    swapChainDescriptor.BufferDesc.Width = m_clientWidth;
-    swapChainDescriptor.BufferDesc.Height = m_clientHeight;
-    swapChainDescriptor.BufferDesc.RefreshRate.Numerator = 60;
-    swapChainDescriptor.BufferDesc.RefreshRate.Denominator = 1;
-    swapChainDescriptor.BufferDesc.Format = m_backBufferFormat;
-    swapChainDescriptor.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-    swapChainDescriptor.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-    swapChainDescriptor.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
-    swapChainDescriptor.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
-    swapChainDescriptor.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDescriptor.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
-    swapChainDescriptor.OutputWindow = mhMainWnd;
-    swapChainDescriptor.Windowed = true;
-    swapChainDescriptor.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDescriptor.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-
-    ThrowIfFailed(m_pDxgiFactory->CreateSwapChain(m_pCommandQueue, &swapChainDescriptor, &m_pSwapChain)); //CreateSwapChainForHwnd()
+    delete m_pRhiDevice;
+    // Joins the workers, after everything that could still submit jobs is gone
+    delete m_pJobSystem;
 }
 
-void SleepyEngine::CreateDescriptorHeaps()
+void SleepyEngine::InitRenderer()
 {
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-    rtvHeapDesc.NumDescriptors = SWAP_CHAIN_BUFFER_COUNT;
-    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    rtvHeapDesc.NodeMask = 0;
-    ThrowIfFailed(m_pDevice->CreateDescriptorHeap(&rtvHeapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&m_pRtvHeap));
-
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-    dsvHeapDesc.NumDescriptors = 1;
-    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    dsvHeapDesc.NodeMask = 0;
-    ThrowIfFailed(m_pDevice->CreateDescriptorHeap(&dsvHeapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&m_pDsvHeap));
-}
+    PROFILE_FUNCTION();
+    m_pRhiDevice = CreateRhiDevice(m_renderBackend, m_pJobSystem);
 
-void SleepyEngine::CreateRenderTargetView()
-{
-    //ID3D12Resource* m_pSwapChainBuffer[SWAP_CHAIN_BUFFER_COUNT]; // must be freed when finished
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart());
+    RhiSwapChainDesc swapChainDesc;
+    swapChainDesc.pWindow = mhMainWnd;
+    swapChainDesc.Width = m_clientWidth;
+    swapChainDesc.Height = m_clientHeight;
+    swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
+    m_pSwapChain = m_pRhiDevice->CreateSwapChain(swapChainDesc);
+
+    m_pRenderer = new Renderer();
+    m_pRenderer->Init(m_pRhiDevice, m_pSwapChain, m_framesInFlight, m_pJobSystem);
 
-    for (UINT i = 0; i < SWAP_CHAIN_BUFFER_COUNT; i++)
+    if (m_renderBackend != RhiBackend::D3D12)
     {
-        ThrowIfFailed(m_pSwapChain->GetBuffer(i, __uuidof(ID3D12Resource), (void**)&m_pSwapChainBuffer[i]));
-        m_pDevice->CreateRenderTargetView(m_pSwapChainBuffer[i], nullptr, rtvHeapHandle);
-        rtvHeapHandle.Offset(1, m_rtvDescriptorSize); 
+        // The other backends run Color.hlsl natively
+        m_pRenderer->CreatePipeline(RhiShaderBytecode(), RhiShaderBytecode());
+        return;
     }
-}
-
-void SleepyEngine::CreateDepthStencilView()
-{
-    D3D12_RESOURCE_DESC depthStencilDesc;
-    depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    depthStencilDesc.Alignment = 0;
-    depthStencilDesc.Width = m_clientWidth;
-    depthStencilDesc.Height = m_clientHeight;
-    depthStencilDesc.DepthOrArraySize = 1;
-    depthStencilDesc.MipLevels = 1;
-    depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    depthStencilDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
-    depthStencilDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
-    depthStencilDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-    // Describes a value used to optimize clear operations for a particular resource.
-    // https://learn.microsoft.com/en-us/windows/win32/api/d3d12/ns-d3d12-d3d12_clear_value
-    D3D12_CLEAR_VALUE optClear;
-    optClear.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    optClear.DepthStencil.Depth = 1.0f;
-    optClear.DepthStencil.Stencil = 0;
-
-    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
-    ThrowIfFailed(m_pDevice->CreateCommittedResource(
-        &heapProperties,
-        D3D12_HEAP_FLAG_NONE,
-        &depthStencilDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        &optClear,
-        __uuidof(ID3D12Resource),
-        (void**)&m_pDepthStencilBuffer
-    ));
-
-    /*D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-    dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-    dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    dsvDesc.Texture2D.MipSlice = 0;*/
-    m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, nullptr, GetDepthStencilView()); //nullptr for default mip level 0
-
-    CD3DX12_RESOURCE_BARRIER ressourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        m_pDepthStencilBuffer,
-        D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_STATE_DEPTH_WRITE);
-    m_pCommandList->ResourceBarrier(
-        1,
-        &ressourceBarrier
-    );
-}
-
-void SleepyEngine::SetViewport()
-{
-    m_pViewPort->TopLeftX = 0.0f;
-    m_pViewPort->TopLeftY = 0.0f;
-    m_pViewPort->Width = static_cast<float>(m_clientWidth);
-    m_pViewPort->Height = static_cast<float>(m_clientHeight);
-    m_pViewPort->MinDepth = 0.0f;
-    m_pViewPort->MaxDepth = 1.0f;
-    m_pCommandList->RSSetViewports(1, m_pViewPort);
-}
-
-// Scissor rect is used to clip pixels to a certain area of the render target and avoid rendering them (ex: pixels below UI).
-void SleepyEngine::SetScissorRect()
-{
-    m_scissorRect.left = 0;
-    m_scissorRect.top = 0;
-    m_scissorRect.right = m_clientWidth;
-    m_scissorRect.bottom = m_clientHeight;
-    m_pCommandList->RSSetScissorRects(1, &m_scissorRect);
+    // Loaded from the cache when the sources did not change, compiled in parallel otherwise
+    D3DShaderCompiler compiler;
+    ShaderCache shaderCache;
+    shaderCache.Init(&compiler, SHADER_CACHE_DIRECTORY, m_pJobSystem);
+    ShaderDesc descs[2] = {
+        { COLOR_SHADER_PATH, "VS", "vs_5_0" },
+        { COLOR_SHADER_PATH, "PS", "ps_5_0" },
+    };
+    CompiledShader shaders[2];
+    bool isCompiled = shaderCache.Build(descs, shaders, 2);
+    for (int i = 0; i < 2; i++)
+    {
+        if (!shaders[i].Errors.empty())
+            OutputDebugStringA(shaders[i].Errors.c_str());
+    }
+    // Without the shader only the clear color is drawn. The pipeline is created on a worker
+    // while the rest of the engine initializes, boxes show up once it is ready.
+    m_pRenderer->GetPipelineCache().SetCacheDirectory(PIPELINE_CACHE_DIRECTORY);
+    if (isCompiled)
+        m_pRenderer->CreatePipeline(shaders[0].GetBytecode(), shaders[1].GetBytecode(), true);
 }
 
 int SleepyEngine::Initialize()
@@ -231,20 +105,33 @@ int SleepyEngine::Initialize()
         LoadStringW(m_hAppInstance, IDC_SLEEPYENGINE, m_szWindowClass, MAX_LOADSTRING);
         RegisterWindowClass();
         InitWindow(SW_SHOW);
-        InitD3D();
+        // Created on the main thread, which becomes worker 0
+        m_pJobSystem = new JobSystem();
+        m_pJobSystem->Init();
+
+        InitRenderer();
+
+        m_pPhysicsWorld = new PhysicsWorld();
+        m_pPhysicsWorld->Init();
+        m_pPhysicsWorld->SetJobSystem(m_pJobSystem);
+
+        m_pInput = new Input();
+        m_pInput->Init();
+        m_pActionMap = new ActionMap();
+        m_pActionMap->Init();
+
+        m_pScriptScheduler = new ScriptScheduler();
+        m_pScriptScheduler->Init();
+
+        m_pFrameStats = new FrameStats();
+        m_pFrameStats->Init(m_targetFrameRate > 0.0 ? 1.0 / m_targetFrameRate : 1.0 / 60.0);
     }
     catch (HResultException error)
     {
-        std::wstring messageBoxText;
         MessageBox(nullptr, error.ToString().c_str(), L"HRESULT ERROR", MB_OK);
-    	HRESULT hr = m_pDevice->GetDeviceRemovedReason();
-        if (FAILED(hr))
-        {
-            _com_error error(hr);
-            std::string errorMessage = "Device Removed Reason:\n" + D3DUtils::HrToString(hr);
-            MessageBoxA(nullptr, errorMessage.c_str(), "Device Removed", MB_OK | MB_ICONERROR);
-            MessageBox(nullptr, error.ErrorMessage(),L"Device Removed", MB_OK);
-        }
+        std::string errorReason = m_pRhiDevice != nullptr ? m_pRhiDevice->GetErrorReason() : "";
+        if (!errorReason.empty())
+            MessageBoxA(nullptr, errorReason.c_str(), "Device Removed", MB_OK | MB_ICONERROR);
         return 1;
     }
     return 0;
@@ -261,12 +148,23 @@ int SleepyEngine::Run()
 
     MSG msg = { 0 };
 
-    Input input = Input();
-    input.Init();
+    PROFILE_THREAD_NAME("Main");
+
     Timer timer = Timer();
     timer.Init();
+    FramePacer framePacer = FramePacer();
+    framePacer.Init(m_targetFrameRate);
+
+    InputRecorder inputRecorder = InputRecorder();
+    if (!m_inputRecordPath.empty())
+        inputRecorder.Open(m_inputRecordPath);
+
+    if (m_inputSamplingRate > 0.0)
+        m_pInput->StartSampling(mhMainWnd, m_inputSamplingRate);
+
+    if (m_isPipelined)
+        StartRenderThread();
 
-    //Draw();
     // Main message loop:
     while (msg.message != WM_QUIT)
     {
@@ -277,17 +175,47 @@ int SleepyEngine::Run()
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+        // Unfocused or minimized: block on the message queue instead of drawing
+        else if (framePacer.WaitWhileIdle(mhMainWnd))
+            continue;
         else {
+            PROFILE_SCOPE("Frame");
             timer.UpdateTimer();
+            m_pFrameStats->AddFrame(timer.GetDeltaTime());
+
+            m_pInput->Update();
+            inputRecorder.RecordFrame(timer.GetFrameTicks(), timer.GetDeltaTicks(), m_pInput->GetFrameEvents());
+            m_pActionMap->Evaluate(*m_pInput);
+
+            // Coroutines run before the simulation so what they change is simulated this frame
+            m_pScriptScheduler->Update(timer.GetTotalTime());
 
-            input.Update();
+            // Simulation runs at the fixed rate of the timer, independently of the frame rate
+            while (timer.ConsumeFixedStep())
+                m_pPhysicsWorld->Step((float)timer.GetFixedDeltaTime());
 
-            timer.UpdateFPS(mhMainWnd);
+            timer.UpdateFPS(mhMainWnd, m_pFrameStats);
 
-            Draw();
+            BuildSnapshot(m_snapshotChannel.GetWriteSlot(), timer.GetTotalTime(), timer.GetAlpha());
+            if (m_isPipelined)
+                PublishSnapshot();
+            else
+                Draw(m_snapshotChannel.GetWriteSlot());
+
+            framePacer.WaitForNextFrame();
         }
         
     }
+    StopRenderThread();
+    // Nothing must be in flight once the loop is left, with or without the render thread
+    FlushCommandQueue();
+    m_pInput->StopSampling();
+    m_pFrameStats->ExportCsv("SleepyFrameStats.csv");
+
+    #ifdef SLEEPY_PROFILE
+        Profiler::ExportChromeTrace("SleepyProfile.json");
+    #endif
+
     #ifdef _DEBUG
         _CrtMemState memStateEnd, memStateDiff;
         _CrtMemCheckpoint(&memStateEnd);
@@ -299,27 +227,6 @@ int SleepyEngine::Run()
     return (int)msg.wParam;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE SleepyEngine::GetCurrentBackBufferView()const
-{
-    // CD3DX12 constructor to offset to the RTV of the current back buffer.
-    return CD3DX12_CPU_DESCRIPTOR_HANDLE(
-        m_pRtvHeap->GetCPUDescriptorHandleForHeapStart(),// handle start
-        m_currentBackBufferOffset, // index to offset
-        m_rtvDescriptorSize); // byte size of descriptor
-}
-
-
-ID3D12Resource* SleepyEngine::GetCurrentBackBuffer()const
-{
-    return m_pSwapChainBuffer[m_currentBackBufferOffset];
-}
-
-
-D3D12_CPU_DESCRIPTOR_HANDLE SleepyEngine::GetDepthStencilView()const
-{
-    return m_pDsvHeap->GetCPUDescriptorHandleForHeapStart();
-}
-
 ATOM SleepyEngine::RegisterWindowClass()
 {
     WNDCLASSEXW wcex;
@@ -349,6 +256,8 @@ void SleepyEngine::InitWindow(int nCmdShow)
         MessageBox(0, L"CreateWindow FAILED", 0, 0);
         return;
     }
+    // Lets the WndProc reach the engine
+    SetWindowLongPtr(mhMainWnd, GWLP_USERDATA, (LONG_PTR)this);
     ShowWindow(mhMainWnd, nCmdShow);
     UpdateWindow(mhMainWnd);
 
@@ -356,6 +265,11 @@ void SleepyEngine::InitWindow(int nCmdShow)
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
+    // Input messages are only recorded, they still go through the usual handling
+    SleepyEngine* pEngine = (SleepyEngine*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+    if (pEngine != nullptr && pEngine->GetInput() != nullptr)
+        pEngine->GetInput()->HandleMessage(message, wParam, lParam);
+
     switch (message)
     {
     case WM_COMMAND:
@@ -392,85 +306,98 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
+void SleepyEngine::AttachScript(Script* pScript)
+{
+    m_pScriptScheduler->Attach(pScript);
+}
+
 void SleepyEngine::FlushCommandQueue()
 {
-    // Advance the fence value to mark commands up to this fence point.
-    m_currentFence++;
+    PROFILE_FUNCTION();
+    m_pRenderer->Flush();
+}
 
-    // Add an instruction to the command queue to set a new fence point.  Because we 
-    // are on the GPU timeline, the new fence point won't be set until the GPU finishes
-    // processing all the commands prior to this Signal().
-    ThrowIfFailed(m_pCommandQueue->Signal(m_pFence, m_currentFence));
+void SleepyEngine::Draw(const RenderSnapshot& snapshot)
+{
+    PROFILE_FUNCTION();
+    m_pRenderer->Draw(snapshot);
+}
 
-    // Wait until the GPU has completed commands up to this fence point.
-    if (m_pFence->GetCompletedValue() < m_currentFence)
-    {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+void SleepyEngine::BuildSnapshot(RenderSnapshot& snapshot, double time, float alpha)
+{
+    PROFILE_FUNCTION();
+    snapshot.Clear();
+    snapshot.FrameIndex = m_frameIndex++;
+    snapshot.Time = time;
+    snapshot.Alpha = alpha;
+    snapshot.ClearColor = m_clearColor;
+
+    Renderer::CaptureColliders(*m_pPhysicsWorld, snapshot);
+}
 
-        // Fire event when GPU hits current fence.  
-        ThrowIfFailed(m_pFence->SetEventOnCompletion(m_currentFence, eventHandle));
+void SleepyEngine::PublishSnapshot()
+{
+    m_snapshotChannel.Publish();
+    // Taking the lock makes sure the render thread is either before its check or already waiting
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_snapshotCondition.notify_one();
+}
 
-        // Wait until the GPU hits current fence event is fired.
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
+void SleepyEngine::StartRenderThread()
+{
+    m_isRenderThreadRunning.store(true);
+    m_renderThread = std::thread(&SleepyEngine::RenderThreadMain, this);
+}
+
+void SleepyEngine::StopRenderThread()
+{
+    if (!m_renderThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_isRenderThreadRunning.store(false);
+        m_snapshotCondition.notify_one();
     }
+    m_renderThread.join();
 }
 
-void SleepyEngine::Draw()//const GameTimer& gt)
+void SleepyEngine::RenderThreadMain()
 {
-    // Reuse the memory associated with command recording.
-    // We can only reset when the associated command lists have finished
-    // execution on the GPU.
-    ThrowIfFailed(m_pDirectCmdListAlloc->Reset());
-    // A command list can be reset after it has been added to the 
-    // command queue via ExecuteCommandList. Reusing the command list 
-    // reuses memory.
-    ThrowIfFailed(m_pCommandList->Reset(m_pDirectCmdListAlloc, nullptr));
-
-    CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        GetCurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_PRESENT,
-        D3D12_RESOURCE_STATE_RENDER_TARGET
-    );
-
-    // Indicate a state transition on the resource usage.
-    m_pCommandList->ResourceBarrier(1, &resourceBarrier);
-    // Set the viewport and scissor rect. This needs to be reset 
-    // whenever the command list is reset.
-    m_pCommandList->RSSetViewports(1, m_pViewPort);
-    m_pCommandList->RSSetScissorRects(1, &m_scissorRect);
-    // Clear the back buffer and depth buffer.
-    m_pCommandList->ClearRenderTargetView(
-        GetCurrentBackBufferView(),
-        DirectX::Colors::LightSteelBlue, 0, nullptr
-    );
-
-    m_pCommandList->ClearDepthStencilView(
-        GetDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH |
-        D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr
-    );
-
-    // Specify the buffers we are going to render to.
-    D3D12_CPU_DESCRIPTOR_HANDLE currentBackBufferView = GetCurrentBackBufferView();
-    D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = GetDepthStencilView();
-    m_pCommandList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
-    // Indicate a state transition on the resource usage.
-    CD3DX12_RESOURCE_BARRIER resourceBarrier2 = CD3DX12_RESOURCE_BARRIER::Transition(
-        GetCurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET,
-        D3D12_RESOURCE_STATE_PRESENT
-    );
-    m_pCommandList->ResourceBarrier(1, &resourceBarrier2);
-    // Done recording commands.
-    ThrowIfFailed(m_pCommandList->Close());
-    // Add the command list to the queue for execution.
-    ID3D12CommandList* cmdsLists[] = { m_pCommandList };
-    m_pCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-    // swap the back and front buffers
-    ThrowIfFailed(m_pSwapChain->Present(0, 0));
-    m_currentBackBufferOffset = (m_currentBackBufferOffset + 1) % SWAP_CHAIN_BUFFER_COUNT;
-    // Wait until frame commands are complete. This waiting is 
-    // inefficient and is done for simplicity. Later we will show how to 
-    // organize our rendering code so we do not have to wait per frame.
-    FlushCommandQueue();
-}
\ No newline at end of file
+    PROFILE_THREAD_NAME("Render");
+    try
+    {
+        while (true)
+        {
+            // The snapshot belongs to this thread until the next Acquire
+            const RenderSnapshot* pSnapshot = m_snapshotChannel.Acquire();
+            if (pSnapshot != nullptr)
+            {
+                Draw(*pSnapshot);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_snapshotMutex);
+            m_snapshotCondition.wait(lock, [this]() { return m_snapshotChannel.HasNew() || !m_isRenderThreadRunning.load(); });
+            if (!m_snapshotChannel.HasNew())
+                break;
+        }
+    }
+    catch (HResultException error)
+    {
+        MessageBox(nullptr, error.ToString().c_str(), L"HRESULT ERROR", MB_OK);
+        // Let the main thread leave the loop, it joins this thread
+        PostMessage(mhMainWnd, WM_CLOSE, 0, 0);
+    }
+    // An exception leaving the thread would terminate the process without any message
+    catch (const std::exception& error)
+    {
+        MessageBoxA(nullptr, error.what(), "RENDER THREAD ERROR", MB_OK);
+        PostMessage(mhMainWnd, WM_CLOSE, 0, 0);
+    }
+    catch (...)
+    {
+        MessageBox(nullptr, L"Unknown exception", L"RENDER THREAD ERROR", MB_OK);
+        PostMessage(mhMainWnd, WM_CLOSE, 0, 0);
+    }
+}
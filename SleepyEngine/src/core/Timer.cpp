@@ -1,34 +1,37 @@
 #include "pch.h"
 #include "Timer.h"
+#include "FrameStats.h"
 
-//TotalTime: temps en s depuis lancement du jeu : float
+//TotalTime: temps en s depuis lancement du jeu : double
 //DeltaTime: temps coul entre deux frames: float
 
-//timeGetTime: en ms
+//Ticks: en ns, steady_clock (QueryPerformanceCounter sous Windows)
 
 Timer::Timer() {}
 
 bool Timer::Init()
 {
-	StartTime = timeGetTime();
+	StartTicks = GetTicks();
+	PrevTicks = StartTicks;
+	CurrTicks = StartTicks;
+
+	DeltaTicks = 0;
 	DeltaTime = 0.f;
-	TotalTime = 0.f;
+	TotalTime = 0.0;
 
-	currTime = 0.f;
-	prevTime = 0.f;
+	FixedStepTicks = SecondsToTicks(1.0 / 60.0);
+	Accumulator = 0;
+	MaxFixedSteps = 8;
 
 	FrameCount = 0;
-	FPSTimer = 0.f;
-	MaxFPS = 0;
-
-	std::cout << timeGetTime() << std::endl;
+	FPSTimer = 0.0;
 
 	return true;
 }
 
-float Timer::GetTotalTime()
+double Timer::GetTotalTime()
 {
-	return (timeGetTime() - StartTime)*0.001;
+	return TotalTime;
 }
 
 float Timer::GetDeltaTime()
@@ -38,28 +41,87 @@ float Timer::GetDeltaTime()
 
 void Timer::UpdateTimer()
 {
-	currTime = GetTotalTime();
+	UpdateTimer(GetTicks() - PrevTicks);
+}
+
+void Timer::UpdateTimer(int64_t deltaTicks)
+{
+	CurrTicks = PrevTicks + deltaTicks;
+
+	DeltaTicks = deltaTicks;
+	DeltaTime = (float)TicksToSeconds(deltaTicks);
+	TotalTime = TicksToSeconds(CurrTicks - StartTicks);
+
+	PrevTicks = CurrTicks;
+
+	Accumulator += deltaTicks;
+	if (Accumulator > FixedStepTicks * MaxFixedSteps)
+		Accumulator = FixedStepTicks * MaxFixedSteps;
+}
 
-	DeltaTime = currTime - prevTime;
+void Timer::SetFixedDeltaTime(double seconds)
+{
+	FixedStepTicks = SecondsToTicks(seconds);
+	if (FixedStepTicks <= 0)
+		FixedStepTicks = 1;
+}
 
-	prevTime = currTime;
+double Timer::GetFixedDeltaTime()
+{
+	return TicksToSeconds(FixedStepTicks);
 }
 
-void Timer::UpdateFPS(HWND Window)
+bool Timer::ConsumeFixedStep()
+{
+	if (Accumulator < FixedStepTicks)
+		return false;
+
+	Accumulator -= FixedStepTicks;
+	return true;
+}
+
+float Timer::GetAlpha()
+{
+	return (float)((double)Accumulator / (double)FixedStepTicks);
+}
+
+int64_t Timer::GetTicks()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double Timer::TicksToSeconds(int64_t ticks)
+{
+	return (double)ticks * 1e-9;
+}
+
+int64_t Timer::SecondsToTicks(double seconds)
+{
+	return (int64_t)(seconds * 1e9);
+}
+
+#ifdef _WIN32
+void Timer::UpdateFPS(HWND Window, FrameStats* pFrameStats)
 {
 	FrameCount += 1;
-	if ((GetTotalTime() - FPSTimer) >= 1.f)
+	if ((TotalTime - FPSTimer) >= 1.0)
 	{
-		std::wstring title = L"FPS: " + std::to_wstring(FrameCount) + L" | Max FPS: " + std::to_wstring(MaxFPS);
-
-		if (FrameCount > MaxFPS)
-			MaxFPS = FrameCount;
+		std::wstring title = L"FPS: " + std::to_wstring(FrameCount);
+		if (pFrameStats != nullptr)
+		{
+			// The frame rate alone hides stutter, the slow percentiles show it
+			FrameStats::Summary summary = pFrameStats->GetSummary();
+			wchar_t stats[128];
+			swprintf_s(stats, L" | p50: %.2f ms | p99: %.2f ms | max: %.2f ms", summary.P50, summary.P99, summary.Max);
+			title += stats;
+		}
 
 		FrameCount = 0;
-		FPSTimer += GetTotalTime();
+		FPSTimer = TotalTime;
 		
 		// Might be temporary, might not be
 		// Depends on if we can figure out "fonts"
 		SetWindowText(Window, title.c_str());
 	}
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
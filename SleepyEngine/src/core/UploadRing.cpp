@@ -0,0 +1,45 @@
+#include "UploadRing.h"
+#include "Rhi.h"
+
+UploadRing::UploadRing()
+{
+}
+
+UploadRing::~UploadRing()
+{
+	delete m_pBuffer;
+}
+
+bool UploadRing::Init(RhiDevice* pDevice, uint64_t capacity)
+{
+	if (pDevice == nullptr || capacity == 0)
+		return false;
+
+	capacity = (capacity + MAX_ALIGNMENT - 1) & ~(MAX_ALIGNMENT - 1);
+	RhiBufferDesc desc;
+	desc.Size = capacity;
+	desc.HeapType = RhiHeapType::Upload;
+	m_pBuffer = pDevice->CreateBuffer(desc);
+	if (m_pBuffer == nullptr)
+		return false;
+	// Mapped for the lifetime of the ring, upload heaps allow it
+	m_pData = (uint8_t*)m_pBuffer->Map();
+	m_ring.Init(capacity);
+	return m_pData != nullptr;
+}
+
+bool UploadRing::Allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+{
+	if (m_pData == nullptr || alignment == 0 || alignment > MAX_ALIGNMENT || (alignment & (alignment - 1)) != 0)
+		return false;
+
+	uint64_t offset = m_ring.Allocate(size, alignment);
+	if (offset == LinearRing::INVALID_OFFSET)
+		return false;
+
+	allocation.Offset = offset;
+	allocation.pData = m_pData + offset;
+	allocation.pBuffer = m_pBuffer;
+	allocation.GpuAddress = m_pBuffer->GetGpuAddress() + offset;
+	return true;
+}
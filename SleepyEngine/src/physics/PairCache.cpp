@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "PairCache.h"
+#include "MathHelper.h"
+
+PairCache::PairCache()
+{
+}
+
+void PairCache::Init()
+{
+	m_pairs.clear();
+	m_pairIndices.clear();
+}
+
+bool PairCache::Add(int a, int b)
+{
+	if (a > b)
+		std::swap(a, b);
+
+	uint64_t key = MakeKey(a, b);
+	if (m_pairIndices.find(key) != m_pairIndices.end())
+		return false;
+
+	Pair pair;
+	pair.A = a;
+	pair.B = b;
+	pair.State = ContactState::None;
+
+	m_pairIndices[key] = (int)m_pairs.size();
+	m_pairs.push_back(pair);
+	return true;
+}
+
+bool PairCache::Remove(int a, int b, Pair* pRemoved)
+{
+	auto it = m_pairIndices.find(MakeKey(MathHelper::Min(a, b), MathHelper::Max(a, b)));
+	if (it == m_pairIndices.end())
+		return false;
+
+	if (pRemoved != nullptr)
+		*pRemoved = m_pairs[it->second];
+
+	RemoveAt(it->second);
+	return true;
+}
+
+void PairCache::RemoveAll(int index, std::vector<Pair>& removed)
+{
+	for (int i = (int)m_pairs.size() - 1; i >= 0; i--)
+	{
+		if (m_pairs[i].A == index || m_pairs[i].B == index)
+		{
+			removed.push_back(m_pairs[i]);
+			RemoveAt(i);
+		}
+	}
+}
+
+void PairCache::Rename(int from, int to)
+{
+	for (int i = 0; i < m_pairs.size(); i++)
+	{
+		Pair& pair = m_pairs[i];
+		if (pair.A != from && pair.B != from)
+			continue;
+
+		m_pairIndices.erase(MakeKey(pair.A, pair.B));
+		if (pair.A == from)
+			pair.A = to;
+		else
+			pair.B = to;
+		if (pair.A > pair.B)
+			std::swap(pair.A, pair.B);
+		m_pairIndices[MakeKey(pair.A, pair.B)] = i;
+	}
+}
+
+const PairCache::Pair* PairCache::Find(int a, int b) const
+{
+	auto it = m_pairIndices.find(MakeKey(MathHelper::Min(a, b), MathHelper::Max(a, b)));
+	if (it == m_pairIndices.end())
+		return nullptr;
+	return &m_pairs[it->second];
+}
+
+uint64_t PairCache::MakeKey(int a, int b)
+{
+	return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+void PairCache::RemoveAt(int i)
+{
+	// Swap with the last pair to keep the storage packed
+	int last = (int)m_pairs.size() - 1;
+	m_pairIndices.erase(MakeKey(m_pairs[i].A, m_pairs[i].B));
+	if (i != last)
+	{
+		m_pairs[i] = m_pairs[last];
+		m_pairIndices[MakeKey(m_pairs[i].A, m_pairs[i].B)] = i;
+	}
+	m_pairs.pop_back();
+}
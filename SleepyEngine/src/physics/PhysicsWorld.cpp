@@ -0,0 +1,796 @@
+#include "pch.h"
+#include "PhysicsWorld.h"
+#include "Collider.h"
+#include "MathHelper.h"
+#include "Script.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+
+// Runs function on sub ranges of [0, count), spread over the workers when there is a job system
+template<typename Function>
+static void ForEachRange(JobSystem* pJobSystem, int count, int grainSize, const Function& function)
+{
+	if (pJobSystem != nullptr)
+		pJobSystem->ParallelFor(count, grainSize, function);
+	else
+		function(0, count);
+}
+
+PhysicsWorld::PhysicsWorld()
+{
+}
+
+void PhysicsWorld::Init()
+{
+	m_colliders.clear();
+	m_bounds.clear();
+	m_endpoints.clear();
+	m_pairCache.Init();
+	m_contacts.clear();
+	m_beginEvents.clear();
+	m_endEvents.clear();
+	m_sleepingIslands.clear();
+	m_awakeIslandCount = 0;
+	m_wakeRequests.clear();
+	m_fellAsleep.clear();
+	m_awakeCount = 0;
+}
+
+void PhysicsWorld::AddCollider(Collider* pCollider)
+{
+	if (pCollider == nullptr || pCollider->m_pWorld != nullptr)
+		return;
+
+	int index = (int)m_colliders.size();
+	pCollider->m_pWorld = this;
+	pCollider->m_worldIndex = index;
+	pCollider->m_isSleeping = false;
+	pCollider->m_sleepTimer = 0.0f;
+	pCollider->m_islandId = -1;
+
+	m_colliders.push_back(pCollider);
+	m_bounds.push_back(Bounds());
+	RefreshBounds(index);
+
+	// Appended after every other endpoint, as if the collider was far on the right.
+	// The next broadphase update sorts them in place and reports the overlaps.
+	m_endpoints.push_back({ m_bounds[index].Min.x, index, true });
+	m_endpoints.push_back({ m_bounds[index].Max.x, index, false });
+
+	if (!pCollider->IsStatic())
+		m_awakeCount++;
+}
+
+void PhysicsWorld::RemoveCollider(Collider* pCollider)
+{
+	if (pCollider == nullptr || pCollider->m_pWorld != this)
+		return;
+
+	int index = pCollider->m_worldIndex;
+	int last = (int)m_colliders.size() - 1;
+
+	// Whatever was resting on the collider has to react to its removal
+	if (pCollider->m_isSleeping)
+		WakeIsland(pCollider->m_islandId);
+
+	m_removedPairs.clear();
+	m_pairCache.RemoveAll(index, m_removedPairs);
+	for (int i = 0; i < m_removedPairs.size(); i++)
+	{
+		const PairCache::Pair& pair = m_removedPairs[i];
+		if (!pair.IsTouching())
+			continue;
+
+		m_endEvents.push_back({ m_colliders[pair.A], m_colliders[pair.B] });
+		Collider* pOther = m_colliders[pair.A == index ? pair.B : pair.A];
+		if (pOther->m_isSleeping)
+			WakeIsland(pOther->m_islandId);
+	}
+
+	if (!pCollider->IsStatic())
+		m_awakeCount--;
+
+	m_wakeRequests.erase(std::remove(m_wakeRequests.begin(), m_wakeRequests.end(), pCollider), m_wakeRequests.end());
+	m_fellAsleep.erase(std::remove(m_fellAsleep.begin(), m_fellAsleep.end(), pCollider), m_fellAsleep.end());
+
+	// Swap with the last collider to keep the arrays packed
+	if (index != last)
+	{
+		Collider* pMoved = m_colliders[last];
+		m_colliders[index] = pMoved;
+		m_bounds[index] = m_bounds[last];
+		pMoved->m_worldIndex = index;
+
+		if (pMoved->m_isSleeping)
+		{
+			std::vector<int>& members = m_sleepingIslands[pMoved->m_islandId];
+			std::replace(members.begin(), members.end(), last, index);
+		}
+		m_pairCache.Rename(last, index);
+	}
+	m_colliders.pop_back();
+	m_bounds.pop_back();
+
+	m_endpoints.erase(std::remove_if(m_endpoints.begin(), m_endpoints.end(),
+		[index](const Endpoint& endpoint) { return endpoint.Index == index; }), m_endpoints.end());
+	for (int i = 0; i < m_endpoints.size(); i++)
+	{
+		if (m_endpoints[i].Index == last)
+			m_endpoints[i].Index = index;
+	}
+
+	// Contacts are rebuilt every step, drop the ones holding stale indices
+	m_contacts.clear();
+
+	pCollider->m_pWorld = nullptr;
+	pCollider->m_worldIndex = -1;
+	pCollider->m_isSleeping = false;
+	pCollider->m_islandId = -1;
+}
+
+void PhysicsWorld::RefreshFilter(Collider* pCollider, bool wasStatic)
+{
+	if (pCollider == nullptr || pCollider->m_pWorld != this)
+		return;
+
+	int index = pCollider->m_worldIndex;
+	bool isStatic = pCollider->IsStatic();
+	if (isStatic != wasStatic)
+	{
+		// Static bodies never sleep, and the island of a body turning static loses its anchor
+		if (pCollider->m_isSleeping)
+			WakeIsland(pCollider->m_islandId);
+		m_awakeCount += isStatic ? -1 : 1;
+		pCollider->m_sleepTimer = 0.0f;
+	}
+
+	// The intervals the broadphase sorted, so the pairs added here are the ones its next swaps expect
+	int count = (int)m_colliders.size();
+	m_sweepMin.resize(count);
+	m_sweepMax.resize(count);
+	for (int i = 0; i < m_endpoints.size(); i++)
+	{
+		const Endpoint& endpoint = m_endpoints[i];
+		if (endpoint.IsMin)
+			m_sweepMin[endpoint.Index] = endpoint.Value;
+		else
+			m_sweepMax[endpoint.Index] = endpoint.Value;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (i == index)
+			continue;
+
+		bool isAccepted = IsPairAccepted(index, i);
+		bool isCached = m_pairCache.Find(index, i) != nullptr;
+		if (isAccepted && !isCached)
+		{
+			if (m_sweepMin[index] < m_sweepMax[i] && m_sweepMin[i] < m_sweepMax[index])
+				m_pairCache.Add(index, i);
+		}
+		else if (!isAccepted && isCached)
+		{
+			PairCache::Pair removed;
+			m_pairCache.Remove(index, i, &removed);
+			if (!removed.IsTouching())
+				continue;
+
+			m_endEvents.push_back({ m_colliders[removed.A], m_colliders[removed.B] });
+			// Either could be resting on the other
+			if (pCollider->m_isSleeping)
+				WakeIsland(pCollider->m_islandId);
+			if (m_colliders[i]->m_isSleeping)
+				WakeIsland(m_colliders[i]->m_islandId);
+		}
+	}
+}
+
+void PhysicsWorld::RequestWake(Collider* pCollider)
+{
+	m_wakeRequests.push_back(pCollider);
+}
+
+void PhysicsWorld::AddContactListener(Script* pScript)
+{
+	if (std::find(m_contactListeners.begin(), m_contactListeners.end(), pScript) == m_contactListeners.end())
+		m_contactListeners.push_back(pScript);
+}
+
+void PhysicsWorld::RemoveContactListener(Script* pScript)
+{
+	m_contactListeners.erase(std::remove(m_contactListeners.begin(), m_contactListeners.end(), pScript), m_contactListeners.end());
+}
+
+void PhysicsWorld::Step(float deltaTime)
+{
+	PROFILE_FUNCTION();
+	// Start of the step, rendering interpolates from there. Sleeping bodies keep theirs, except the
+	// ones which fell asleep on the last step: they moved during it. Static bodies only teleport.
+	if (m_awakeCount > 0)
+	{
+		for (int i = 0; i < m_colliders.size(); i++)
+		{
+			if (IsActive(i))
+				m_colliders[i]->m_previousCenter = m_colliders[i]->m_center;
+		}
+	}
+	for (int i = 0; i < m_fellAsleep.size(); i++)
+		m_fellAsleep[i]->m_previousCenter = m_fellAsleep[i]->m_center;
+	m_fellAsleep.clear();
+
+	ProcessWakeRequests();
+
+	// Idle scene: every dynamic body sleeps, nothing to integrate, sweep or solve
+	if (m_awakeCount == 0 || deltaTime <= 0.0f)
+	{
+		DispatchContactEvents();
+		return;
+	}
+
+	if (deltaTime > m_maxDeltaTime)
+		deltaTime = m_maxDeltaTime;
+
+	m_stepDeltaTime = deltaTime;
+
+	IntegrateVelocities(deltaTime);
+	UpdateBroadPhase();
+	UpdatePairs();
+	SolveContacts();
+	SolveTimeOfImpact(deltaTime);
+	IntegratePositions(deltaTime);
+	CorrectPositions();
+	BuildIslands();
+	UpdateSleep(deltaTime);
+	DispatchContactEvents();
+}
+
+void PhysicsWorld::ProcessWakeRequests()
+{
+	for (int i = 0; i < m_wakeRequests.size(); i++)
+	{
+		Collider* pCollider = m_wakeRequests[i];
+		if (pCollider->m_pWorld != this)
+			continue;
+		if (pCollider->IsStatic())
+			WakeAroundStatic(pCollider->m_worldIndex);
+		// The island may already have been woken by an earlier request
+		else if (pCollider->m_isSleeping)
+			WakeIsland(pCollider->m_islandId);
+	}
+	m_wakeRequests.clear();
+}
+
+void PhysicsWorld::IntegrateVelocities(float deltaTime)
+{
+	PROFILE_FUNCTION();
+	XMVECTOR gravityStep = XMVectorScale(XMLoadFloat3(&m_gravity), deltaTime);
+	ForEachRange(m_pJobSystem, (int)m_colliders.size(), m_parallelGrainSize, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (!IsActive(i))
+				continue;
+
+			Collider* pCollider = m_colliders[i];
+			XMVECTOR velocity = XMVectorAdd(XMLoadFloat3(&pCollider->m_velocity), gravityStep);
+			XMStoreFloat3(&pCollider->m_velocity, velocity);
+		}
+	});
+}
+
+void PhysicsWorld::UpdateBroadPhase()
+{
+	PROFILE_FUNCTION();
+	// Sleeping bodies did not move since they fell asleep, their endpoints are still valid
+	m_continuousCount = 0;
+	for (int i = 0; i < m_colliders.size(); i++)
+	{
+		if (!m_colliders[i]->m_isSleeping)
+			RefreshBounds(i);
+		if (IsContinuousActive(i))
+			m_continuousCount++;
+	}
+	for (int i = 0; i < m_endpoints.size(); i++)
+	{
+		Endpoint& endpoint = m_endpoints[i];
+		const Collider* pCollider = m_colliders[endpoint.Index];
+		if (pCollider->m_isSleeping)
+			continue;
+
+		endpoint.Value = endpoint.IsMin ? m_bounds[endpoint.Index].Min.x : m_bounds[endpoint.Index].Max.x;
+
+		// Continuous bodies are swept: their interval covers the whole motion of the step
+		if (IsContinuousActive(endpoint.Index))
+		{
+			float motion = pCollider->m_velocity.x * m_stepDeltaTime;
+			if (endpoint.IsMin)
+				endpoint.Value += MathHelper::Min(motion, 0.0f);
+			else
+				endpoint.Value += MathHelper::Max(motion, 0.0f);
+		}
+	}
+
+	// Insertion sort: the order barely changes between two steps.
+	// A min moving before a max starts an overlap, a max moving before a min ends one.
+	for (int i = 1; i < m_endpoints.size(); i++)
+	{
+		Endpoint endpoint = m_endpoints[i];
+		int j = i - 1;
+		while (j >= 0 && m_endpoints[j].Value > endpoint.Value)
+		{
+			const Endpoint& other = m_endpoints[j];
+			if (endpoint.IsMin && !other.IsMin)
+				OnOverlapBegin(endpoint.Index, other.Index);
+			else if (!endpoint.IsMin && other.IsMin)
+				OnOverlapEnd(endpoint.Index, other.Index);
+
+			m_endpoints[j + 1] = other;
+			j--;
+		}
+		m_endpoints[j + 1] = endpoint;
+	}
+}
+
+void PhysicsWorld::OnOverlapBegin(int a, int b)
+{
+	// Filtered pairs never reach the cache
+	if (!IsPairAccepted(a, b))
+		return;
+
+	m_pairCache.Add(a, b);
+}
+
+void PhysicsWorld::OnOverlapEnd(int a, int b)
+{
+	PairCache::Pair removed;
+	if (!m_pairCache.Remove(a, b, &removed))
+		return;
+
+	if (removed.IsTouching())
+		m_endEvents.push_back({ m_colliders[removed.A], m_colliders[removed.B] });
+}
+
+void PhysicsWorld::UpdatePairs()
+{
+	PROFILE_FUNCTION();
+	m_contacts.clear();
+	for (int i = 0; i < m_pairCache.GetCount(); i++)
+	{
+		PairCache::Pair& pair = m_pairCache.GetPair(i);
+
+		// Pairs between bodies that cannot move keep their state, no event and no contact
+		if (!IsActive(pair.A) && !IsActive(pair.B))
+			continue;
+
+		if (IsTouching(pair.A, pair.B))
+		{
+			if (pair.IsTouching())
+				pair.State = PairCache::ContactState::Stay;
+			else
+			{
+				pair.State = PairCache::ContactState::Begin;
+				m_beginEvents.push_back({ m_colliders[pair.A], m_colliders[pair.B] });
+			}
+			AddContact(pair.A, pair.B);
+		}
+		else if (pair.IsTouching())
+		{
+			pair.State = PairCache::ContactState::End;
+			m_endEvents.push_back({ m_colliders[pair.A], m_colliders[pair.B] });
+		}
+		else
+			pair.State = PairCache::ContactState::None;
+	}
+}
+
+void PhysicsWorld::SolveContacts()
+{
+	PROFILE_FUNCTION();
+	for (int iteration = 0; iteration < m_solverIterations; iteration++)
+	{
+		for (int i = 0; i < m_contacts.size(); i++)
+		{
+			const Contact& contact = m_contacts[i];
+			Collider* pA = m_colliders[contact.A];
+			Collider* pB = m_colliders[contact.B];
+
+			float inverseMassSum = pA->m_inverseMass + pB->m_inverseMass;
+			if (inverseMassSum == 0.0f)
+				continue;
+
+			XMVECTOR normal = XMLoadFloat3(&contact.Normal);
+			XMVECTOR velocityA = XMLoadFloat3(&pA->m_velocity);
+			XMVECTOR velocityB = XMLoadFloat3(&pB->m_velocity);
+
+			// Already separating
+			float normalVelocity = XMVectorGetX(XMVector3Dot(XMVectorSubtract(velocityB, velocityA), normal));
+			if (normalVelocity >= 0.0f)
+				continue;
+
+			float restitution = MathHelper::Min(pA->m_restitution, pB->m_restitution);
+			if (-normalVelocity < m_restitutionThreshold)
+				restitution = 0.0f;
+
+			float impulse = -(1.0f + restitution) * normalVelocity / inverseMassSum;
+			velocityA = XMVectorSubtract(velocityA, XMVectorScale(normal, impulse * pA->m_inverseMass));
+			velocityB = XMVectorAdd(velocityB, XMVectorScale(normal, impulse * pB->m_inverseMass));
+			XMStoreFloat3(&pA->m_velocity, velocityA);
+			XMStoreFloat3(&pB->m_velocity, velocityB);
+		}
+	}
+}
+
+void PhysicsWorld::SolveTimeOfImpact(float deltaTime)
+{
+	PROFILE_FUNCTION();
+	m_timeOfImpact.assign(m_colliders.size(), 1.0f);
+	if (m_continuousCount == 0)
+		return;
+
+	m_impactNormals.resize(m_colliders.size());
+
+	// Swept pairs: the x intervals of continuous bodies cover their motion,
+	// so every collider they can reach during the step is in the pair cache
+	for (int i = 0; i < m_pairCache.GetCount(); i++)
+	{
+		const PairCache::Pair& pair = m_pairCache.GetPair(i);
+		bool isContinuousA = IsContinuousActive(pair.A);
+		bool isContinuousB = IsContinuousActive(pair.B);
+		if (!isContinuousA && !isContinuousB)
+			continue;
+
+		// Already in contact, handled by the discrete solver
+		if (IsTouching(pair.A, pair.B))
+			continue;
+
+		// Motion of A relative to B during the step
+		XMVECTOR relativeVelocity = XMVectorSubtract(XMLoadFloat3(&m_colliders[pair.A]->m_velocity), XMLoadFloat3(&m_colliders[pair.B]->m_velocity));
+		XMFLOAT3 motion;
+		XMStoreFloat3(&motion, XMVectorScale(relativeVelocity, deltaTime));
+
+		float timeOfImpact;
+		XMFLOAT3 normal;
+		if (!SweepBounds(m_bounds[pair.A], motion, m_bounds[pair.B], timeOfImpact, normal))
+			continue;
+
+		if (isContinuousA && timeOfImpact < m_timeOfImpact[pair.A])
+		{
+			m_timeOfImpact[pair.A] = timeOfImpact;
+			m_impactNormals[pair.A] = normal;
+		}
+		if (isContinuousB && timeOfImpact < m_timeOfImpact[pair.B])
+		{
+			m_timeOfImpact[pair.B] = timeOfImpact;
+			m_impactNormals[pair.B] = XMFLOAT3(-normal.x, -normal.y, -normal.z);
+		}
+	}
+}
+
+void PhysicsWorld::IntegratePositions(float deltaTime)
+{
+	PROFILE_FUNCTION();
+	// Bodies are independent here, each range only writes its own colliders
+	ForEachRange(m_pJobSystem, (int)m_colliders.size(), m_parallelGrainSize, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (!IsActive(i))
+				continue;
+
+			// Continuous bodies only move up to their time of impact
+			Collider* pCollider = m_colliders[i];
+			XMVECTOR velocity = XMLoadFloat3(&pCollider->m_velocity);
+			XMVECTOR center = XMLoadFloat3(&pCollider->m_center);
+			center = XMVectorAdd(center, XMVectorScale(velocity, deltaTime * m_timeOfImpact[i]));
+			XMStoreFloat3(&pCollider->m_center, center);
+
+			if (m_timeOfImpact[i] >= 1.0f)
+				continue;
+
+			// Then lose their velocity into the surface they hit
+			XMVECTOR normal = XMLoadFloat3(&m_impactNormals[i]);
+			float normalVelocity = XMVectorGetX(XMVector3Dot(velocity, normal));
+			if (normalVelocity < 0.0f)
+			{
+				velocity = XMVectorSubtract(velocity, XMVectorScale(normal, (1.0f + pCollider->m_restitution) * normalVelocity));
+				XMStoreFloat3(&pCollider->m_velocity, velocity);
+			}
+		}
+	});
+}
+
+void PhysicsWorld::CorrectPositions()
+{
+	PROFILE_FUNCTION();
+	// Push overlapping bodies apart, without touching velocities
+	for (int i = 0; i < m_contacts.size(); i++)
+	{
+		const Contact& contact = m_contacts[i];
+		Collider* pA = m_colliders[contact.A];
+		Collider* pB = m_colliders[contact.B];
+
+		float inverseMassSum = pA->m_inverseMass + pB->m_inverseMass;
+		float depth = contact.Penetration - m_penetrationSlop;
+		if (inverseMassSum == 0.0f || depth <= 0.0f)
+			continue;
+
+		XMVECTOR correction = XMVectorScale(XMLoadFloat3(&contact.Normal), depth / inverseMassSum * m_correctionPercent);
+		XMStoreFloat3(&pA->m_center, XMVectorSubtract(XMLoadFloat3(&pA->m_center), XMVectorScale(correction, pA->m_inverseMass)));
+		XMStoreFloat3(&pB->m_center, XMVectorAdd(XMLoadFloat3(&pB->m_center), XMVectorScale(correction, pB->m_inverseMass)));
+	}
+}
+
+void PhysicsWorld::BuildIslands()
+{
+	PROFILE_FUNCTION();
+	// Union-find over the contacts between dynamic bodies.
+	// Static bodies do not link islands together, otherwise the whole scene
+	// would be a single island through the ground.
+	int count = (int)m_colliders.size();
+	m_islandParent.resize(count);
+	for (int i = 0; i < count; i++)
+		m_islandParent[i] = i;
+
+	for (int i = 0; i < m_contacts.size(); i++)
+	{
+		const Contact& contact = m_contacts[i];
+		if (m_colliders[contact.A]->IsStatic() || m_colliders[contact.B]->IsStatic())
+			continue;
+
+		int rootA = FindRoot(contact.A);
+		int rootB = FindRoot(contact.B);
+		if (rootA != rootB)
+			m_islandParent[rootA] = rootB;
+	}
+
+	m_rootToIsland.assign(count, -1);
+	m_awakeIslandCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (!IsActive(i))
+			continue;
+
+		int root = FindRoot(i);
+		if (m_rootToIsland[root] == -1)
+		{
+			m_rootToIsland[root] = m_awakeIslandCount;
+			if (m_awakeIslandCount == m_awakeIslands.size())
+				m_awakeIslands.push_back(std::vector<int>());
+			m_awakeIslands[m_awakeIslandCount].clear();
+			m_awakeIslandCount++;
+		}
+		m_awakeIslands[m_rootToIsland[root]].push_back(i);
+	}
+}
+
+void PhysicsWorld::UpdateSleep(float deltaTime)
+{
+	PROFILE_FUNCTION();
+	ForEachRange(m_pJobSystem, (int)m_colliders.size(), m_parallelGrainSize, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (!IsActive(i))
+				continue;
+
+			Collider* pCollider = m_colliders[i];
+			float speedSq = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&pCollider->m_velocity)));
+			if (speedSq < m_sleepVelocitySq)
+				pCollider->m_sleepTimer += deltaTime;
+			else
+				pCollider->m_sleepTimer = 0.0f;
+		}
+	});
+
+	// An island sleeps only when all of its bodies are ready to
+	for (int island = 0; island < m_awakeIslandCount; island++)
+	{
+		const std::vector<int>& members = m_awakeIslands[island];
+
+		bool canSleep = true;
+		for (int i = 0; i < members.size() && canSleep; i++)
+			canSleep = m_colliders[members[i]]->m_sleepTimer >= m_timeToSleep;
+
+		if (!canSleep)
+			continue;
+
+		int islandId = m_nextIslandId++;
+		for (int i = 0; i < members.size(); i++)
+		{
+			Collider* pCollider = m_colliders[members[i]];
+			pCollider->m_isSleeping = true;
+			pCollider->m_islandId = islandId;
+			pCollider->m_velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			m_fellAsleep.push_back(pCollider);
+		}
+		m_awakeCount -= (int)members.size();
+		m_sleepingIslands[islandId] = members;
+	}
+}
+
+void PhysicsWorld::DispatchContactEvents()
+{
+	if (m_beginEvents.empty() && m_endEvents.empty())
+		return;
+
+	for (int i = 0; i < m_contactListeners.size(); i++)
+		m_contactListeners[i]->OnContacts(m_beginEvents, m_endEvents);
+
+	m_beginEvents.clear();
+	m_endEvents.clear();
+}
+
+bool PhysicsWorld::IsActive(int index) const
+{
+	const Collider* pCollider = m_colliders[index];
+	return !pCollider->IsStatic() && !pCollider->m_isSleeping;
+}
+
+bool PhysicsWorld::IsPairAccepted(int a, int b) const
+{
+	const Collider* pA = m_colliders[a];
+	const Collider* pB = m_colliders[b];
+	if (pA->IsStatic() && pB->IsStatic())
+		return false;
+	return pA->CanCollideWith(*pB);
+}
+
+bool PhysicsWorld::IsContinuousActive(int index) const
+{
+	return m_colliders[index]->m_isContinuous && IsActive(index);
+}
+
+bool PhysicsWorld::SweepBounds(const Bounds& a, const XMFLOAT3& motion, const Bounds& b, float& timeOfImpact, XMFLOAT3& normal)
+{
+	// Slab test of the motion against b grown by the size of a
+	float aMin[3] = { a.Min.x, a.Min.y, a.Min.z };
+	float aMax[3] = { a.Max.x, a.Max.y, a.Max.z };
+	float bMin[3] = { b.Min.x, b.Min.y, b.Min.z };
+	float bMax[3] = { b.Max.x, b.Max.y, b.Max.z };
+	float move[3] = { motion.x, motion.y, motion.z };
+
+	float enter = 0.0f;
+	float exit = 1.0f;
+	int enterAxis = -1;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (move[axis] == 0.0f)
+		{
+			// Not moving on this axis: must already overlap on it
+			if (aMax[axis] < bMin[axis] || bMax[axis] < aMin[axis])
+				return false;
+			continue;
+		}
+
+		float inverseMove = 1.0f / move[axis];
+		float axisEnter = (bMin[axis] - aMax[axis]) * inverseMove;
+		float axisExit = (bMax[axis] - aMin[axis]) * inverseMove;
+		if (axisEnter > axisExit)
+			std::swap(axisEnter, axisExit);
+
+		if (axisEnter > enter)
+		{
+			enter = axisEnter;
+			enterAxis = axis;
+		}
+		exit = MathHelper::Min(exit, axisExit);
+		if (enter > exit)
+			return false;
+	}
+
+	if (enterAxis == -1)
+		return false;
+
+	float hitNormal[3] = { 0.0f, 0.0f, 0.0f };
+	hitNormal[enterAxis] = move[enterAxis] > 0.0f ? -1.0f : 1.0f;
+	normal = XMFLOAT3(hitNormal[0], hitNormal[1], hitNormal[2]);
+	timeOfImpact = enter;
+	return true;
+}
+
+bool PhysicsWorld::Overlaps(const Bounds& a, const Bounds& b)
+{
+	return a.Min.x <= b.Max.x && b.Min.x <= a.Max.x
+		&& a.Min.y <= b.Max.y && b.Min.y <= a.Max.y
+		&& a.Min.z <= b.Max.z && b.Min.z <= a.Max.z;
+}
+
+bool PhysicsWorld::IsTouching(int a, int b) const
+{
+	return Overlaps(m_bounds[a], m_bounds[b]);
+}
+
+void PhysicsWorld::RefreshBounds(int index)
+{
+	const Collider* pCollider = m_colliders[index];
+	XMVECTOR center = XMLoadFloat3(&pCollider->m_center);
+	XMVECTOR halfExtents = XMLoadFloat3(&pCollider->m_halfExtents);
+	XMStoreFloat3(&m_bounds[index].Min, XMVectorSubtract(center, halfExtents));
+	XMStoreFloat3(&m_bounds[index].Max, XMVectorAdd(center, halfExtents));
+}
+
+void PhysicsWorld::AddContact(int a, int b)
+{
+	const Bounds& boundsA = m_bounds[a];
+	const Bounds& boundsB = m_bounds[b];
+
+	// Penetration on each axis, the contact normal is the axis of least penetration
+	float penetration[3] = {
+		MathHelper::Min(boundsA.Max.x - boundsB.Min.x, boundsB.Max.x - boundsA.Min.x),
+		MathHelper::Min(boundsA.Max.y - boundsB.Min.y, boundsB.Max.y - boundsA.Min.y),
+		MathHelper::Min(boundsA.Max.z - boundsB.Min.z, boundsB.Max.z - boundsA.Min.z)
+	};
+	float delta[3] = {
+		m_colliders[b]->m_center.x - m_colliders[a]->m_center.x,
+		m_colliders[b]->m_center.y - m_colliders[a]->m_center.y,
+		m_colliders[b]->m_center.z - m_colliders[a]->m_center.z
+	};
+
+	int axis = 0;
+	if (penetration[1] < penetration[axis])
+		axis = 1;
+	if (penetration[2] < penetration[axis])
+		axis = 2;
+
+	float normal[3] = { 0.0f, 0.0f, 0.0f };
+	normal[axis] = delta[axis] < 0.0f ? -1.0f : 1.0f;
+
+	// A contact with an active body wakes the sleeping island on the other side
+	if (m_colliders[a]->m_isSleeping)
+		WakeIsland(m_colliders[a]->m_islandId);
+	if (m_colliders[b]->m_isSleeping)
+		WakeIsland(m_colliders[b]->m_islandId);
+
+	Contact contact;
+	contact.A = a;
+	contact.B = b;
+	contact.Normal = XMFLOAT3(normal[0], normal[1], normal[2]);
+	contact.Penetration = penetration[axis];
+	m_contacts.push_back(contact);
+}
+
+void PhysicsWorld::WakeIsland(int islandId)
+{
+	auto it = m_sleepingIslands.find(islandId);
+	if (it == m_sleepingIslands.end())
+		return;
+
+	const std::vector<int>& members = it->second;
+	for (int i = 0; i < members.size(); i++)
+	{
+		Collider* pCollider = m_colliders[members[i]];
+		pCollider->m_isSleeping = false;
+		pCollider->m_sleepTimer = 0.0f;
+		pCollider->m_islandId = -1;
+	}
+	m_awakeCount += (int)members.size();
+	m_sleepingIslands.erase(it);
+}
+
+void PhysicsWorld::WakeAroundStatic(int index)
+{
+	// Bodies resting on the old bounds would float, the ones under the new bounds would stay embedded
+	Bounds previousBounds = m_bounds[index];
+	RefreshBounds(index);
+	const Collider* pStatic = m_colliders[index];
+	for (int i = 0; i < m_colliders.size(); i++)
+	{
+		const Collider* pCollider = m_colliders[i];
+		if (!pCollider->m_isSleeping || !pCollider->CanCollideWith(*pStatic))
+			continue;
+		if (Overlaps(m_bounds[i], previousBounds) || Overlaps(m_bounds[i], m_bounds[index]))
+			WakeIsland(pCollider->m_islandId);
+	}
+}
+
+int PhysicsWorld::FindRoot(int index)
+{
+	while (m_islandParent[index] != index)
+	{
+		// Path halving
+		m_islandParent[index] = m_islandParent[m_islandParent[index]];
+		index = m_islandParent[index];
+	}
+	return index;
+}
@@ -0,0 +1,92 @@
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator() : m_transientAllocations(0), m_copiedDescriptors(0), m_copyBatches(0)
+{
+}
+
+void DescriptorAllocator::Init(uint32_t persistentCount, uint32_t transientCount)
+{
+	m_persistentCapacity = persistentCount;
+	m_freePersistent.resize(persistentCount);
+	// Lowest indices on top, they get reused first
+	for (uint32_t i = 0; i < persistentCount; i++)
+		m_freePersistent[i] = persistentCount - 1 - i;
+	m_isPersistentFree.assign(persistentCount, 1);
+	m_transientRing.Init(transientCount);
+}
+
+uint32_t DescriptorAllocator::AllocatePersistent()
+{
+	std::lock_guard<std::mutex> lock(m_persistentMutex);
+	if (m_freePersistent.empty())
+	{
+		m_persistentFailures++;
+		return INVALID_DESCRIPTOR;
+	}
+
+	uint32_t descriptor = m_freePersistent.back();
+	m_freePersistent.pop_back();
+	m_isPersistentFree[descriptor] = 0;
+	m_persistentAllocations++;
+	uint32_t inUse = m_persistentCapacity - (uint32_t)m_freePersistent.size();
+	m_persistentPeak = inUse > m_persistentPeak ? inUse : m_persistentPeak;
+	return descriptor;
+}
+
+void DescriptorAllocator::FreePersistent(uint32_t descriptor)
+{
+	if (descriptor == INVALID_DESCRIPTOR)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_persistentMutex);
+	// Pushed twice, it would be handed out to two owners
+	if (descriptor >= m_persistentCapacity || m_isPersistentFree[descriptor] != 0)
+	{
+		m_invalidFrees++;
+		return;
+	}
+
+	m_freePersistent.push_back(descriptor);
+	m_isPersistentFree[descriptor] = 1;
+	m_persistentFrees++;
+}
+
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+	if (count == 0)
+		return INVALID_DESCRIPTOR;
+
+	uint64_t first = m_transientRing.Allocate(count, 1);
+	if (first == LinearRing::INVALID_OFFSET)
+		return INVALID_DESCRIPTOR;
+	m_transientAllocations.fetch_add(count, std::memory_order_relaxed);
+	return (uint32_t)first;
+}
+
+void DescriptorAllocator::AddCopies(uint64_t descriptorCount)
+{
+	m_copiedDescriptors.fetch_add(descriptorCount, std::memory_order_relaxed);
+	m_copyBatches.fetch_add(1, std::memory_order_relaxed);
+}
+
+DescriptorStats DescriptorAllocator::GetStats() const
+{
+	DescriptorStats stats;
+	{
+		std::lock_guard<std::mutex> lock(m_persistentMutex);
+		stats.PersistentCapacity = m_persistentCapacity;
+		stats.PersistentInUse = m_persistentCapacity - (uint32_t)m_freePersistent.size();
+		stats.PersistentPeak = m_persistentPeak;
+		stats.PersistentAllocations = m_persistentAllocations;
+		stats.PersistentFrees = m_persistentFrees;
+		stats.FailedAllocations = m_persistentFailures;
+		stats.InvalidFrees = m_invalidFrees;
+	}
+	stats.TransientCapacity = (uint32_t)m_transientRing.GetCapacity();
+	stats.TransientInUse = (uint32_t)m_transientRing.GetUsedSize();
+	stats.TransientAllocations = m_transientAllocations.load(std::memory_order_relaxed);
+	stats.FailedAllocations += m_transientRing.GetFailedCount();
+	stats.CopiedDescriptors = m_copiedDescriptors.load(std::memory_order_relaxed);
+	stats.CopyBatches = m_copyBatches.load(std::memory_order_relaxed);
+	return stats;
+}
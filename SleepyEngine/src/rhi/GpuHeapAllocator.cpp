@@ -0,0 +1,181 @@
+#include "GpuHeapAllocator.h"
+#include <algorithm>
+
+GpuHeapAllocator::GpuHeapAllocator()
+{
+}
+
+GpuHeapAllocator::~GpuHeapAllocator()
+{
+	for (int i = 0; i < m_heaps.size(); i++)
+	{
+		if (m_heaps[i] == nullptr)
+			continue;
+		m_pSource->DestroyHeap(i);
+		delete m_heaps[i];
+	}
+}
+
+bool GpuHeapAllocator::Init(GpuHeapSource* pSource, uint64_t heapSize)
+{
+	if (pSource == nullptr || heapSize < TlsfAllocator::GRANULARITY)
+		return false;
+
+	m_pSource = pSource;
+	m_heapSize = heapSize & ~(TlsfAllocator::GRANULARITY - 1);
+	return true;
+}
+
+GpuHeapAllocation GpuHeapAllocator::AllocateFromHeap(int heapIndex, uint64_t size, uint64_t alignment)
+{
+	GpuHeapAllocation allocation;
+	uint32_t block = m_heaps[heapIndex]->Allocate(size, alignment);
+	if (block == TlsfAllocator::INVALID_ALLOCATION)
+		return allocation;
+
+	allocation.HeapIndex = heapIndex;
+	allocation.Block = block;
+	allocation.Offset = m_heaps[heapIndex]->GetOffset(block);
+	allocation.Size = m_heaps[heapIndex]->GetSize(block);
+	return allocation;
+}
+
+GpuHeapAllocation GpuHeapAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	GpuHeapAllocation allocation;
+	if (m_pSource == nullptr || size == 0 || size > m_heapSize)
+		return allocation;
+
+	int freeIndex = -1;
+	for (int i = 0; i < m_heaps.size(); i++)
+	{
+		if (m_heaps[i] == nullptr)
+		{
+			freeIndex = freeIndex < 0 ? i : freeIndex;
+			continue;
+		}
+		// Cheap rejection before the bitmap search
+		if (m_heaps[i]->GetTotalSize() - m_heaps[i]->GetUsedSize() < size)
+			continue;
+		allocation = AllocateFromHeap(i, size, alignment);
+		if (allocation.IsValid())
+			return allocation;
+	}
+
+	if (freeIndex < 0)
+	{
+		freeIndex = (int)m_heaps.size();
+		m_heaps.push_back(nullptr);
+	}
+	if (!m_pSource->CreateHeap(freeIndex, m_heapSize))
+		return allocation;
+	m_heaps[freeIndex] = new TlsfAllocator();
+	m_heaps[freeIndex]->Init(m_heapSize);
+	return AllocateFromHeap(freeIndex, size, alignment);
+}
+
+void GpuHeapAllocator::Free(const GpuHeapAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (allocation.HeapIndex >= m_heaps.size() || m_heaps[allocation.HeapIndex] == nullptr)
+		return;
+	// Freed by Defragment once the callbacks returned, its id must not be reused before
+	if (allocation.HeapIndex == m_defragmentSource && std::find(m_movingBlocks.begin(), m_movingBlocks.end(), allocation.Block) != m_movingBlocks.end())
+		return;
+	m_heaps[allocation.HeapIndex]->Free(allocation.Block);
+	ReleaseHeapIfEmpty(allocation.HeapIndex);
+}
+
+void GpuHeapAllocator::ReleaseHeapIfEmpty(int heapIndex)
+{
+	// Keeps the first heap, an empty scene should not create and release it every frame
+	if (heapIndex == 0 || heapIndex == m_defragmentSource || !m_heaps[heapIndex]->IsEmpty())
+		return;
+
+	m_pSource->DestroyHeap(heapIndex);
+	delete m_heaps[heapIndex];
+	m_heaps[heapIndex] = nullptr;
+}
+
+int GpuHeapAllocator::Defragment(int maxMoves, const MoveCallback& onMove)
+{
+	// Two calls would pick the same source and free its blocks twice
+	std::lock_guard<std::mutex> defragmentLock(m_defragmentMutex);
+
+	// Destinations are reserved under the lock, the callbacks run without it
+	std::vector<Move> moves;
+	int source = -1;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// The least used heap is the cheapest one to empty, the first one is never released
+		for (int i = 1; i < m_heaps.size(); i++)
+		{
+			if (m_heaps[i] != nullptr && (source < 0 || m_heaps[i]->GetUsedSize() < m_heaps[source]->GetUsedSize()))
+				source = i;
+		}
+		if (source < 0)
+			return 0;
+
+		TlsfAllocator* pSource = m_heaps[source];
+		uint32_t block = pSource->GetNextAllocation(TlsfAllocator::INVALID_ALLOCATION);
+		while (block != TlsfAllocator::INVALID_ALLOCATION && moves.size() < maxMoves)
+		{
+			Move move;
+			move.From.HeapIndex = source;
+			move.From.Block = block;
+			move.From.Offset = pSource->GetOffset(block);
+			move.From.Size = pSource->GetSize(block);
+
+			// Only into heaps which already exist, defragmenting must not reserve memory.
+			// Moved allocations are only GRANULARITY aligned, which is enough for buffers.
+			for (int i = 0; i < m_heaps.size() && !move.To.IsValid(); i++)
+			{
+				if (i != source && m_heaps[i] != nullptr)
+					move.To = AllocateFromHeap(i, move.From.Size, TlsfAllocator::GRANULARITY);
+			}
+			if (!move.To.IsValid())
+				break;
+
+			moves.push_back(move);
+			m_movingBlocks.push_back(block);
+			block = pSource->GetNextAllocation(block);
+		}
+		if (moves.empty())
+			return 0;
+		m_defragmentSource = source;
+	}
+
+	// The sources stay allocated until every callback returned, nothing else can take them
+	for (int i = 0; i < moves.size(); i++)
+		onMove(moves[i].From, moves[i].To);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_defragmentSource = -1;
+	m_movingBlocks.clear();
+	// Kept while it was the source, checked anyway
+	if (m_heaps[source] == nullptr)
+		return (int)moves.size();
+	for (int i = 0; i < moves.size(); i++)
+		m_heaps[source]->Free(moves[i].From.Block);
+	ReleaseHeapIfEmpty(source);
+	return (int)moves.size();
+}
+
+int GpuHeapAllocator::GetHeapCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_heaps.size();
+}
+
+TlsfStats GpuHeapAllocator::GetHeapStats(int heapIndex) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (heapIndex < 0 || heapIndex >= m_heaps.size() || m_heaps[heapIndex] == nullptr)
+		return TlsfStats();
+	return m_heaps[heapIndex]->GetStats();
+}
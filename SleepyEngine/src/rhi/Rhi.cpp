@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "Rhi.h"
+#include "RhiNull.h"
+#include "RhiSoftware.h"
+#ifdef _WIN32
+#include "RhiD3D12.h"
+#endif
+
+void RhiStats::Add(const RhiStats& stats)
+{
+	CommandLists += stats.CommandLists;
+	RenderPasses += stats.RenderPasses;
+	DrawCalls += stats.DrawCalls;
+	Instances += stats.Instances;
+	Triangles += stats.Triangles;
+	PipelineChanges += stats.PipelineChanges;
+	BufferBindings += stats.BufferBindings;
+	ValidationErrors += stats.ValidationErrors;
+}
+
+RhiPipeline::RhiPipeline()
+{
+	static std::atomic<uint32_t> s_nextSortId{ 0 };
+	m_sortId = s_nextSortId.fetch_add(1, std::memory_order_relaxed);
+}
+
+RhiDevice* CreateRhiDevice(RhiBackend backend, JobSystem* pJobSystem)
+{
+	switch (backend)
+	{
+	case RhiBackend::Null:
+		return new RhiNullDevice();
+	case RhiBackend::Software:
+		return new RhiSoftwareDevice(pJobSystem);
+#ifdef _WIN32
+	case RhiBackend::D3D12:
+	{
+		RhiD3D12Device* pDevice = new RhiD3D12Device();
+		pDevice->Init();
+		return pDevice;
+	}
+#endif
+	default:
+		return nullptr;
+	}
+}
@@ -0,0 +1,822 @@
+#include "pch.h"
+#include "RhiD3D12.h"
+#include "Utils/HResultException.h"
+#include "Profiler.h"
+#include "Hash.h"
+
+// BUFFER
+
+RhiD3D12Buffer::RhiD3D12Buffer(const RhiBufferDesc& desc, ID3D12Resource* pResource)
+{
+	m_desc = desc;
+	m_pResource = pResource;
+}
+
+RhiD3D12Buffer::RhiD3D12Buffer(const RhiBufferDesc& desc, ID3D12Resource* pHeapBuffer, void* pMappedData, GpuHeapAllocator* pAllocator, const GpuHeapAllocation& allocation)
+{
+	m_desc = desc;
+	m_pResource = pHeapBuffer;
+	m_pMappedData = pMappedData;
+	m_pAllocator = pAllocator;
+	m_allocation = allocation;
+}
+
+RhiD3D12Buffer::~RhiD3D12Buffer()
+{
+	// The heap buffer belongs to the heap source
+	if (m_pAllocator != nullptr)
+	{
+		m_pAllocator->Free(m_allocation);
+		return;
+	}
+	if (m_pMappedData != nullptr)
+		m_pResource->Unmap(0, nullptr);
+	RELEASE(m_pResource);
+}
+
+void* RhiD3D12Buffer::Map()
+{
+	if (m_desc.HeapType != RhiHeapType::Upload)
+		return nullptr;
+
+	// Upload heaps can stay mapped for their whole lifetime
+	if (m_pMappedData == nullptr)
+		ThrowIfFailed(m_pResource->Map(0, nullptr, &m_pMappedData));
+	return m_pMappedData;
+}
+
+void RhiD3D12Buffer::Unmap()
+{
+}
+
+// HEAP SOURCE
+
+RhiD3D12HeapSource::RhiD3D12HeapSource(ID3D12Device* pDevice, D3D12_HEAP_TYPE heapType)
+{
+	m_pDevice = pDevice;
+	m_heapType = heapType;
+}
+
+bool RhiD3D12HeapSource::CreateHeap(int heapIndex, uint64_t size)
+{
+	if (heapIndex >= MAX_HEAP_COUNT)
+		return false;
+
+	Heap& heap = m_heaps[heapIndex];
+	CD3DX12_HEAP_DESC heapDesc(size, m_heapType, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+	if (FAILED(m_pDevice->CreateHeap(&heapDesc, __uuidof(ID3D12Heap), (void**)&heap.pHeap)))
+		return false;
+
+	bool isUpload = m_heapType == D3D12_HEAP_TYPE_UPLOAD;
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(m_pDevice->CreatePlacedResource(heap.pHeap, 0, &bufferDesc,
+		isUpload ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON, nullptr, __uuidof(ID3D12Resource), (void**)&heap.pBuffer));
+	if (isUpload)
+		ThrowIfFailed(heap.pBuffer->Map(0, nullptr, (void**)&heap.pMappedData));
+	return true;
+}
+
+void RhiD3D12HeapSource::DestroyHeap(int heapIndex)
+{
+	Heap& heap = m_heaps[heapIndex];
+	if (heap.pMappedData != nullptr)
+		heap.pBuffer->Unmap(0, nullptr);
+	RELEASE(heap.pBuffer);
+	RELEASE(heap.pHeap);
+	heap.pMappedData = nullptr;
+}
+
+// PIPELINE
+
+RhiD3D12Pipeline::RhiD3D12Pipeline(const RhiPipelineDesc& desc, ID3D12RootSignature* pRootSignature, ID3D12PipelineState* pPipelineState, bool isFromCachedBlob)
+{
+	m_desc = desc;
+	// The bytecode is not ours, it may be freed once the pipeline is created
+	m_desc.VertexShader = RhiShaderBytecode();
+	m_desc.PixelShader = RhiShaderBytecode();
+	m_desc.CachedBlob = RhiShaderBytecode();
+	m_pRootSignature = pRootSignature;
+	m_pPipelineState = pPipelineState;
+	m_isFromCachedBlob = isFromCachedBlob;
+}
+
+bool RhiD3D12Pipeline::GetCachedBlob(std::vector<uint8_t>& blob) const
+{
+	ID3DBlob* pBlob = nullptr;
+	if (FAILED(m_pPipelineState->GetCachedBlob(&pBlob)) || pBlob == nullptr)
+		return false;
+	const uint8_t* pData = (const uint8_t*)pBlob->GetBufferPointer();
+	blob.assign(pData, pData + pBlob->GetBufferSize());
+	RELEASE(pBlob);
+	return !blob.empty();
+}
+
+RhiD3D12Pipeline::~RhiD3D12Pipeline()
+{
+	RELEASE(m_pPipelineState);
+	RELEASE(m_pRootSignature);
+}
+
+// DESCRIPTOR HEAP
+
+RhiD3D12DescriptorHeap::RhiD3D12DescriptorHeap()
+{
+}
+
+RhiD3D12DescriptorHeap::~RhiD3D12DescriptorHeap()
+{
+	RELEASE(m_pShaderVisibleHeap);
+	RELEASE(m_pStagingHeap);
+}
+
+void RhiD3D12DescriptorHeap::Init(ID3D12Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t persistentCount, uint32_t transientCount)
+{
+	m_pDevice = pDevice;
+	m_type = type;
+	m_descriptorSize = pDevice->GetDescriptorHandleIncrementSize(type);
+	m_allocator.Init(persistentCount, transientCount);
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
+	heapDesc.NumDescriptors = persistentCount;
+	heapDesc.Type = type;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	heapDesc.NodeMask = 0;
+	ThrowIfFailed(pDevice->CreateDescriptorHeap(&heapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&m_pStagingHeap));
+
+	// Only CBV/SRV/UAV and sampler heaps can be shader visible
+	if (transientCount > 0)
+	{
+		heapDesc.NumDescriptors = transientCount;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		ThrowIfFailed(pDevice->CreateDescriptorHeap(&heapDesc, __uuidof(ID3D12DescriptorHeap), (void**)&m_pShaderVisibleHeap));
+	}
+}
+
+void RhiD3D12DescriptorHeap::FreePersistent(uint32_t descriptor)
+{
+	std::lock_guard<std::mutex> lock(m_copyMutex);
+	// Another thread could reuse and overwrite it before a staged copy reads it
+	if (!m_stagedCopies.empty())
+	{
+		m_deferredFrees.push_back(descriptor);
+		return;
+	}
+	m_allocator.FreePersistent(descriptor);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RhiD3D12DescriptorHeap::GetCpuHandle(uint32_t persistent) const
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pStagingHeap->GetCPUDescriptorHandleForHeapStart(), persistent, m_descriptorSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE RhiD3D12DescriptorHeap::GetGpuHandle(uint32_t transient) const
+{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_pShaderVisibleHeap->GetGPUDescriptorHandleForHeapStart(), transient, m_descriptorSize);
+}
+
+void RhiD3D12DescriptorHeap::StageCopies(uint32_t firstTransient, const uint32_t* pPersistent, uint32_t count)
+{
+	std::lock_guard<std::mutex> lock(m_copyMutex);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		DescriptorCopy copy;
+		copy.Transient = firstTransient + i;
+		copy.Persistent = pPersistent[i];
+		m_stagedCopies.push_back(copy);
+	}
+}
+
+void RhiD3D12DescriptorHeap::FlushCopies()
+{
+	std::lock_guard<std::mutex> lock(m_copyMutex);
+	if (m_stagedCopies.empty())
+		return;
+
+	// Copies contiguous on both sides become one range
+	m_destinationStarts.clear();
+	m_sourceStarts.clear();
+	m_rangeSizes.clear();
+	D3D12_CPU_DESCRIPTOR_HANDLE destinationStart = m_pShaderVisibleHeap->GetCPUDescriptorHandleForHeapStart();
+	for (int i = 0; i < m_stagedCopies.size(); i++)
+	{
+		const DescriptorCopy& copy = m_stagedCopies[i];
+		if (i > 0 && copy.Transient == m_stagedCopies[i - 1].Transient + 1 && copy.Persistent == m_stagedCopies[i - 1].Persistent + 1)
+		{
+			m_rangeSizes.back()++;
+			continue;
+		}
+		m_destinationStarts.push_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(destinationStart, copy.Transient, m_descriptorSize));
+		m_sourceStarts.push_back(GetCpuHandle(copy.Persistent));
+		m_rangeSizes.push_back(1);
+	}
+	UINT rangeCount = (UINT)m_rangeSizes.size();
+	m_pDevice->CopyDescriptors(rangeCount, m_destinationStarts.data(), m_rangeSizes.data(),
+		rangeCount, m_sourceStarts.data(), m_rangeSizes.data(), m_type);
+
+	m_allocator.AddCopies(m_stagedCopies.size());
+	m_stagedCopies.clear();
+
+	for (int i = 0; i < m_deferredFrees.size(); i++)
+		m_allocator.FreePersistent(m_deferredFrees[i]);
+	m_deferredFrees.clear();
+}
+
+// SWAP CHAIN
+
+RhiD3D12SwapChain::RhiD3D12SwapChain()
+{
+}
+
+RhiD3D12SwapChain::~RhiD3D12SwapChain()
+{
+	RELEASE(m_pDepthStencilBuffer);
+	for (int i = 0; i < MAX_BUFFER_COUNT; i++)
+		RELEASE(m_pBuffers[i]);
+	if (m_pDevice != nullptr)
+	{
+		RhiD3D12DescriptorHeap* pRtvHeap = m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+		for (int i = 0; i < MAX_BUFFER_COUNT; i++)
+			pRtvHeap->FreePersistent(m_rtvDescriptors[i]);
+		m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)->FreePersistent(m_dsvDescriptor);
+	}
+	RELEASE(m_pSwapChain);
+}
+
+void RhiD3D12SwapChain::Init(RhiD3D12Device* pDevice, const RhiSwapChainDesc& desc)
+{
+	m_pDevice = pDevice;
+	m_desc = desc;
+	m_desc.BufferCount = desc.BufferCount < 2 ? 2 : (desc.BufferCount > MAX_BUFFER_COUNT ? MAX_BUFFER_COUNT : desc.BufferCount);
+
+	DXGI_SWAP_CHAIN_DESC swapChainDescriptor;
+	swapChainDescriptor.BufferDesc.Width = m_desc.Width;
+	swapChainDescriptor.BufferDesc.Height = m_desc.Height;
+	swapChainDescriptor.BufferDesc.RefreshRate.Numerator = 60;
+	swapChainDescriptor.BufferDesc.RefreshRate.Denominator = 1;
+	swapChainDescriptor.BufferDesc.Format = BACK_BUFFER_FORMAT;
+	swapChainDescriptor.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+	swapChainDescriptor.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+	// Flip model swap chains cannot be multisampled
+	swapChainDescriptor.SampleDesc.Count = 1;
+	swapChainDescriptor.SampleDesc.Quality = 0;
+	swapChainDescriptor.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swapChainDescriptor.BufferCount = m_desc.BufferCount;
+	swapChainDescriptor.OutputWindow = (HWND)m_desc.pWindow;
+	swapChainDescriptor.Windowed = true;
+	swapChainDescriptor.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+	swapChainDescriptor.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+
+	RhiD3D12Queue* pQueue = (RhiD3D12Queue*)pDevice->GetQueue();
+	ThrowIfFailed(pDevice->GetDxgiFactory()->CreateSwapChain(pQueue->GetCommandQueue(), &swapChainDescriptor, &m_pSwapChain)); //CreateSwapChainForHwnd()
+
+	CreateRenderTargetViews(pDevice->GetDevice());
+	CreateDepthStencilView(pDevice->GetDevice());
+}
+
+void RhiD3D12SwapChain::CreateRenderTargetViews(ID3D12Device* pDevice)
+{
+	RhiD3D12DescriptorHeap* pRtvHeap = m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	for (int i = 0; i < m_desc.BufferCount; i++)
+	{
+		m_rtvDescriptors[i] = pRtvHeap->AllocatePersistent();
+		if (m_rtvDescriptors[i] == DescriptorAllocator::INVALID_DESCRIPTOR)
+			ThrowIfFailed(E_OUTOFMEMORY);
+		ThrowIfFailed(m_pSwapChain->GetBuffer(i, __uuidof(ID3D12Resource), (void**)&m_pBuffers[i]));
+		pDevice->CreateRenderTargetView(m_pBuffers[i], nullptr, pRtvHeap->GetCpuHandle(m_rtvDescriptors[i]));
+	}
+}
+
+void RhiD3D12SwapChain::CreateDepthStencilView(ID3D12Device* pDevice)
+{
+	m_dsvDescriptor = m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)->AllocatePersistent();
+	if (m_dsvDescriptor == DescriptorAllocator::INVALID_DESCRIPTOR)
+		ThrowIfFailed(E_OUTOFMEMORY);
+
+	D3D12_RESOURCE_DESC depthStencilDesc;
+	depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	depthStencilDesc.Alignment = 0;
+	depthStencilDesc.Width = m_desc.Width;
+	depthStencilDesc.Height = m_desc.Height;
+	depthStencilDesc.DepthOrArraySize = 1;
+	depthStencilDesc.MipLevels = 1;
+	depthStencilDesc.Format = DEPTH_STENCIL_FORMAT;
+	depthStencilDesc.SampleDesc.Count = 1;
+	depthStencilDesc.SampleDesc.Quality = 0;
+	depthStencilDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+	// Describes a value used to optimize clear operations for a particular resource.
+	// https://learn.microsoft.com/en-us/windows/win32/api/d3d12/ns-d3d12-d3d12_clear_value
+	D3D12_CLEAR_VALUE optClear;
+	optClear.Format = DEPTH_STENCIL_FORMAT;
+	optClear.DepthStencil.Depth = 1.0f;
+	optClear.DepthStencil.Stencil = 0;
+
+	// Created in its only state, so no command list is needed to transition it
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	ThrowIfFailed(pDevice->CreateCommittedResource(
+		&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&depthStencilDesc,
+		D3D12_RESOURCE_STATE_DEPTH_WRITE,
+		&optClear,
+		__uuidof(ID3D12Resource),
+		(void**)&m_pDepthStencilBuffer
+	));
+	pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, nullptr, GetDepthStencilView()); //nullptr for default mip level 0
+}
+
+void RhiD3D12SwapChain::Present(bool isVSynced)
+{
+	ThrowIfFailed(m_pSwapChain->Present(isVSynced ? 1 : 0, 0));
+	m_backBufferIndex = (m_backBufferIndex + 1) % m_desc.BufferCount;
+	m_presentCount++;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RhiD3D12SwapChain::GetCurrentBackBufferView() const
+{
+	return m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)->GetCpuHandle(m_rtvDescriptors[m_backBufferIndex]);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RhiD3D12SwapChain::GetDepthStencilView() const
+{
+	return m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_DSV)->GetCpuHandle(m_dsvDescriptor);
+}
+
+// COMMAND LIST
+
+RhiD3D12CommandList::RhiD3D12CommandList()
+{
+}
+
+RhiD3D12CommandList::~RhiD3D12CommandList()
+{
+	RELEASE(m_pCommandList);
+	for (int i = 0; i < m_allocators.size(); i++)
+		RELEASE(m_allocators[i]);
+}
+
+void RhiD3D12CommandList::Init(ID3D12Device* pDevice, int frameSlotCount, ID3D12DescriptorHeap* pDescriptorHeap)
+{
+	m_pDescriptorHeap = pDescriptorHeap;
+	m_allocators.resize(frameSlotCount, nullptr);
+	for (int i = 0; i < m_allocators.size(); i++)
+		ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator), (void**)&m_allocators[i]));
+	ThrowIfFailed(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_allocators[0], nullptr, __uuidof(ID3D12CommandList), (void**)&m_pCommandList));
+
+	// Start off in a closed state. This is because the first time we
+	// refer to the command list we will Reset it, and it needs to be
+	// closed before calling Reset.
+	ThrowIfFailed(m_pCommandList->Close());
+}
+
+void RhiD3D12CommandList::Begin(int frameSlot)
+{
+	m_stats = RhiStats();
+	m_pPipeline = nullptr;
+	// Reuse the memory associated with command recording.
+	// We can only reset when the associated command lists have finished
+	// execution on the GPU, which the caller made sure of.
+	ThrowIfFailed(m_allocators[frameSlot]->Reset());
+	ThrowIfFailed(m_pCommandList->Reset(m_allocators[frameSlot], nullptr));
+	m_pCommandList->SetDescriptorHeaps(1, &m_pDescriptorHeap);
+}
+
+void RhiD3D12CommandList::End()
+{
+	// Done recording commands.
+	ThrowIfFailed(m_pCommandList->Close());
+}
+
+void RhiD3D12CommandList::BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed)
+{
+	m_pRenderPassSwapChain = (RhiD3D12SwapChain*)pSwapChain;
+	D3D12_CPU_DESCRIPTOR_HANDLE currentBackBufferView = m_pRenderPassSwapChain->GetCurrentBackBufferView();
+	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = m_pRenderPassSwapChain->GetDepthStencilView();
+
+	// A resumed pass finds the back buffer as the previous list left it: already a render target, already cleared
+	if (!isResumed)
+	{
+		// Indicate a state transition on the resource usage.
+		CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+			m_pRenderPassSwapChain->GetCurrentBackBuffer(),
+			D3D12_RESOURCE_STATE_PRESENT,
+			D3D12_RESOURCE_STATE_RENDER_TARGET
+		);
+		m_pCommandList->ResourceBarrier(1, &resourceBarrier);
+
+		// Clear the back buffer and depth buffer.
+		m_pCommandList->ClearRenderTargetView(currentBackBufferView, clearColor, 0, nullptr);
+		m_pCommandList->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+	}
+
+	// Specify the buffers we are going to render to.
+	m_pCommandList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
+	m_stats.RenderPasses++;
+}
+
+void RhiD3D12CommandList::EndRenderPass(bool isSuspended)
+{
+	// The next list resumes the pass, the back buffer stays a render target
+	if (!isSuspended)
+	{
+		CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+			m_pRenderPassSwapChain->GetCurrentBackBuffer(),
+			D3D12_RESOURCE_STATE_RENDER_TARGET,
+			D3D12_RESOURCE_STATE_PRESENT
+		);
+		m_pCommandList->ResourceBarrier(1, &resourceBarrier);
+	}
+	m_pRenderPassSwapChain = nullptr;
+}
+
+void RhiD3D12CommandList::SetViewport(const RhiViewport& viewport)
+{
+	D3D12_VIEWPORT d3dViewport;
+	d3dViewport.TopLeftX = viewport.X;
+	d3dViewport.TopLeftY = viewport.Y;
+	d3dViewport.Width = viewport.Width;
+	d3dViewport.Height = viewport.Height;
+	d3dViewport.MinDepth = viewport.MinDepth;
+	d3dViewport.MaxDepth = viewport.MaxDepth;
+	m_pCommandList->RSSetViewports(1, &d3dViewport);
+
+	D3D12_RECT scissorRect;
+	scissorRect.left = (LONG)viewport.X;
+	scissorRect.top = (LONG)viewport.Y;
+	scissorRect.right = (LONG)(viewport.X + viewport.Width);
+	scissorRect.bottom = (LONG)(viewport.Y + viewport.Height);
+	m_pCommandList->RSSetScissorRects(1, &scissorRect);
+}
+
+void RhiD3D12CommandList::SetPipeline(RhiPipeline* pPipeline)
+{
+	if (pPipeline == m_pPipeline)
+		return;
+
+	RhiD3D12Pipeline* pD3D12Pipeline = (RhiD3D12Pipeline*)pPipeline;
+	m_pCommandList->SetPipelineState(pD3D12Pipeline->GetPipelineState());
+	m_pCommandList->SetGraphicsRootSignature(pD3D12Pipeline->GetRootSignature());
+	m_pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_pPipeline = pPipeline;
+	m_stats.PipelineChanges++;
+}
+
+void RhiD3D12CommandList::SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride)
+{
+	D3D12_VERTEX_BUFFER_VIEW view;
+	view.BufferLocation = pBuffer->GetGpuAddress() + offset;
+	view.SizeInBytes = (UINT)(pBuffer->GetDesc().Size - offset);
+	view.StrideInBytes = stride;
+	m_pCommandList->IASetVertexBuffers(0, 1, &view);
+	m_stats.BufferBindings++;
+}
+
+void RhiD3D12CommandList::SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset)
+{
+	D3D12_INDEX_BUFFER_VIEW view;
+	view.BufferLocation = pBuffer->GetGpuAddress() + offset;
+	view.SizeInBytes = (UINT)(pBuffer->GetDesc().Size - offset);
+	view.Format = DXGI_FORMAT_R32_UINT;
+	m_pCommandList->IASetIndexBuffer(&view);
+	m_stats.BufferBindings++;
+}
+
+void RhiD3D12CommandList::SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset)
+{
+	m_pCommandList->SetGraphicsRootConstantBufferView(slot, pBuffer->GetGpuAddress() + offset);
+	m_stats.BufferBindings++;
+}
+
+void RhiD3D12CommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	m_pCommandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, 0);
+	m_stats.DrawCalls++;
+	m_stats.Instances += instanceCount;
+	m_stats.Triangles += (uint64_t)(indexCount / 3) * instanceCount;
+}
+
+// QUEUE
+
+RhiD3D12Queue::RhiD3D12Queue()
+{
+}
+
+RhiD3D12Queue::~RhiD3D12Queue()
+{
+	if (m_eventHandle != nullptr)
+		CloseHandle(m_eventHandle);
+	RELEASE(m_pFence);
+	RELEASE(m_pCommandQueue);
+}
+
+void RhiD3D12Queue::Init(RhiD3D12Device* pDevice)
+{
+	m_pDevice = pDevice;
+
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(pDevice->GetDevice()->CreateCommandQueue(&queueDesc, __uuidof(ID3D12CommandQueue), (void**)&m_pCommandQueue));
+	ThrowIfFailed(pDevice->GetDevice()->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence), (void**)&m_pFence));
+	m_lastSignaledValue = 0;
+	m_eventHandle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+}
+
+void RhiD3D12Queue::Submit(RhiCommandList* const* ppCommandLists, int count)
+{
+	// The tables of the lists must be filled before they execute
+	m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->FlushCopies();
+
+	// Add the command lists to the queue for execution, in one call so they run in order
+	m_commandLists.clear();
+	for (int i = 0; i < count; i++)
+	{
+		m_commandLists.push_back(((RhiD3D12CommandList*)ppCommandLists[i])->GetCommandList());
+		m_pDevice->m_stats.Add(ppCommandLists[i]->GetStats());
+		m_pDevice->m_stats.CommandLists++;
+	}
+	m_pCommandQueue->ExecuteCommandLists((UINT)m_commandLists.size(), m_commandLists.data());
+}
+
+uint64_t RhiD3D12Queue::Signal()
+{
+	// The fence is set on the GPU timeline, once the commands submitted before are done
+	m_lastSignaledValue++;
+	ThrowIfFailed(m_pCommandQueue->Signal(m_pFence, m_lastSignaledValue));
+
+	// Transient descriptors allocated so far are used until this signal completes
+	RhiD3D12DescriptorHeap* pDescriptorHeap = m_pDevice->GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	pDescriptorHeap->EndFrame(m_lastSignaledValue);
+	pDescriptorHeap->Retire(m_pFence->GetCompletedValue());
+	return m_lastSignaledValue;
+}
+
+uint64_t RhiD3D12Queue::GetCompletedValue()
+{
+	return m_pFence->GetCompletedValue();
+}
+
+void RhiD3D12Queue::WaitFor(uint64_t value)
+{
+	if (m_pFence->GetCompletedValue() >= value)
+		return;
+
+	PROFILE_SCOPE("WaitForGPU");
+	ThrowIfFailed(m_pFence->SetEventOnCompletion(value, m_eventHandle));
+	WaitForSingleObject(m_eventHandle, INFINITE);
+}
+
+// DEVICE
+
+RhiD3D12Device::RhiD3D12Device()
+{
+}
+
+RhiD3D12Device::~RhiD3D12Device()
+{
+	// Every buffer is gone, the allocators release their heaps
+	for (int i = 0; i < 2; i++)
+	{
+		delete m_pHeapAllocators[i];
+		delete m_pHeapSources[i];
+	}
+	for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; i++)
+		delete m_pDescriptorHeaps[i];
+	// The pipelines released theirs already
+	for (auto& rootSignature : m_rootSignatures)
+		RELEASE(rootSignature.second);
+	RELEASE(m_pDevice);
+	RELEASE(m_pDxgiFactory);
+}
+
+void RhiD3D12Device::Init()
+{
+	PROFILE_FUNCTION();
+#if defined(DEBUG) || defined(_DEBUG)
+	EnableAdditionalD3D12Debug();
+#endif
+	ThrowIfFailed(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&m_pDxgiFactory));
+	ThrowIfFailed(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, _uuidof(ID3D12Device), (void**)&m_pDevice));
+	//if failed, check book for "WARP_Adapters".
+	m_queue.Init(this);
+
+	m_pHeapSources[(int)RhiHeapType::Default] = new RhiD3D12HeapSource(m_pDevice, D3D12_HEAP_TYPE_DEFAULT);
+	m_pHeapSources[(int)RhiHeapType::Upload] = new RhiD3D12HeapSource(m_pDevice, D3D12_HEAP_TYPE_UPLOAD);
+	for (int i = 0; i < 2; i++)
+	{
+		m_pHeapAllocators[i] = new GpuHeapAllocator();
+		m_pHeapAllocators[i]->Init(m_pHeapSources[i], HEAP_SIZE);
+	}
+
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = new RhiD3D12DescriptorHeap();
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->Init(m_pDevice, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PERSISTENT_CBV_SRV_UAV_COUNT, TRANSIENT_CBV_SRV_UAV_COUNT);
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_RTV] = new RhiD3D12DescriptorHeap();
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_RTV]->Init(m_pDevice, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RTV_COUNT, 0);
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_DSV] = new RhiD3D12DescriptorHeap();
+	m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_DSV]->Init(m_pDevice, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DSV_COUNT, 0);
+
+	// Only the description matters, the depth test and the shaders are in the cache keys already
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+	FillPipelineStateDesc(RhiPipelineDesc(), nullptr, psoDesc);
+	uint64_t hash = Hash::Integer(psoDesc.InputLayout.NumElements);
+	for (UINT i = 0; i < psoDesc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = psoDesc.InputLayout.pInputElementDescs[i];
+		hash = Hash::String(element.SemanticName, hash);
+		hash = Hash::Integer(element.SemanticIndex, hash);
+		hash = Hash::Integer(element.Format, hash);
+		hash = Hash::Integer(element.InputSlot, hash);
+		hash = Hash::Integer(element.AlignedByteOffset, hash);
+		hash = Hash::Integer(element.InputSlotClass, hash);
+		hash = Hash::Integer(element.InstanceDataStepRate, hash);
+	}
+	hash = Hash::Bytes(&psoDesc.BlendState, sizeof(psoDesc.BlendState), hash);
+	hash = Hash::Bytes(&psoDesc.RasterizerState, sizeof(psoDesc.RasterizerState), hash);
+	hash = Hash::Bytes(&psoDesc.DepthStencilState, sizeof(psoDesc.DepthStencilState), hash);
+	hash = Hash::Integer(psoDesc.SampleMask, hash);
+	hash = Hash::Integer(psoDesc.PrimitiveTopologyType, hash);
+	hash = Hash::Integer(psoDesc.NumRenderTargets, hash);
+	hash = Hash::Bytes(psoDesc.RTVFormats, sizeof(psoDesc.RTVFormats), hash);
+	hash = Hash::Integer(psoDesc.DSVFormat, hash);
+	hash = Hash::Integer(psoDesc.SampleDesc.Count, hash);
+	m_pipelineStateHash = Hash::Integer(psoDesc.SampleDesc.Quality, hash);
+}
+
+void RhiD3D12Device::EnableAdditionalD3D12Debug()
+{
+	ID3D12Debug* pDebugController;
+	ThrowIfFailed(D3D12GetDebugInterface(__uuidof(ID3D12Debug), (void**)&pDebugController)); //should throw error
+	pDebugController->EnableDebugLayer();
+	RELEASE(pDebugController);
+	std::cout << "Debug Layer Enabled" << std::endl;
+}
+
+RhiBuffer* RhiD3D12Device::CreateBuffer(const RhiBufferDesc& desc)
+{
+	if (desc.Size == 0)
+		return nullptr;
+
+	// Small buffers are ranges of a shared heap
+	if (desc.Size < DEDICATED_BUFFER_SIZE)
+	{
+		int heapType = (int)desc.HeapType;
+		GpuHeapAllocation allocation = m_pHeapAllocators[heapType]->Allocate(desc.Size);
+		if (allocation.IsValid())
+		{
+			RhiD3D12HeapSource* pSource = m_pHeapSources[heapType];
+			uint8_t* pMappedData = pSource->GetMappedData(allocation.HeapIndex);
+			if (pMappedData != nullptr)
+				pMappedData += allocation.Offset;
+			return new RhiD3D12Buffer(desc, pSource->GetBuffer(allocation.HeapIndex), pMappedData, m_pHeapAllocators[heapType], allocation);
+		}
+	}
+
+	bool isUpload = desc.HeapType == RhiHeapType::Upload;
+	CD3DX12_HEAP_PROPERTIES heapProperties(isUpload ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(desc.Size);
+	ID3D12Resource* pResource = nullptr;
+	ThrowIfFailed(m_pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		isUpload ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON, nullptr, __uuidof(ID3D12Resource), (void**)&pResource));
+	return new RhiD3D12Buffer(desc, pResource);
+}
+
+ID3D12RootSignature* RhiD3D12Device::GetRootSignature(int constantBufferCount)
+{
+	D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	uint64_t key = Hash::Integer(flags, Hash::Integer(constantBufferCount));
+
+	// Created under the lock, it only happens once per description
+	std::lock_guard<std::mutex> lock(m_rootSignatureMutex);
+	auto found = m_rootSignatures.find(key);
+	if (found != m_rootSignatures.end())
+	{
+		found->second->AddRef();
+		return found->second;
+	}
+
+	// One root constant buffer view per slot, bound with SetConstantBuffer
+	std::vector<CD3DX12_ROOT_PARAMETER> rootParameters(constantBufferCount);
+	for (int i = 0; i < rootParameters.size(); i++)
+		rootParameters[i].InitAsConstantBufferView(i);
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc((UINT)rootParameters.size(), rootParameters.data(), 0, nullptr, flags);
+
+	ID3DBlob* pSerializedRootSignature = nullptr;
+	ID3DBlob* pErrorBlob = nullptr;
+	HRESULT hr = D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &pSerializedRootSignature, &pErrorBlob);
+	if (pErrorBlob != nullptr)
+	{
+		::OutputDebugStringA((char*)pErrorBlob->GetBufferPointer());
+		RELEASE(pErrorBlob);
+	}
+	// Returned instead of thrown, pipelines are also created on workers. Their messages are
+	// written at once and not flushed, lines of several workers would interleave otherwise.
+	if (FAILED(hr))
+	{
+		std::cout << ("D3D12SerializeRootSignature failed: " + D3DUtils::HrToString(hr) + "\n");
+		return nullptr;
+	}
+
+	ID3D12RootSignature* pRootSignature = nullptr;
+	hr = m_pDevice->CreateRootSignature(0, pSerializedRootSignature->GetBufferPointer(), pSerializedRootSignature->GetBufferSize(),
+		__uuidof(ID3D12RootSignature), (void**)&pRootSignature);
+	RELEASE(pSerializedRootSignature);
+	if (FAILED(hr))
+	{
+		std::cout << ("CreateRootSignature failed: " + D3DUtils::HrToString(hr) + "\n");
+		return nullptr;
+	}
+
+	// The map keeps its own reference
+	pRootSignature->AddRef();
+	m_rootSignatures[key] = pRootSignature;
+	return pRootSignature;
+}
+
+void RhiD3D12Device::FillPipelineStateDesc(const RhiPipelineDesc& desc, ID3D12RootSignature* pRootSignature, D3D12_GRAPHICS_PIPELINE_STATE_DESC& psoDesc) const
+{
+	// Vertex of Mesh.h
+	static const D3D12_INPUT_ELEMENT_DESC s_inputLayout[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	psoDesc = {};
+	psoDesc.InputLayout = { s_inputLayout, _countof(s_inputLayout) };
+	psoDesc.pRootSignature = pRootSignature;
+	psoDesc.VS = { desc.VertexShader.pData, desc.VertexShader.Size };
+	psoDesc.PS = { desc.PixelShader.pData, desc.PixelShader.Size };
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	psoDesc.DepthStencilState.DepthEnable = desc.IsDepthTested;
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.NumRenderTargets = 1;
+	psoDesc.RTVFormats[0] = RhiD3D12SwapChain::BACK_BUFFER_FORMAT;
+	psoDesc.SampleDesc.Count = 1;
+	psoDesc.SampleDesc.Quality = 0;
+	psoDesc.DSVFormat = RhiD3D12SwapChain::DEPTH_STENCIL_FORMAT;
+}
+
+RhiPipeline* RhiD3D12Device::CreatePipeline(const RhiPipelineDesc& desc)
+{
+	PROFILE_FUNCTION();
+	if (desc.VertexShader.pData == nullptr || desc.PixelShader.pData == nullptr)
+		return nullptr;
+
+	ID3D12RootSignature* pRootSignature = GetRootSignature(desc.ConstantBufferCount);
+	if (pRootSignature == nullptr)
+		return nullptr;
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+	FillPipelineStateDesc(desc, pRootSignature, psoDesc);
+	psoDesc.CachedPSO = { desc.CachedBlob.pData, desc.CachedBlob.Size };
+
+	ID3D12PipelineState* pPipelineState = nullptr;
+	HRESULT psoResult = m_pDevice->CreateGraphicsPipelineState(&psoDesc, __uuidof(ID3D12PipelineState), (void**)&pPipelineState);
+	bool isFromCachedBlob = SUCCEEDED(psoResult) && desc.CachedBlob.pData != nullptr;
+	if (FAILED(psoResult) && desc.CachedBlob.pData != nullptr)
+	{
+		// Another driver or adapter wrote the blob (D3D12_ERROR_DRIVER_VERSION_MISMATCH,
+		// D3D12_ERROR_ADAPTER_NOT_FOUND), or it doesn't match the description: compile again
+		psoDesc.CachedPSO = {};
+		psoResult = m_pDevice->CreateGraphicsPipelineState(&psoDesc, __uuidof(ID3D12PipelineState), (void**)&pPipelineState);
+	}
+	if (FAILED(psoResult))
+	{
+		// Shaders which don't match each other or the root signature
+		std::cout << ("CreateGraphicsPipelineState failed: " + D3DUtils::HrToString(psoResult) + "\n");
+		RELEASE(pRootSignature);
+		return nullptr;
+	}
+	return new RhiD3D12Pipeline(desc, pRootSignature, pPipelineState, isFromCachedBlob);
+}
+
+RhiCommandList* RhiD3D12Device::CreateCommandList(int frameSlotCount)
+{
+	RhiD3D12CommandList* pCommandList = new RhiD3D12CommandList();
+	pCommandList->Init(m_pDevice, frameSlotCount, m_pDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->GetShaderVisibleHeap());
+	return pCommandList;
+}
+
+RhiSwapChain* RhiD3D12Device::CreateSwapChain(const RhiSwapChainDesc& desc)
+{
+	if (desc.pWindow == nullptr || desc.Width == 0 || desc.Height == 0)
+		return nullptr;
+
+	RhiD3D12SwapChain* pSwapChain = new RhiD3D12SwapChain();
+	pSwapChain->Init(this, desc);
+	return pSwapChain;
+}
+
+std::string RhiD3D12Device::GetErrorReason()
+{
+	if (m_pDevice == nullptr)
+		return "";
+
+	HRESULT hr = m_pDevice->GetDeviceRemovedReason();
+	if (SUCCEEDED(hr))
+		return "";
+	return "Device Removed Reason:\n" + D3DUtils::HrToString(hr);
+}
@@ -0,0 +1,331 @@
+#include "RhiNull.h"
+#include <cstring>
+
+// BUFFER
+
+RhiNullBuffer::RhiNullBuffer(const RhiBufferDesc& desc, uint64_t gpuAddress)
+{
+	m_desc = desc;
+	m_gpuAddress = gpuAddress;
+	// Only upload buffers are read back by the CPU
+	if (desc.HeapType == RhiHeapType::Upload)
+		m_data.resize(desc.Size);
+}
+
+void* RhiNullBuffer::Map()
+{
+	return m_data.empty() ? nullptr : m_data.data();
+}
+
+// PIPELINE
+
+RhiNullPipeline::RhiNullPipeline(const RhiPipelineDesc& desc)
+{
+	m_desc = desc;
+	// The bytecode is not ours, it may be freed once the pipeline is created
+	m_desc.VertexShader = RhiShaderBytecode();
+	m_desc.PixelShader = RhiShaderBytecode();
+	m_desc.CachedBlob = RhiShaderBytecode();
+	// Like a driver, a blob it did not write is ignored
+	uint32_t tag = 0;
+	if (desc.CachedBlob.pData != nullptr && desc.CachedBlob.Size == sizeof(tag))
+		memcpy(&tag, desc.CachedBlob.pData, sizeof(tag));
+	m_isFromCachedBlob = tag == CACHED_BLOB_TAG;
+}
+
+bool RhiNullPipeline::GetCachedBlob(std::vector<uint8_t>& blob) const
+{
+	blob.resize(sizeof(CACHED_BLOB_TAG));
+	memcpy(blob.data(), &CACHED_BLOB_TAG, sizeof(CACHED_BLOB_TAG));
+	return true;
+}
+
+// SWAP CHAIN
+
+void RhiNullSwapChain::Present(bool /*isVSynced*/)
+{
+	m_backBufferIndex = (m_backBufferIndex + 1) % m_desc.BufferCount;
+	m_presentCount++;
+}
+
+// COMMAND LIST
+
+RhiNullCommandList::RhiNullCommandList(RhiNullDevice* pDevice, int frameSlotCount)
+{
+	m_pDevice = pDevice;
+	m_frameSlotCount = frameSlotCount;
+}
+
+bool RhiNullCommandList::Fail(const char* call, const char* message)
+{
+	m_stats.ValidationErrors++;
+	m_pDevice->ReportError(std::string(call) + ": " + message);
+	return false;
+}
+
+bool RhiNullCommandList::CheckRecording(const char* call)
+{
+	if (!m_isRecording)
+		return Fail(call, "the command list is not recording");
+	return true;
+}
+
+void RhiNullCommandList::Begin(int frameSlot)
+{
+	m_stats = RhiStats();
+	if (m_isRecording)
+		Fail("Begin", "the command list is already recording");
+	if (frameSlot < 0 || frameSlot >= m_frameSlotCount)
+		Fail("Begin", "frame slot out of range");
+
+	// Nothing is inherited from the previous recording
+	m_isRecording = true;
+	m_wasRecorded = true;
+	m_isInRenderPass = false;
+	m_hasRenderPass = false;
+	m_isFirstPassResumed = false;
+	m_isLastPassSuspended = false;
+	m_hasViewport = false;
+	m_pPipeline = nullptr;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_constantBufferMask = 0;
+}
+
+void RhiNullCommandList::End()
+{
+	if (!CheckRecording("End"))
+		return;
+	if (m_isInRenderPass)
+		Fail("End", "the render pass was not ended");
+	m_isRecording = false;
+}
+
+void RhiNullCommandList::BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed)
+{
+	if (!CheckRecording("BeginRenderPass"))
+		return;
+	if (m_isInRenderPass)
+		Fail("BeginRenderPass", "a render pass is already open");
+	if (pSwapChain == nullptr)
+		Fail("BeginRenderPass", "no swap chain");
+	if (!isResumed && clearColor == nullptr)
+		Fail("BeginRenderPass", "no clear color");
+	// Only the previous list can suspend the pass it resumes
+	if (isResumed && m_hasRenderPass)
+		Fail("BeginRenderPass", "only the first pass of a list can be resumed");
+	if (m_isLastPassSuspended)
+		Fail("BeginRenderPass", "a suspended pass must be the last one of the list");
+
+	m_isFirstPassResumed = m_hasRenderPass ? m_isFirstPassResumed : isResumed;
+	m_hasRenderPass = true;
+	m_isInRenderPass = true;
+	m_stats.RenderPasses++;
+}
+
+void RhiNullCommandList::EndRenderPass(bool isSuspended)
+{
+	if (!CheckRecording("EndRenderPass"))
+		return;
+	if (!m_isInRenderPass)
+		Fail("EndRenderPass", "no render pass is open");
+	m_isInRenderPass = false;
+	m_isLastPassSuspended = isSuspended;
+}
+
+void RhiNullCommandList::SetViewport(const RhiViewport& viewport)
+{
+	if (!CheckRecording("SetViewport"))
+		return;
+	if (viewport.Width <= 0.0f || viewport.Height <= 0.0f)
+		Fail("SetViewport", "empty viewport");
+	m_hasViewport = true;
+}
+
+void RhiNullCommandList::SetPipeline(RhiPipeline* pPipeline)
+{
+	if (!CheckRecording("SetPipeline"))
+		return;
+	if (pPipeline == nullptr)
+	{
+		Fail("SetPipeline", "no pipeline");
+		return;
+	}
+	if (pPipeline != m_pPipeline)
+		m_stats.PipelineChanges++;
+	m_pPipeline = pPipeline;
+}
+
+void RhiNullCommandList::SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride)
+{
+	if (!CheckRecording("SetVertexBuffer"))
+		return;
+	if (pBuffer == nullptr || stride == 0 || offset > pBuffer->GetDesc().Size)
+	{
+		Fail("SetVertexBuffer", "no buffer, no stride or offset past the end of the buffer");
+		m_vertexCount = 0;
+		return;
+	}
+	m_vertexCount = (pBuffer->GetDesc().Size - offset) / stride;
+	m_stats.BufferBindings++;
+}
+
+void RhiNullCommandList::SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset)
+{
+	if (!CheckRecording("SetIndexBuffer"))
+		return;
+	if (pBuffer == nullptr || offset % 4 != 0 || offset > pBuffer->GetDesc().Size)
+	{
+		Fail("SetIndexBuffer", "no buffer, unaligned offset or offset past the end of the buffer");
+		m_indexCount = 0;
+		return;
+	}
+	m_indexCount = (pBuffer->GetDesc().Size - offset) / 4;
+	m_stats.BufferBindings++;
+}
+
+void RhiNullCommandList::SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset)
+{
+	if (!CheckRecording("SetConstantBuffer"))
+		return;
+	if (slot < 0 || slot >= RhiNullDevice::MAX_CONSTANT_BUFFERS)
+	{
+		Fail("SetConstantBuffer", "slot out of range");
+		return;
+	}
+	if (pBuffer == nullptr || offset % RhiNullDevice::CONSTANT_BUFFER_ALIGNMENT != 0 || offset >= pBuffer->GetDesc().Size)
+	{
+		Fail("SetConstantBuffer", "no buffer, offset not aligned on 256 bytes or past the end of the buffer");
+		return;
+	}
+	m_constantBufferMask |= 1u << slot;
+	m_stats.BufferBindings++;
+}
+
+void RhiNullCommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	if (!CheckRecording("DrawIndexed"))
+		return;
+	if (!m_isInRenderPass)
+		Fail("DrawIndexed", "outside of a render pass");
+	if (!m_hasViewport)
+		Fail("DrawIndexed", "no viewport set");
+	if (m_pPipeline == nullptr)
+	{
+		Fail("DrawIndexed", "no pipeline set");
+	}
+	else
+	{
+		uint32_t requiredMask = (1u << m_pPipeline->GetDesc().ConstantBufferCount) - 1;
+		if ((m_constantBufferMask & requiredMask) != requiredMask)
+			Fail("DrawIndexed", "a constant buffer of the pipeline is not bound");
+	}
+	if (m_vertexCount == 0)
+		Fail("DrawIndexed", "no vertex buffer bound");
+	if ((uint64_t)firstIndex + indexCount > m_indexCount)
+		Fail("DrawIndexed", "index range past the end of the index buffer");
+	if (baseVertex < 0 || (uint64_t)baseVertex >= m_vertexCount)
+		Fail("DrawIndexed", "base vertex out of the vertex buffer");
+	if (indexCount % 3 != 0 || instanceCount == 0)
+		Fail("DrawIndexed", "not a whole number of triangles or no instance");
+
+	m_stats.DrawCalls++;
+	m_stats.Instances += instanceCount;
+	m_stats.Triangles += (uint64_t)(indexCount / 3) * instanceCount;
+}
+
+// QUEUE
+
+void RhiNullQueue::Submit(RhiCommandList* const* ppCommandLists, int count)
+{
+	// Suspended passes must be resumed by the next list of the same submission
+	bool isPassSuspended = false;
+	for (int i = 0; i < count; i++)
+	{
+		RhiNullCommandList* pNullList = (RhiNullCommandList*)ppCommandLists[i];
+		if (pNullList == nullptr || pNullList->IsRecording() || !pNullList->WasRecorded())
+		{
+			m_pDevice->Fail("Submit: the command list was not recorded since its last submission, or not ended");
+			return;
+		}
+		if (pNullList->IsFirstPassResumed() != isPassSuspended)
+		{
+			m_pDevice->Fail(isPassSuspended ? "Submit: a suspended render pass is not resumed by the next list"
+				: "Submit: a resumed render pass does not follow a suspended one");
+		}
+		isPassSuspended = pNullList->IsLastPassSuspended();
+		// Like a D3D12 allocator, the commands are consumed: resubmitting needs a new Begin
+		pNullList->m_wasRecorded = false;
+
+		std::lock_guard<std::mutex> lock(m_pDevice->m_statsMutex);
+		m_pDevice->m_stats.Add(pNullList->GetStats());
+		m_pDevice->m_stats.CommandLists++;
+	}
+	if (isPassSuspended)
+		m_pDevice->Fail("Submit: the last list suspends its render pass");
+}
+
+// DEVICE
+
+RhiNullDevice::RhiNullDevice() : m_queue(this), m_nextGpuAddress(1 << 16)
+{
+}
+
+RhiBuffer* RhiNullDevice::CreateBuffer(const RhiBufferDesc& desc)
+{
+	if (desc.Size == 0)
+	{
+		Fail("CreateBuffer: empty buffer");
+		return nullptr;
+	}
+	// Keeps the addresses of different buffers apart, and aligned like D3D12 resources
+	uint64_t gpuAddress = m_nextGpuAddress.fetch_add((desc.Size + 0xFFFF) & ~(uint64_t)0xFFFF, std::memory_order_relaxed);
+	return new RhiNullBuffer(desc, gpuAddress);
+}
+
+RhiPipeline* RhiNullDevice::CreatePipeline(const RhiPipelineDesc& desc)
+{
+	if (desc.ConstantBufferCount < 0 || desc.ConstantBufferCount > MAX_CONSTANT_BUFFERS)
+	{
+		Fail("CreatePipeline: constant buffer count out of range");
+		return nullptr;
+	}
+	// No bytecode to check, the null backend never compiles shaders
+	return new RhiNullPipeline(desc);
+}
+
+RhiCommandList* RhiNullDevice::CreateCommandList(int frameSlotCount)
+{
+	return new RhiNullCommandList(this, frameSlotCount);
+}
+
+RhiSwapChain* RhiNullDevice::CreateSwapChain(const RhiSwapChainDesc& desc)
+{
+	if (desc.Width == 0 || desc.Height == 0 || desc.BufferCount < 1)
+	{
+		Fail("CreateSwapChain: empty swap chain");
+		return nullptr;
+	}
+	return new RhiNullSwapChain(desc);
+}
+
+void RhiNullDevice::Fail(const std::string& message)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		m_stats.ValidationErrors++;
+	}
+	ReportError(message);
+}
+
+void RhiNullDevice::ReportError(const std::string& message)
+{
+	std::lock_guard<std::mutex> lock(m_errorMutex);
+	m_lastError = message;
+}
+
+std::string RhiNullDevice::GetLastError()
+{
+	std::lock_guard<std::mutex> lock(m_errorMutex);
+	return m_lastError;
+}
@@ -0,0 +1,630 @@
+#include "pch.h"
+#include "RhiSoftware.h"
+#include "JobSystem.h"
+#include "PngWriter.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RHI_SOFTWARE_SSE2
+#endif
+
+// 4 floats processed together, one per pixel of a 4x1 block. SSE2 when available.
+// Comparisons return a 4 bit mask, bit i for lane i.
+struct Float4
+{
+#ifdef RHI_SOFTWARE_SSE2
+	__m128 V;
+
+	static Float4 Set(float value) { return { _mm_set1_ps(value) }; }
+	static Float4 Ramp() { return { _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f) }; }
+	static Float4 Load(const float* pValues) { return { _mm_loadu_ps(pValues) }; }
+	void Store(float* pValues) const { _mm_storeu_ps(pValues, V); }
+
+	Float4 operator+(const Float4& other) const { return { _mm_add_ps(V, other.V) }; }
+	Float4 operator-(const Float4& other) const { return { _mm_sub_ps(V, other.V) }; }
+	Float4 operator*(const Float4& other) const { return { _mm_mul_ps(V, other.V) }; }
+	Float4 operator/(const Float4& other) const { return { _mm_div_ps(V, other.V) }; }
+
+	int GreaterEqual(const Float4& other) const { return _mm_movemask_ps(_mm_cmpge_ps(V, other.V)); }
+	int Greater(const Float4& other) const { return _mm_movemask_ps(_mm_cmpgt_ps(V, other.V)); }
+	int Less(const Float4& other) const { return _mm_movemask_ps(_mm_cmplt_ps(V, other.V)); }
+#else
+	float V[4];
+
+	static Float4 Set(float value) { return { { value, value, value, value } }; }
+	static Float4 Ramp() { return { { 0.0f, 1.0f, 2.0f, 3.0f } }; }
+	static Float4 Load(const float* pValues) { return { { pValues[0], pValues[1], pValues[2], pValues[3] } }; }
+	void Store(float* pValues) const { for (int i = 0; i < 4; i++) pValues[i] = V[i]; }
+
+	Float4 operator+(const Float4& other) const { return { { V[0] + other.V[0], V[1] + other.V[1], V[2] + other.V[2], V[3] + other.V[3] } }; }
+	Float4 operator-(const Float4& other) const { return { { V[0] - other.V[0], V[1] - other.V[1], V[2] - other.V[2], V[3] - other.V[3] } }; }
+	Float4 operator*(const Float4& other) const { return { { V[0] * other.V[0], V[1] * other.V[1], V[2] * other.V[2], V[3] * other.V[3] } }; }
+	Float4 operator/(const Float4& other) const { return { { V[0] / other.V[0], V[1] / other.V[1], V[2] / other.V[2], V[3] / other.V[3] } }; }
+
+	int GreaterEqual(const Float4& other) const { int mask = 0; for (int i = 0; i < 4; i++) mask |= (V[i] >= other.V[i]) << i; return mask; }
+	int Greater(const Float4& other) const { int mask = 0; for (int i = 0; i < 4; i++) mask |= (V[i] > other.V[i]) << i; return mask; }
+	int Less(const Float4& other) const { int mask = 0; for (int i = 0; i < 4; i++) mask |= (V[i] < other.V[i]) << i; return mask; }
+#endif
+};
+
+static const float DEPTH_SCALE = 16777215.0f; // 2^24 - 1
+static const uint32_t DEPTH_MASK = 0x00FFFFFF;
+
+static uint32_t PackColor(const float color[4])
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		float value = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+		packed |= (uint32_t)(value * 255.0f + 0.5f) << (i * 8);
+	}
+	return packed;
+}
+
+// BUFFER
+
+RhiSoftwareBuffer::RhiSoftwareBuffer(const RhiBufferDesc& desc, uint64_t gpuAddress)
+{
+	m_desc = desc;
+	m_gpuAddress = gpuAddress;
+	m_data.resize(desc.Size);
+}
+
+void* RhiSoftwareBuffer::Map()
+{
+	return m_desc.HeapType == RhiHeapType::Upload ? m_data.data() : nullptr;
+}
+
+// PIPELINE
+
+RhiSoftwarePipeline::RhiSoftwarePipeline(const RhiPipelineDesc& desc)
+{
+	m_desc = desc;
+	m_desc.VertexShader = RhiShaderBytecode();
+	m_desc.PixelShader = RhiShaderBytecode();
+	m_desc.CachedBlob = RhiShaderBytecode();
+}
+
+// SWAP CHAIN
+
+RhiSoftwareSwapChain::RhiSoftwareSwapChain(const RhiSwapChainDesc& desc)
+{
+	m_desc = desc;
+	size_t pixelCount = (size_t)desc.Width * desc.Height;
+	m_buffers.resize(desc.BufferCount);
+	for (int i = 0; i < m_buffers.size(); i++)
+		m_buffers[i].resize(pixelCount, 0);
+	m_depthBuffer.resize(pixelCount, DEPTH_MASK);
+}
+
+void RhiSoftwareSwapChain::Present(bool /*isVSynced*/)
+{
+	m_backBufferIndex = (m_backBufferIndex + 1) % m_desc.BufferCount;
+	m_presentCount++;
+}
+
+const uint32_t* RhiSoftwareSwapChain::GetPresentedBuffer() const
+{
+	if (m_presentCount == 0)
+		return nullptr;
+	int index = (m_backBufferIndex + m_desc.BufferCount - 1) % m_desc.BufferCount;
+	return m_buffers[index].data();
+}
+
+bool RhiSoftwareSwapChain::SavePng(const std::string& path) const
+{
+	return PngWriter::WriteRgba(path, m_desc.Width, m_desc.Height, GetPresentedBuffer());
+}
+
+// COMMAND LIST
+
+void RhiSoftwareCommandList::Begin(int frameSlot)
+{
+	m_stats = RhiStats();
+	m_renderPasses.clear();
+	m_draws.clear();
+	m_state = Draw();
+}
+
+void RhiSoftwareCommandList::BeginRenderPass(RhiSwapChain* pSwapChain, const float clearColor[4], bool isResumed)
+{
+	RenderPass renderPass;
+	renderPass.pSwapChain = (RhiSoftwareSwapChain*)pSwapChain;
+	// Like an RTV, the pass targets the back buffer current at recording time
+	renderPass.BackBufferIndex = pSwapChain->GetBackBufferIndex();
+	renderPass.IsCleared = !isResumed && clearColor != nullptr;
+	for (int i = 0; i < 4; i++)
+		renderPass.ClearColor[i] = renderPass.IsCleared ? clearColor[i] : 0.0f;
+	renderPass.FirstDraw = (int)m_draws.size();
+	m_renderPasses.push_back(renderPass);
+	m_stats.RenderPasses++;
+}
+
+void RhiSoftwareCommandList::SetViewport(const RhiViewport& viewport)
+{
+	m_state.Viewport = viewport;
+}
+
+void RhiSoftwareCommandList::SetPipeline(RhiPipeline* pPipeline)
+{
+	if (pPipeline != m_state.pPipeline)
+		m_stats.PipelineChanges++;
+	m_state.pPipeline = (const RhiSoftwarePipeline*)pPipeline;
+}
+
+void RhiSoftwareCommandList::SetVertexBuffer(RhiBuffer* pBuffer, uint64_t offset, uint32_t stride)
+{
+	m_state.pVertexBuffer = (const RhiSoftwareBuffer*)pBuffer;
+	m_state.VertexOffset = offset;
+	m_state.VertexStride = stride;
+	m_stats.BufferBindings++;
+}
+
+void RhiSoftwareCommandList::SetIndexBuffer(RhiBuffer* pBuffer, uint64_t offset)
+{
+	m_state.pIndexBuffer = (const RhiSoftwareBuffer*)pBuffer;
+	m_state.IndexOffset = offset;
+	m_stats.BufferBindings++;
+}
+
+void RhiSoftwareCommandList::SetConstantBuffer(int slot, RhiBuffer* pBuffer, uint64_t offset)
+{
+	// Color.hlsl only reads b0
+	if (slot == 0)
+	{
+		m_state.pConstantBuffer = (const RhiSoftwareBuffer*)pBuffer;
+		m_state.ConstantOffset = offset;
+	}
+	m_stats.BufferBindings++;
+}
+
+void RhiSoftwareCommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex)
+{
+	m_stats.DrawCalls++;
+	m_stats.Instances += instanceCount;
+	m_stats.Triangles += (uint64_t)(indexCount / 3) * instanceCount;
+
+	// Draws outside of a render pass have no target
+	if (m_renderPasses.empty())
+		return;
+
+	Draw draw = m_state;
+	draw.IndexCount = indexCount;
+	draw.InstanceCount = instanceCount;
+	draw.FirstIndex = firstIndex;
+	draw.BaseVertex = baseVertex;
+	m_draws.push_back(draw);
+	m_renderPasses.back().DrawCount++;
+}
+
+// QUEUE
+
+void RhiSoftwareQueue::Submit(RhiCommandList* const* ppCommandLists, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int64_t start = Timer::GetTicks();
+		m_pDevice->Execute(*(RhiSoftwareCommandList*)ppCommandLists[i]);
+		m_pDevice->m_rasterStats.Ticks += Timer::GetTicks() - start;
+
+		m_pDevice->m_stats.Add(ppCommandLists[i]->GetStats());
+		m_pDevice->m_stats.CommandLists++;
+	}
+}
+
+double SoftwareRasterStats::GetTrianglesPerSecond() const
+{
+	double seconds = Timer::TicksToSeconds(Ticks);
+	return seconds > 0.0 ? (double)TrianglesSubmitted / seconds : 0.0;
+}
+
+// DEVICE
+
+RhiSoftwareDevice::RhiSoftwareDevice(JobSystem* pJobSystem) : m_queue(this), m_nextGpuAddress(1 << 16)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+RhiBuffer* RhiSoftwareDevice::CreateBuffer(const RhiBufferDesc& desc)
+{
+	if (desc.Size == 0)
+		return nullptr;
+
+	uint64_t gpuAddress = m_nextGpuAddress.fetch_add((desc.Size + 0xFFFF) & ~(uint64_t)0xFFFF, std::memory_order_relaxed);
+	return new RhiSoftwareBuffer(desc, gpuAddress);
+}
+
+RhiPipeline* RhiSoftwareDevice::CreatePipeline(const RhiPipelineDesc& desc)
+{
+	return new RhiSoftwarePipeline(desc);
+}
+
+RhiCommandList* RhiSoftwareDevice::CreateCommandList(int frameSlotCount)
+{
+	// Commands are executed on submit, no memory is kept per frame slot
+	return new RhiSoftwareCommandList();
+}
+
+RhiSwapChain* RhiSoftwareDevice::CreateSwapChain(const RhiSwapChainDesc& desc)
+{
+	if (desc.Width == 0 || desc.Height == 0 || desc.BufferCount < 1)
+		return nullptr;
+	return new RhiSoftwareSwapChain(desc);
+}
+
+void RhiSoftwareDevice::Execute(const RhiSoftwareCommandList& commandList)
+{
+	PROFILE_FUNCTION();
+	for (int i = 0; i < commandList.m_renderPasses.size(); i++)
+		ExecuteRenderPass(commandList, commandList.m_renderPasses[i]);
+}
+
+void RhiSoftwareDevice::ExecuteRenderPass(const RhiSoftwareCommandList& commandList, const RhiSoftwareCommandList::RenderPass& renderPass)
+{
+	const RhiSwapChainDesc& target = renderPass.pSwapChain->GetDesc();
+
+	// SETUP
+	// Each source triangle gets 2 slots, near plane clipping splits a triangle in 2 at most
+	uint32_t sourceCount = 0;
+	for (int i = 0; i < renderPass.DrawCount; i++)
+	{
+		const RhiSoftwareCommandList::Draw& draw = commandList.m_draws[renderPass.FirstDraw + i];
+		sourceCount += (draw.IndexCount / 3) * draw.InstanceCount;
+	}
+	m_triangles.resize((size_t)sourceCount * 2);
+	m_triangleCounts.resize(sourceCount);
+	m_rasterStats.TrianglesSubmitted += sourceCount;
+
+	uint32_t drawStart = 0;
+	for (int i = 0; i < renderPass.DrawCount; i++)
+	{
+		const RhiSoftwareCommandList::Draw& draw = commandList.m_draws[renderPass.FirstDraw + i];
+		uint32_t drawCount = (draw.IndexCount / 3) * draw.InstanceCount;
+		if (draw.pVertexBuffer == nullptr || draw.pIndexBuffer == nullptr || draw.pConstantBuffer == nullptr || draw.VertexStride < 28)
+		{
+			// Unbound input, the GPU would draw garbage, draw nothing instead
+			std::fill(m_triangleCounts.begin() + drawStart, m_triangleCounts.begin() + drawStart + drawCount, (uint8_t)0);
+			drawStart += drawCount;
+			continue;
+		}
+
+		auto setupRange = [this, &draw, drawStart](int begin, int end)
+		{
+			for (int t = begin; t < end; t++)
+				m_triangleCounts[drawStart + t] = (uint8_t)SetupTriangle(draw, (uint32_t)t, &m_triangles[((size_t)drawStart + t) * 2]);
+		};
+		if (m_pJobSystem != nullptr)
+			m_pJobSystem->ParallelFor((int)drawCount, 1024, setupRange);
+		else
+			setupRange(0, (int)drawCount);
+		drawStart += drawCount;
+	}
+
+	// BINNING
+	// Serial so each bin keeps the submission order, which the depth test depends on for equal depths
+	m_tileCountX = ((int)target.Width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = ((int)target.Height + TILE_SIZE - 1) / TILE_SIZE;
+	int tileCount = m_tileCountX * m_tileCountY;
+	if (m_tileBins.size() < tileCount)
+		m_tileBins.resize(tileCount);
+	m_tilePixels.assign(tileCount, 0);
+	for (int i = 0; i < tileCount; i++)
+		m_tileBins[i].clear();
+
+	for (uint32_t t = 0; t < sourceCount; t++)
+	{
+		for (int k = 0; k < m_triangleCounts[t]; k++)
+		{
+			uint32_t triangleIndex = t * 2 + k;
+			const Triangle& triangle = m_triangles[triangleIndex];
+			int tileMinX = triangle.MinX / TILE_SIZE;
+			int tileMaxX = triangle.MaxX / TILE_SIZE;
+			int tileMinY = triangle.MinY / TILE_SIZE;
+			int tileMaxY = triangle.MaxY / TILE_SIZE;
+			for (int tileY = tileMinY; tileY <= tileMaxY; tileY++)
+			{
+				for (int tileX = tileMinX; tileX <= tileMaxX; tileX++)
+					m_tileBins[tileY * m_tileCountX + tileX].push_back(triangleIndex);
+			}
+			m_rasterStats.TrianglesRasterized++;
+		}
+	}
+
+	// RASTERIZATION
+	// Tiles do not share pixels, no synchronization needed
+	auto rasterizeRange = [this, &renderPass](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			RasterizeTile(i, renderPass.pSwapChain, renderPass.BackBufferIndex, renderPass.IsCleared ? renderPass.ClearColor : nullptr);
+	};
+	if (m_pJobSystem != nullptr)
+		m_pJobSystem->ParallelFor(tileCount, 1, rasterizeRange);
+	else
+		rasterizeRange(0, tileCount);
+
+	for (int i = 0; i < tileCount; i++)
+		m_rasterStats.PixelsWritten += m_tilePixels[i];
+}
+
+int RhiSoftwareDevice::SetupTriangle(const RhiSoftwareCommandList::Draw& draw, uint32_t triangleIndex, Triangle* pOut) const
+{
+	uint32_t trianglesPerInstance = draw.IndexCount / 3;
+	uint32_t instance = triangleIndex / trianglesPerInstance;
+	uint32_t localTriangle = triangleIndex % trianglesPerInstance;
+
+	const uint8_t* pIndexData = draw.pIndexBuffer->GetData() + draw.IndexOffset;
+	uint64_t indexCapacity = (draw.pIndexBuffer->GetDesc().Size - draw.IndexOffset) / 4;
+	const uint8_t* pVertexData = draw.pVertexBuffer->GetData() + draw.VertexOffset;
+	uint64_t vertexCapacity = (draw.pVertexBuffer->GetDesc().Size - draw.VertexOffset) / draw.VertexStride;
+	uint64_t instanceOffset = draw.ConstantOffset + (uint64_t)instance * INSTANCE_STRIDE;
+	if (instanceOffset + INSTANCE_STRIDE > draw.pConstantBuffer->GetDesc().Size)
+		return 0;
+	const float* pMatrix = (const float*)(draw.pConstantBuffer->GetData() + instanceOffset);
+	const float* pInstanceColor = pMatrix + 16;
+
+	ClipVertex vertices[3];
+	for (int i = 0; i < 3; i++)
+	{
+		uint64_t indexPosition = (uint64_t)draw.FirstIndex + localTriangle * 3 + i;
+		if (indexPosition >= indexCapacity)
+			return 0;
+		uint32_t index;
+		memcpy(&index, pIndexData + indexPosition * 4, 4);
+		int64_t vertexIndex = (int64_t)index + draw.BaseVertex;
+		if (vertexIndex < 0 || (uint64_t)vertexIndex >= vertexCapacity)
+			return 0;
+
+		// VS: mul(float4(Pos, 1), WorldViewProj), the buffer holds the transposed matrix
+		float input[7];
+		memcpy(input, pVertexData + vertexIndex * draw.VertexStride, sizeof(input));
+		for (int row = 0; row < 4; row++)
+		{
+			const float* pRow = pMatrix + row * 4;
+			vertices[i].Position[row] = pRow[0] * input[0] + pRow[1] * input[1] + pRow[2] * input[2] + pRow[3];
+		}
+		for (int c = 0; c < 4; c++)
+			vertices[i].Color[c] = input[3 + c] * pInstanceColor[c];
+	}
+
+	bool isDepthTested = draw.pPipeline == nullptr || draw.pPipeline->GetDesc().IsDepthTested;
+	return ClipAndProject(vertices, draw.Viewport, isDepthTested, pOut);
+}
+
+int RhiSoftwareDevice::ClipAndProject(const ClipVertex vertices[3], const RhiViewport& viewport, bool isDepthTested, Triangle* pOut) const
+{
+	// Entirely outside of one of the clip planes
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (vertices[0].Position[axis] > vertices[0].Position[3] && vertices[1].Position[axis] > vertices[1].Position[3] && vertices[2].Position[axis] > vertices[2].Position[3])
+			return 0;
+		if (vertices[0].Position[axis] < -vertices[0].Position[3] && vertices[1].Position[axis] < -vertices[1].Position[3] && vertices[2].Position[axis] < -vertices[2].Position[3])
+			return 0;
+	}
+	if (vertices[0].Position[2] > vertices[0].Position[3] && vertices[1].Position[2] > vertices[1].Position[3] && vertices[2].Position[2] > vertices[2].Position[3])
+		return 0;
+
+	// Only the near plane (z >= 0) is clipped, the others are handled by the bounds and the per pixel depth range
+	bool isInside[3];
+	int insideCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		isInside[i] = vertices[i].Position[2] >= 0.0f;
+		insideCount += isInside[i];
+	}
+	if (insideCount == 0)
+		return 0;
+	if (insideCount == 3)
+		return ProjectTriangle(vertices[0], vertices[1], vertices[2], viewport, isDepthTested, pOut[0]) ? 1 : 0;
+
+	// Sutherland-Hodgman against z = 0, keeps the winding
+	ClipVertex polygon[4];
+	int polygonCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const ClipVertex& current = vertices[i];
+		const ClipVertex& next = vertices[(i + 1) % 3];
+		if (isInside[i])
+			polygon[polygonCount++] = current;
+		if (isInside[i] != isInside[(i + 1) % 3])
+		{
+			float t = current.Position[2] / (current.Position[2] - next.Position[2]);
+			ClipVertex& clipped = polygon[polygonCount++];
+			for (int c = 0; c < 4; c++)
+			{
+				clipped.Position[c] = current.Position[c] + (next.Position[c] - current.Position[c]) * t;
+				clipped.Color[c] = current.Color[c] + (next.Color[c] - current.Color[c]) * t;
+			}
+		}
+	}
+
+	int count = 0;
+	for (int i = 1; i + 1 < polygonCount; i++)
+	{
+		if (ProjectTriangle(polygon[0], polygon[i], polygon[i + 1], viewport, isDepthTested, pOut[count]))
+			count++;
+	}
+	return count;
+}
+
+bool RhiSoftwareDevice::ProjectTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const RhiViewport& viewport, bool isDepthTested, Triangle& triangle) const
+{
+	const ClipVertex* pVertices[3] = { &v0, &v1, &v2 };
+	float x[3];
+	float y[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const float* pPosition = pVertices[i]->Position;
+		if (pPosition[3] <= 1e-6f)
+			return false;
+
+		float invW = 1.0f / pPosition[3];
+		x[i] = viewport.X + (pPosition[0] * invW * 0.5f + 0.5f) * viewport.Width;
+		y[i] = viewport.Y + (0.5f - pPosition[1] * invW * 0.5f) * viewport.Height;
+		triangle.Z[i] = viewport.MinDepth + pPosition[2] * invW * (viewport.MaxDepth - viewport.MinDepth);
+		triangle.InvW[i] = invW;
+		for (int c = 0; c < 4; c++)
+			triangle.ColorOverW[i][c] = pVertices[i]->Color[c] * invW;
+	}
+
+	// Clockwise triangles are front facing (y goes down), the others are culled like the D3D12 default
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area <= 0.0f)
+		return false;
+	triangle.InvArea = 1.0f / area;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int a = (i + 1) % 3;
+		int b = (i + 2) % 3;
+		triangle.EdgeA[i] = y[a] - y[b];
+		triangle.EdgeB[i] = x[b] - x[a];
+		triangle.EdgeC[i] = -(triangle.EdgeA[i] * x[a] + triangle.EdgeB[i] * y[a]);
+		bool isTop = y[b] == y[a] && x[b] > x[a];
+		bool isLeft = y[b] < y[a];
+		triangle.IsTopLeft[i] = isTop || isLeft;
+	}
+
+	// Pixel centers inside the bounds, clamped to the viewport
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+	float viewportMaxX = viewport.X + viewport.Width - 1.0f;
+	float viewportMaxY = viewport.Y + viewport.Height - 1.0f;
+	triangle.MinX = (int)std::max(std::floor(minX), viewport.X);
+	triangle.MinY = (int)std::max(std::floor(minY), viewport.Y);
+	triangle.MaxX = (int)std::min(std::ceil(maxX), viewportMaxX);
+	triangle.MaxY = (int)std::min(std::ceil(maxY), viewportMaxY);
+	triangle.IsDepthTested = isDepthTested;
+	return triangle.MinX <= triangle.MaxX && triangle.MinY <= triangle.MaxY;
+}
+
+void RhiSoftwareDevice::RasterizeTile(int tileIndex, RhiSoftwareSwapChain* pSwapChain, int backBufferIndex, const float clearColor[4])
+{
+	const int width = (int)pSwapChain->GetDesc().Width;
+	const int height = (int)pSwapChain->GetDesc().Height;
+	const int tileMinX = (tileIndex % m_tileCountX) * TILE_SIZE;
+	const int tileMinY = (tileIndex / m_tileCountX) * TILE_SIZE;
+	const int tileMaxX = std::min(tileMinX + TILE_SIZE, width) - 1;
+	const int tileMaxY = std::min(tileMinY + TILE_SIZE, height) - 1;
+
+	uint32_t* pColor = pSwapChain->GetBuffer(backBufferIndex);
+	uint32_t* pDepth = pSwapChain->GetDepthBuffer();
+
+	// CLEAR
+	if (clearColor != nullptr)
+	{
+		uint32_t clearValue = PackColor(clearColor);
+		for (int y = tileMinY; y <= tileMaxY; y++)
+		{
+			std::fill(pColor + (size_t)y * width + tileMinX, pColor + (size_t)y * width + tileMaxX + 1, clearValue);
+			std::fill(pDepth + (size_t)y * width + tileMinX, pDepth + (size_t)y * width + tileMaxX + 1, DEPTH_MASK);
+		}
+	}
+
+	const Float4 ramp = Float4::Ramp();
+	const Float4 zero = Float4::Set(0.0f);
+	const Float4 one = Float4::Set(1.0f);
+	const Float4 depthScale = Float4::Set(DEPTH_SCALE);
+	uint64_t pixelsWritten = 0;
+
+	const std::vector<uint32_t>& bin = m_tileBins[tileIndex];
+	for (int i = 0; i < bin.size(); i++)
+	{
+		const Triangle& triangle = m_triangles[bin[i]];
+		// Blocks start 4 aligned, lanes left of firstX are masked
+		int firstX = std::max(triangle.MinX, tileMinX);
+		int minX = firstX & ~3;
+		int maxX = std::min(triangle.MaxX, tileMaxX);
+		int minY = std::max(triangle.MinY, tileMinY);
+		int maxY = std::min(triangle.MaxY, tileMaxY);
+		if (minX > maxX || minY > maxY)
+			continue;
+
+		Float4 edgeA[3];
+		Float4 edgeStep[3];
+		for (int e = 0; e < 3; e++)
+		{
+			edgeA[e] = Float4::Set(triangle.EdgeA[e]);
+			edgeStep[e] = Float4::Set(triangle.EdgeA[e] * 4.0f);
+		}
+		const Float4 invArea = Float4::Set(triangle.InvArea);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			// Edge values at the centers of the first 4 pixels of the row
+			float centerY = (float)y + 0.5f;
+			Float4 centerX = Float4::Set((float)minX + 0.5f) + ramp;
+			Float4 edges[3];
+			for (int e = 0; e < 3; e++)
+				edges[e] = edgeA[e] * centerX + Float4::Set(triangle.EdgeB[e] * centerY + triangle.EdgeC[e]);
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				int mask = x + 3 <= maxX ? 0xF : (1 << (maxX - x + 1)) - 1;
+				if (x < firstX)
+					mask &= ~((1 << (firstX - x)) - 1);
+				for (int e = 0; e < 3; e++)
+					mask &= triangle.IsTopLeft[e] ? edges[e].GreaterEqual(zero) : edges[e].Greater(zero);
+
+				if (mask != 0)
+				{
+					Float4 b0 = edges[0] * invArea;
+					Float4 b1 = edges[1] * invArea;
+					Float4 b2 = one - b0 - b1;
+
+					// Depth is affine in screen space
+					Float4 z = b0 * Float4::Set(triangle.Z[0]) + b1 * Float4::Set(triangle.Z[1]) + b2 * Float4::Set(triangle.Z[2]);
+					mask &= z.GreaterEqual(zero) & ~z.Greater(one);
+
+					uint32_t* pDepthRow = pDepth + (size_t)y * width + x;
+					Float4 newDepth = z * depthScale;
+					if (triangle.IsDepthTested && mask != 0)
+					{
+						float stored[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+						for (int lane = 0; lane < 4; lane++)
+						{
+							if (mask & (1 << lane))
+								stored[lane] = (float)(pDepthRow[lane] & DEPTH_MASK);
+						}
+						mask &= newDepth.Less(Float4::Load(stored));
+					}
+
+					if (mask != 0)
+					{
+						// PS: perspective corrected color
+						Float4 invW = b0 * Float4::Set(triangle.InvW[0]) + b1 * Float4::Set(triangle.InvW[1]) + b2 * Float4::Set(triangle.InvW[2]);
+						Float4 w = one / invW;
+						float channels[4][4];
+						for (int c = 0; c < 4; c++)
+						{
+							Float4 channel = b0 * Float4::Set(triangle.ColorOverW[0][c]) + b1 * Float4::Set(triangle.ColorOverW[1][c]) + b2 * Float4::Set(triangle.ColorOverW[2][c]);
+							(channel * w).Store(channels[c]);
+						}
+						float depths[4];
+						newDepth.Store(depths);
+
+						uint32_t* pColorRow = pColor + (size_t)y * width + x;
+						for (int lane = 0; lane < 4; lane++)
+						{
+							if ((mask & (1 << lane)) == 0)
+								continue;
+							float color[4] = { channels[0][lane], channels[1][lane], channels[2][lane], channels[3][lane] };
+							pColorRow[lane] = PackColor(color);
+							if (triangle.IsDepthTested)
+								pDepthRow[lane] = (pDepthRow[lane] & ~DEPTH_MASK) | (uint32_t)(depths[lane] + 0.5f);
+							pixelsWritten++;
+						}
+					}
+				}
+
+				for (int e = 0; e < 3; e++)
+					edges[e] = edges[e] + edgeStep[e];
+			}
+		}
+	}
+	m_tilePixels[tileIndex] = pixelsWritten;
+}
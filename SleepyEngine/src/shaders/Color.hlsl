@@ -1,6 +1,15 @@
-cbuffer cbPerObject : register(b0)
+// Must match InstanceData (Mesh.h) and RenderQueue::MAX_INSTANCES_PER_DRAW
+#define MAX_INSTANCES 512
+
+struct InstanceData
+{
+    float4x4 WorldViewProj;
+    float4 Color;
+};
+
+cbuffer cbPerInstance : register(b0)
 {
-    float4x4 gWorldViewProj;
+    InstanceData gInstances[MAX_INSTANCES];
 };
 
 struct VertexIn
@@ -15,13 +24,13 @@ struct VertexOut
     float4 Color : COLOR;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceId : SV_InstanceID)
 {
     VertexOut vout;
 // Transform to homogeneous clip space.
-    vout.PosH = mul(float4(vin.Pos, 1.0f), gWorldViewProj);
-// Just pass vertex color into the pixel shader.
-    vout.Color = vin.Color;
+    vout.PosH = mul(float4(vin.Pos, 1.0f), gInstances[instanceId].WorldViewProj);
+// Tint the vertex color by the instance color.
+    vout.Color = vin.Color * gInstances[instanceId].Color;
     return vout;
 }
 
@@ -0,0 +1,47 @@
+#include "pch.h"
+#include "D3DShaderCompiler.h"
+#include "D3DUtils.h"
+
+bool D3DShaderCompiler::Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors)
+{
+	// nullptr terminated
+	std::vector<D3D_SHADER_MACRO> defines;
+	for (int i = 0; i < desc.Defines.size(); i++)
+		defines.push_back({ desc.Defines[i].Name.c_str(), desc.Defines[i].Value.c_str() });
+	defines.push_back({ nullptr, nullptr });
+
+	ID3DBlob* pByteCode = nullptr;
+	ID3DBlob* pErrors = nullptr;
+	HRESULT hr = D3DCompileFromFile(D3DUtils::AnsiToWString(desc.Path).c_str(), defines.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		desc.EntryPoint.c_str(), desc.Target.c_str(), GetCompileFlags(), 0, &pByteCode, &pErrors);
+
+	errors.clear();
+	if (pErrors != nullptr)
+		errors.assign((const char*)pErrors->GetBufferPointer(), pErrors->GetBufferSize());
+	else if (FAILED(hr))
+		errors = desc.Path + ": " + D3DUtils::HrToString(hr);
+
+	bytecode.clear();
+	if (SUCCEEDED(hr) && pByteCode != nullptr)
+	{
+		const uint8_t* pData = (const uint8_t*)pByteCode->GetBufferPointer();
+		bytecode.assign(pData, pData + pByteCode->GetBufferSize());
+	}
+	RELEASE(pByteCode);
+	RELEASE(pErrors);
+	return !bytecode.empty();
+}
+
+std::string D3DShaderCompiler::GetVersion() const
+{
+	return "d3dcompiler " + std::to_string(D3D_COMPILER_VERSION) + " flags " + std::to_string(GetCompileFlags());
+}
+
+unsigned int D3DShaderCompiler::GetCompileFlags()
+{
+	UINT compileFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+	return compileFlags;
+}
@@ -0,0 +1,161 @@
+#include "pch.h"
+#include "ShaderCache.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+
+ShaderCache::ShaderCache()
+{
+}
+
+bool ShaderCache::Init(ShaderCompiler* pCompiler, const std::string& cacheDirectory, JobSystem* pJobSystem)
+{
+	m_pCompiler = pCompiler;
+	m_pJobSystem = pJobSystem;
+	m_stats = ShaderCacheStats();
+	// Still compiles without a cache directory
+	bool isCacheCreated = m_blobCache.Init(cacheDirectory, ".cso");
+	return pCompiler != nullptr && isCacheCreated;
+}
+
+bool ShaderCache::Build(const ShaderDesc* pDescs, CompiledShader* pShaders, int count)
+{
+	PROFILE_FUNCTION();
+	// Shader holding the bytecode of each shader, itself unless an earlier one has the same key
+	std::vector<int> sources(count);
+	std::vector<int> misses;
+	for (int i = 0; i < count; i++)
+	{
+		CompiledShader& shader = pShaders[i];
+		shader = CompiledShader();
+		shader.Key = ComputeKey(pDescs[i]);
+		sources[i] = i;
+		if (shader.Key == 0)
+		{
+			shader.Errors = "Can't read " + pDescs[i].Path;
+			continue;
+		}
+
+		for (int j = 0; j < i; j++)
+		{
+			if (pShaders[j].Key == shader.Key)
+			{
+				sources[i] = j;
+				break;
+			}
+		}
+		if (sources[i] != i)
+			continue;
+
+		if (m_blobCache.Load(shader.Key, shader.Bytecode))
+			shader.IsFromCache = true;
+		else
+			misses.push_back(i);
+	}
+
+	// Each miss only writes its own shader and its own cache file
+	auto compile = [this, pDescs, pShaders, &misses](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			CompiledShader& shader = pShaders[misses[i]];
+			if (!m_pCompiler->Compile(pDescs[misses[i]], shader.Bytecode, shader.Errors))
+				shader.Bytecode.clear();
+			else
+				m_blobCache.Store(shader.Key, shader.Bytecode.data(), shader.Bytecode.size());
+		}
+	};
+	if (m_pJobSystem != nullptr)
+		m_pJobSystem->ParallelFor((int)misses.size(), 1, compile);
+	else
+		compile(0, (int)misses.size());
+
+	bool isValid = true;
+	for (int i = 0; i < count; i++)
+	{
+		CompiledShader& shader = pShaders[i];
+		if (sources[i] != i)
+		{
+			shader.Bytecode = pShaders[sources[i]].Bytecode;
+			shader.Errors = pShaders[sources[i]].Errors;
+			shader.IsFromCache = pShaders[sources[i]].IsFromCache;
+		}
+		else if (shader.IsFromCache)
+			m_stats.Hits++;
+		else if (shader.IsValid())
+			m_stats.Compiled++;
+		else
+			m_stats.Failed++;
+		isValid = isValid && shader.IsValid();
+	}
+	return isValid;
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderDesc& desc) const
+{
+	uint64_t hash = Hash::String(m_pCompiler->GetVersion());
+	std::vector<std::string> visited(1, desc.Path);
+	if (!HashFile(desc.Path, 0, visited, hash))
+		return 0;
+
+	hash = Hash::String(desc.EntryPoint, hash);
+	hash = Hash::String(desc.Target, hash);
+	hash = Hash::Integer(desc.Defines.size(), hash);
+	for (int i = 0; i < desc.Defines.size(); i++)
+	{
+		hash = Hash::String(desc.Defines[i].Name, hash);
+		hash = Hash::String(desc.Defines[i].Value, hash);
+	}
+	// 0 means unreadable
+	return hash != 0 ? hash : 1;
+}
+
+bool ShaderCache::HashFile(const std::string& path, int depth, std::vector<std::string>& visited, uint64_t& hash) const
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	hash = Hash::String(source, hash);
+	if (depth >= MAX_INCLUDE_DEPTH)
+		return true;
+
+	// Includes are relative to the including file, like D3D_COMPILE_STANDARD_FILE_INCLUDE does.
+	// Commented out includes are followed too, they only make the key depend on more files.
+	std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+	size_t lineStart = 0;
+	while (lineStart < source.size())
+	{
+		size_t lineEnd = source.find('\n', lineStart);
+		lineEnd = lineEnd != std::string::npos ? lineEnd : source.size();
+
+		size_t i = source.find_first_not_of(" \t", lineStart);
+		if (i < lineEnd && source[i] == '#')
+			i = source.find_first_not_of(" \t", i + 1);
+		else
+			i = std::string::npos;
+
+		if (i < lineEnd && source.compare(i, 7, "include") == 0)
+		{
+			size_t open = source.find_first_of("\"<", i + 7);
+			size_t close = open < lineEnd ? source.find_first_of("\">", open + 1) : std::string::npos;
+			if (close < lineEnd)
+			{
+				std::string name = source.substr(open + 1, close - open - 1);
+				std::string includePath = directory + name;
+				hash = Hash::String(name, hash);
+				if (std::find(visited.begin(), visited.end(), includePath) == visited.end())
+				{
+					visited.push_back(includePath);
+					// Missing: the compiler reports it, and the key changes once the file exists
+					if (!HashFile(includePath, depth + 1, visited, hash))
+						hash = Hash::Integer(0, hash);
+				}
+			}
+		}
+		lineStart = lineEnd + 1;
+	}
+	return true;
+}
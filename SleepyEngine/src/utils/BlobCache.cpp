@@ -0,0 +1,117 @@
+#include "BlobCache.h"
+#include "Hash.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+// Layout: "SLBC", version (u32), key, content size and content hash (u64), then the content.
+// Integers are little endian.
+static const char BLOB_MAGIC[4] = { 'S', 'L', 'B', 'C' };
+static const uint32_t BLOB_VERSION = 1;
+static const size_t BLOB_HEADER_SIZE = 32;
+
+static void AppendInteger(std::vector<uint8_t>& bytes, uint64_t value, int size)
+{
+	for (int i = 0; i < size; i++)
+		bytes.push_back((uint8_t)(value >> (i * 8)));
+}
+
+static uint64_t ReadInteger(const uint8_t* pBytes, int size)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < size; i++)
+		value |= (uint64_t)pBytes[i] << (i * 8);
+	return value;
+}
+
+BlobCache::BlobCache()
+{
+}
+
+bool BlobCache::Init(const std::string& directory, const std::string& extension)
+{
+	m_directory = directory;
+	m_extension = extension;
+	if (directory.empty())
+		return true;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error)
+	{
+		m_directory.clear();
+		return false;
+	}
+	return true;
+}
+
+std::string BlobCache::GetPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+	return m_directory + "/" + name + m_extension;
+}
+
+bool BlobCache::Load(uint64_t key, std::vector<uint8_t>& blob) const
+{
+	if (m_directory.empty())
+		return false;
+
+	std::ifstream file(GetPath(key), std::ios::binary);
+	if (!file.is_open())
+		return false;
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() <= BLOB_HEADER_SIZE)
+		return false;
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (data[i] != (uint8_t)BLOB_MAGIC[i])
+			return false;
+	}
+	const uint8_t* pContent = data.data() + BLOB_HEADER_SIZE;
+	uint64_t size = data.size() - BLOB_HEADER_SIZE;
+	if (ReadInteger(&data[4], 4) != BLOB_VERSION || ReadInteger(&data[8], 8) != key || ReadInteger(&data[16], 8) != size)
+		return false;
+	if (ReadInteger(&data[24], 8) != Hash::Bytes(pContent, size))
+		return false;
+
+	blob.assign(pContent, pContent + size);
+	return true;
+}
+
+bool BlobCache::Store(uint64_t key, const void* pData, size_t size) const
+{
+	if (m_directory.empty())
+		return false;
+
+	std::vector<uint8_t> data;
+	data.reserve(BLOB_HEADER_SIZE + size);
+	data.insert(data.end(), BLOB_MAGIC, BLOB_MAGIC + 4);
+	AppendInteger(data, BLOB_VERSION, 4);
+	AppendInteger(data, key, 8);
+	AppendInteger(data, size, 8);
+	AppendInteger(data, Hash::Bytes(pData, size), 8);
+	data.insert(data.end(), (const uint8_t*)pData, (const uint8_t*)pData + size);
+
+	// Several threads or processes can store the same key, each one writes its own file
+	std::string path = GetPath(key);
+	std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		file.write((const char*)data.data(), data.size());
+		if (!file.good())
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (!error)
+		return true;
+	std::filesystem::remove(tempPath, error);
+	return false;
+}
@@ -1,30 +1,28 @@
 #include "pch.h" 
 #include "D3DUtils.h"
+#include "D3DShaderCompiler.h"
 
 
 
 ID3DBlob* D3DUtils::CompileFromFile(const std::wstring& filename, const D3D_SHADER_MACRO* defines, const std::string& entrypoint, const std::string& target)
 {
-	UINT compileFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG)  
-	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-	HRESULT hr = S_OK;
-
 	ID3DBlob* byteCode = nullptr;
-	ID3DBlob* errors; 
-	hr = D3DCompileFromFile(filename.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		entrypoint.c_str(), target.c_str(), compileFlags, 0, &byteCode, &errors);
+	ID3DBlob* errors = nullptr;
+	HRESULT hr = D3DCompileFromFile(filename.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		entrypoint.c_str(), target.c_str(), D3DShaderCompiler::GetCompileFlags(), 0, &byteCode, &errors);
 
+	// Warnings too
 	if (errors != nullptr)
+	{
 		OutputDebugStringA((char*)errors->GetBufferPointer());
-	
+		std::cout << (char*)errors->GetBufferPointer() << std::endl;
+	}
+	RELEASE(errors);
 
-	// ThrowIfFailed(x)
-	if (hr != S_OK)
+	if (FAILED(hr))
 	{
-		std::cout << "HR MARCHE PAS !!!" << std::endl;
+		std::wcout << L"Failed to compile " << filename << L" (" << entrypoint.c_str() << L", " << target.c_str() << L"): " << HrToString(hr).c_str() << std::endl;
+		RELEASE(byteCode);
 		return nullptr;
 	}
 
@@ -0,0 +1,31 @@
+#include "Hash.h"
+
+static const uint64_t FNV_PRIME = 0x100000001B3ull;
+
+uint64_t Hash::Bytes(const void* pData, size_t size, uint64_t hash)
+{
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+uint64_t Hash::String(const std::string& value, uint64_t hash)
+{
+	hash = Integer(value.size(), hash);
+	return Bytes(value.data(), value.size(), hash);
+}
+
+uint64_t Hash::Integer(uint64_t value, uint64_t hash)
+{
+	// Byte by byte, the same on any endianness
+	for (int i = 0; i < 8; i++)
+	{
+		hash ^= (uint8_t)(value >> (i * 8));
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
@@ -0,0 +1,119 @@
+#include "PngWriter.h"
+#include <array>
+#include <fstream>
+#include <vector>
+
+static void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+{
+	bytes.push_back((uint8_t)(value >> 24));
+	bytes.push_back((uint8_t)(value >> 16));
+	bytes.push_back((uint8_t)(value >> 8));
+	bytes.push_back((uint8_t)value);
+}
+
+static std::array<uint32_t, 256> BuildCrcTable()
+{
+	std::array<uint32_t, 256> table;
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t value = i;
+		for (int bit = 0; bit < 8; bit++)
+			value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+		table[i] = value;
+	}
+	return table;
+}
+
+uint32_t PngWriter::Crc32(uint32_t crc, const uint8_t* pData, size_t size)
+{
+	// Built once, safe to call from several threads
+	static const std::array<uint32_t, 256> s_table = BuildCrcTable();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = s_table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+bool PngWriter::WriteRgba(const std::string& path, uint32_t width, uint32_t height, const uint32_t* pPixels)
+{
+	if (width == 0 || height == 0 || pPixels == nullptr)
+		return false;
+
+	// Scanlines, each one prefixed by its filter type (0: none)
+	size_t rowSize = (size_t)width * 4 + 1;
+	std::vector<uint8_t> raw(rowSize * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* pRow = &raw[y * rowSize];
+		pRow[0] = 0;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			uint32_t pixel = pPixels[(size_t)y * width + x];
+			pRow[1 + x * 4 + 0] = (uint8_t)pixel;
+			pRow[1 + x * 4 + 1] = (uint8_t)(pixel >> 8);
+			pRow[1 + x * 4 + 2] = (uint8_t)(pixel >> 16);
+			pRow[1 + x * 4 + 3] = (uint8_t)(pixel >> 24);
+		}
+	}
+
+	// zlib stream made of stored deflate blocks (65535 bytes max each)
+	std::vector<uint8_t> zlib;
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		size_t blockSize = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+		bool isLast = offset + blockSize == raw.size();
+		zlib.push_back(isLast ? 1 : 0);
+		zlib.push_back((uint8_t)blockSize);
+		zlib.push_back((uint8_t)(blockSize >> 8));
+		zlib.push_back((uint8_t)~blockSize);
+		zlib.push_back((uint8_t)(~blockSize >> 8));
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < raw.size());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		adlerA = (adlerA + raw[i]) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	static const uint8_t s_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write((const char*)s_signature, sizeof(s_signature));
+
+	// Chunks: length, type, data, CRC of type and data
+	auto writeChunk = [&file](const char* type, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		chunk.reserve(data.size() + 12);
+		AppendBigEndian(chunk, (uint32_t)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		AppendBigEndian(chunk, Crc32(0, &chunk[4], data.size() + 4));
+		file.write((const char*)chunk.data(), chunk.size());
+	};
+
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, width);
+	AppendBigEndian(header, height);
+	header.push_back(8); // bits per channel
+	header.push_back(6); // RGBA
+	header.push_back(0); // deflate
+	header.push_back(0); // adaptive filtering
+	header.push_back(0); // not interlaced
+	writeChunk("IHDR", header);
+	writeChunk("IDAT", zlib);
+	writeChunk("IEND", std::vector<uint8_t>());
+	return file.good();
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "MathHelper.h"
+#include <iomanip>
+
+std::atomic<bool> Profiler::s_isEnabled(true);
+std::atomic<uint64_t> Profiler::s_clearCount(0);
+std::mutex Profiler::s_registryMutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::s_threadBuffers;
+uint32_t Profiler::s_nextThreadIndex = 0;
+thread_local Profiler::ThreadBuffer* Profiler::t_pThreadBuffer = nullptr;
+thread_local Profiler::ThreadBufferRelease Profiler::t_threadBufferRelease;
+
+namespace
+{
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				stream << '\\' << *c;
+			else if ((unsigned char)*c < 0x20)
+				stream << ' ';
+			else
+				stream << *c;
+		}
+		stream << '"';
+	}
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (t_pThreadBuffer != nullptr)
+		return t_pThreadBuffer;
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	s_threadBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+	t_pThreadBuffer = s_threadBuffers.back().get();
+	t_pThreadBuffer->ThreadIndex = s_nextThreadIndex++;
+	t_pThreadBuffer->ThreadName = "Thread " + std::to_string(t_pThreadBuffer->ThreadIndex);
+	t_pThreadBuffer->ClearCount.store(s_clearCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	// Constructs the thread_local, so its destructor runs when the thread exits
+	t_threadBufferRelease.IsRegistered = true;
+	return t_pThreadBuffer;
+}
+
+Profiler::ThreadBufferRelease::~ThreadBufferRelease()
+{
+	if (!IsRegistered || t_pThreadBuffer == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	for (int i = 0; i < s_threadBuffers.size(); i++)
+	{
+		if (s_threadBuffers[i].get() != t_pThreadBuffer)
+			continue;
+
+		s_threadBuffers.erase(s_threadBuffers.begin() + i);
+		break;
+	}
+	t_pThreadBuffer = nullptr;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* pBuffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+	pBuffer->ThreadName = name;
+}
+
+int64_t Profiler::BeginZone()
+{
+	GetThreadBuffer()->Depth++;
+	return Timer::GetTicks();
+}
+
+void Profiler::EndZone(const char* name, int64_t start)
+{
+	int64_t end = Timer::GetTicks();
+	ThreadBuffer* pBuffer = GetThreadBuffer();
+	pBuffer->Depth--;
+
+	uint64_t writeIndex = pBuffer->WriteIndex.load(std::memory_order_relaxed);
+	// Clear only asks, the owner is the only thread moving its write index
+	uint64_t clearCount = s_clearCount.load(std::memory_order_acquire);
+	if (pBuffer->ClearCount.load(std::memory_order_relaxed) != clearCount)
+	{
+		writeIndex = 0;
+		pBuffer->WriteIndex.store(0, std::memory_order_relaxed);
+		pBuffer->ClearCount.store(clearCount, std::memory_order_release);
+	}
+
+	ProfileZone& zone = pBuffer->Zones[writeIndex % BUFFER_CAPACITY];
+	zone.Name = name;
+	zone.Start = start;
+	zone.End = end;
+	zone.Depth = pBuffer->Depth;
+	// Publishes the zone to the exporter
+	pBuffer->WriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(s_registryMutex);
+
+	// Timestamps are relative to the earliest zone, in microseconds as the format expects
+	int64_t origin = INT64_MAX;
+	for (int i = 0; i < s_threadBuffers.size(); i++)
+	{
+		ThreadBuffer* pBuffer = s_threadBuffers[i].get();
+		uint64_t writeIndex = GetPublishedCount(pBuffer);
+		uint64_t first = writeIndex > BUFFER_CAPACITY ? writeIndex - BUFFER_CAPACITY : 0;
+		for (uint64_t z = first; z < writeIndex; z++)
+			origin = MathHelper::Min(origin, pBuffer->Zones[z % BUFFER_CAPACITY].Start);
+	}
+	if (origin == INT64_MAX)
+		origin = 0;
+
+	// Fixed notation keeps the nanoseconds, the default precision switches to exponents after a second
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	bool isFirst = true;
+	for (int i = 0; i < s_threadBuffers.size(); i++)
+	{
+		ThreadBuffer* pBuffer = s_threadBuffers[i].get();
+
+		file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << pBuffer->ThreadIndex << ",\"args\":{\"name\":";
+		WriteJsonString(file, pBuffer->ThreadName.c_str());
+		file << "}}";
+		isFirst = false;
+
+		uint64_t writeIndex = GetPublishedCount(pBuffer);
+		uint64_t first = writeIndex > BUFFER_CAPACITY ? writeIndex - BUFFER_CAPACITY : 0;
+		for (uint64_t z = first; z < writeIndex; z++)
+		{
+			const ProfileZone& zone = pBuffer->Zones[z % BUFFER_CAPACITY];
+			file << ",\n{\"name\":";
+			WriteJsonString(file, zone.Name);
+			file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << pBuffer->ThreadIndex
+				<< ",\"ts\":" << (double)(zone.Start - origin) * 0.001
+				<< ",\"dur\":" << (double)(zone.End - zone.Start) * 0.001
+				<< ",\"args\":{\"depth\":" << zone.Depth << "}}";
+		}
+	}
+	file << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	return file.good();
+}
+
+void Profiler::Clear()
+{
+	s_clearCount.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t Profiler::GetPublishedCount(ThreadBuffer* pBuffer)
+{
+	// The zones of a buffer whose owner did not apply the last Clear yet are dropped
+	if (pBuffer->ClearCount.load(std::memory_order_acquire) != s_clearCount.load(std::memory_order_acquire))
+		return 0;
+	return pBuffer->WriteIndex.load(std::memory_order_acquire);
+}
@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "RadixSort.h"
+#include "JobSystem.h"
+
+void RadixSort::Sort(SortKey* pKeys, SortKey* pScratch, int count, JobSystem* pJobSystem)
+{
+	if (count <= 1)
+		return;
+
+	// Each chunk is counted and scattered by one job, in order, which keeps the sort stable
+	int chunkCount = 1;
+	if (pJobSystem != nullptr && count >= MIN_PARALLEL_COUNT)
+		chunkCount = std::min(pJobSystem->GetWorkerCount() * 2, count / (MIN_PARALLEL_COUNT / 4));
+	chunkCount = std::max(chunkCount, 1);
+
+	auto getChunkBegin = [count, chunkCount](int chunk) { return (int)((int64_t)count * chunk / chunkCount); };
+	auto forEachChunk = [pJobSystem, chunkCount](const auto& function)
+	{
+		if (chunkCount > 1)
+			pJobSystem->ParallelFor(chunkCount, 1, [&function](int begin, int end) { for (int chunk = begin; chunk < end; chunk++) function(chunk); });
+		else
+			function(0);
+	};
+
+	// Histograms of the 8 bytes, per chunk, in a single read of the keys
+	std::vector<uint32_t> histograms((size_t)chunkCount * 8 * 256, 0);
+	forEachChunk([&](int chunk)
+	{
+		uint32_t* pHistogram = &histograms[(size_t)chunk * 8 * 256];
+		for (int i = getChunkBegin(chunk); i < getChunkBegin(chunk + 1); i++)
+		{
+			uint64_t key = pKeys[i].Key;
+			for (int byte = 0; byte < 8; byte++)
+				pHistogram[byte * 256 + ((key >> (byte * 8)) & 0xFF)]++;
+		}
+	});
+
+	std::vector<uint32_t> offsets((size_t)chunkCount * 256);
+	SortKey* pSource = pKeys;
+	SortKey* pDestination = pScratch;
+	bool isReordered = false;
+	for (int byte = 0; byte < 8; byte++)
+	{
+		// The totals per byte value do not depend on the order, only the split per chunk does
+		uint32_t totals[256] = {};
+		bool isSkipped = false;
+		for (int value = 0; value < 256 && !isSkipped; value++)
+		{
+			for (int chunk = 0; chunk < chunkCount; chunk++)
+				totals[value] += histograms[((size_t)chunk * 8 + byte) * 256 + value];
+			isSkipped = totals[value] == (uint32_t)count;
+		}
+		if (isSkipped)
+			continue;
+
+		// Once a pass moved the keys between chunks, their counts for this byte are redone
+		if (isReordered)
+		{
+			forEachChunk([&](int chunk)
+			{
+				uint32_t* pHistogram = &histograms[((size_t)chunk * 8 + byte) * 256];
+				std::fill(pHistogram, pHistogram + 256, 0);
+				for (int i = getChunkBegin(chunk); i < getChunkBegin(chunk + 1); i++)
+					pHistogram[(pSource[i].Key >> (byte * 8)) & 0xFF]++;
+			});
+		}
+
+		uint32_t offset = 0;
+		for (int value = 0; value < 256; value++)
+		{
+			for (int chunk = 0; chunk < chunkCount; chunk++)
+			{
+				offsets[(size_t)chunk * 256 + value] = offset;
+				offset += histograms[((size_t)chunk * 8 + byte) * 256 + value];
+			}
+		}
+
+		forEachChunk([&](int chunk)
+		{
+			uint32_t* pOffsets = &offsets[(size_t)chunk * 256];
+			for (int i = getChunkBegin(chunk); i < getChunkBegin(chunk + 1); i++)
+				pDestination[pOffsets[(pSource[i].Key >> (byte * 8)) & 0xFF]++] = pSource[i];
+		});
+		std::swap(pSource, pDestination);
+		isReordered = true;
+	}
+
+	if (pSource != pKeys)
+		std::copy(pSource, pSource + count, pKeys);
+}
@@ -0,0 +1,266 @@
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+
+float TlsfStats::GetFragmentation() const
+{
+	uint64_t freeSize = GetFreeSize();
+	if (freeSize == 0)
+		return 0.0f;
+	return 1.0f - (float)((double)LargestFreeBlock / (double)freeSize);
+}
+
+TlsfAllocator::TlsfAllocator()
+{
+}
+
+bool TlsfAllocator::Init(uint64_t size)
+{
+	size &= ~(GRANULARITY - 1);
+	uint64_t maxSize = (GRANULARITY << (FIRST_LEVEL_COUNT + SECOND_LEVEL_LOG2 - 1)) - GRANULARITY;
+	if (size == 0 || size > maxSize)
+		return false;
+
+	m_blocks.clear();
+	m_firstUnusedBlock = INVALID_ALLOCATION;
+	m_firstLevelBitmap = 0;
+	for (int i = 0; i < FIRST_LEVEL_COUNT; i++)
+	{
+		m_secondLevelBitmaps[i] = 0;
+		for (int j = 0; j < SECOND_LEVEL_COUNT; j++)
+			m_freeLists[i][j] = INVALID_ALLOCATION;
+	}
+	m_totalSize = size;
+	m_usedSize = 0;
+	m_allocationCount = 0;
+	m_freeBlockCount = 0;
+
+	m_firstPhysicalBlock = NewBlock();
+	m_blocks[m_firstPhysicalBlock].Size = size;
+	InsertFreeBlock(m_firstPhysicalBlock);
+	return true;
+}
+
+void TlsfAllocator::GetSizeClass(uint64_t size, int& firstLevel, int& secondLevel)
+{
+	uint64_t granules = size / GRANULARITY;
+	if (granules < SECOND_LEVEL_COUNT)
+	{
+		// Small sizes are linear, one class per granule
+		firstLevel = 0;
+		secondLevel = (int)granules;
+		return;
+	}
+	int log2 = std::bit_width(granules) - 1;
+	firstLevel = log2 - SECOND_LEVEL_LOG2 + 1;
+	secondLevel = (int)(granules >> (log2 - SECOND_LEVEL_LOG2)) - SECOND_LEVEL_COUNT;
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const
+{
+	// Rounded up to the next class, so any block of the class found is big enough
+	uint64_t granules = size / GRANULARITY;
+	if (granules >= SECOND_LEVEL_COUNT)
+		granules += ((uint64_t)1 << (std::bit_width(granules) - 1 - SECOND_LEVEL_LOG2)) - 1;
+	int firstLevel;
+	int secondLevel;
+	GetSizeClass(granules * GRANULARITY, firstLevel, secondLevel);
+	if (firstLevel >= FIRST_LEVEL_COUNT)
+		return INVALID_ALLOCATION;
+
+	uint32_t secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0)
+	{
+		uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_firstLevelBitmap & (~(uint64_t)0 << (firstLevel + 1)) : 0;
+		if (firstLevelMap == 0)
+			return INVALID_ALLOCATION;
+		firstLevel = std::countr_zero(firstLevelMap);
+		secondLevelMap = m_secondLevelBitmaps[firstLevel];
+	}
+	secondLevel = std::countr_zero(secondLevelMap);
+	return m_freeLists[firstLevel][secondLevel];
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t block)
+{
+	Block& freeBlock = m_blocks[block];
+	int firstLevel;
+	int secondLevel;
+	GetSizeClass(freeBlock.Size, firstLevel, secondLevel);
+
+	freeBlock.IsFree = true;
+	freeBlock.PrevFree = INVALID_ALLOCATION;
+	freeBlock.NextFree = m_freeLists[firstLevel][secondLevel];
+	if (freeBlock.NextFree != INVALID_ALLOCATION)
+		m_blocks[freeBlock.NextFree].PrevFree = block;
+	m_freeLists[firstLevel][secondLevel] = block;
+	m_firstLevelBitmap |= (uint64_t)1 << firstLevel;
+	m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	m_freeBlockCount++;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t block)
+{
+	Block& freeBlock = m_blocks[block];
+	if (freeBlock.PrevFree != INVALID_ALLOCATION)
+		m_blocks[freeBlock.PrevFree].NextFree = freeBlock.NextFree;
+	if (freeBlock.NextFree != INVALID_ALLOCATION)
+		m_blocks[freeBlock.NextFree].PrevFree = freeBlock.PrevFree;
+
+	int firstLevel;
+	int secondLevel;
+	GetSizeClass(freeBlock.Size, firstLevel, secondLevel);
+	if (m_freeLists[firstLevel][secondLevel] == block)
+	{
+		m_freeLists[firstLevel][secondLevel] = freeBlock.NextFree;
+		if (freeBlock.NextFree == INVALID_ALLOCATION)
+		{
+			m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (m_secondLevelBitmaps[firstLevel] == 0)
+				m_firstLevelBitmap &= ~((uint64_t)1 << firstLevel);
+		}
+	}
+	freeBlock.IsFree = false;
+	freeBlock.PrevFree = INVALID_ALLOCATION;
+	freeBlock.NextFree = INVALID_ALLOCATION;
+	m_freeBlockCount--;
+}
+
+void TlsfAllocator::Split(uint32_t block, uint64_t size)
+{
+	uint32_t rest = NewBlock();
+	// NewBlock may grow m_blocks, no reference before it
+	Block& first = m_blocks[block];
+	Block& second = m_blocks[rest];
+	second.Offset = first.Offset + size;
+	second.Size = first.Size - size;
+	second.PrevPhysical = block;
+	second.NextPhysical = first.NextPhysical;
+	if (second.NextPhysical != INVALID_ALLOCATION)
+		m_blocks[second.NextPhysical].PrevPhysical = rest;
+	first.Size = size;
+	first.NextPhysical = rest;
+	InsertFreeBlock(rest);
+}
+
+void TlsfAllocator::Merge(uint32_t block, uint32_t next)
+{
+	Block& first = m_blocks[block];
+	Block& second = m_blocks[next];
+	first.Size += second.Size;
+	first.NextPhysical = second.NextPhysical;
+	if (first.NextPhysical != INVALID_ALLOCATION)
+		m_blocks[first.NextPhysical].PrevPhysical = block;
+	ReleaseBlock(next);
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+	uint32_t block = m_firstUnusedBlock;
+	if (block == INVALID_ALLOCATION)
+	{
+		block = (uint32_t)m_blocks.size();
+		m_blocks.push_back(Block());
+	}
+	else
+	{
+		m_firstUnusedBlock = m_blocks[block].NextFree;
+		m_blocks[block] = Block();
+	}
+	return block;
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t block)
+{
+	m_blocks[block] = Block();
+	m_blocks[block].NextFree = m_firstUnusedBlock;
+	m_firstUnusedBlock = block;
+}
+
+uint32_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0 || m_blocks.empty())
+		return INVALID_ALLOCATION;
+
+	size = (size + GRANULARITY - 1) & ~(GRANULARITY - 1);
+	// Bigger alignments are rare (placed textures), the padding is cut off the block found
+	uint64_t padding = alignment > GRANULARITY ? alignment - GRANULARITY : 0;
+	if (size + padding > m_totalSize)
+		return INVALID_ALLOCATION;
+
+	uint32_t block = FindFreeBlock(size + padding);
+	if (block == INVALID_ALLOCATION)
+		return INVALID_ALLOCATION;
+	RemoveFreeBlock(block);
+
+	uint64_t offset = m_blocks[block].Offset;
+	uint64_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+	if (alignedOffset != offset)
+	{
+		// The padding stays a free block in front of the allocation
+		Split(block, alignedOffset - offset);
+		uint32_t padded = block;
+		block = m_blocks[padded].NextPhysical;
+		RemoveFreeBlock(block);
+		InsertFreeBlock(padded);
+	}
+	if (m_blocks[block].Size > size)
+		Split(block, size);
+
+	m_blocks[block].IsUsed = true;
+	m_usedSize += size;
+	m_allocationCount++;
+	return block;
+}
+
+void TlsfAllocator::Free(uint32_t allocation)
+{
+	if (allocation >= m_blocks.size() || !m_blocks[allocation].IsUsed)
+		return;
+
+	Block& block = m_blocks[allocation];
+	block.IsUsed = false;
+	m_usedSize -= block.Size;
+	m_allocationCount--;
+
+	uint32_t next = block.NextPhysical;
+	if (next != INVALID_ALLOCATION && m_blocks[next].IsFree)
+	{
+		RemoveFreeBlock(next);
+		Merge(allocation, next);
+	}
+	uint32_t prev = m_blocks[allocation].PrevPhysical;
+	if (prev != INVALID_ALLOCATION && m_blocks[prev].IsFree)
+	{
+		RemoveFreeBlock(prev);
+		Merge(prev, allocation);
+		allocation = prev;
+	}
+	InsertFreeBlock(allocation);
+}
+
+TlsfStats TlsfAllocator::GetStats() const
+{
+	TlsfStats stats;
+	stats.TotalSize = m_totalSize;
+	stats.UsedSize = m_usedSize;
+	stats.AllocationCount = m_allocationCount;
+	stats.FreeBlockCount = m_freeBlockCount;
+	if (m_firstLevelBitmap == 0)
+		return stats;
+
+	// The largest block is in the highest non empty class
+	int firstLevel = 63 - std::countl_zero(m_firstLevelBitmap);
+	int secondLevel = 31 - std::countl_zero(m_secondLevelBitmaps[firstLevel]);
+	for (uint32_t block = m_freeLists[firstLevel][secondLevel]; block != INVALID_ALLOCATION; block = m_blocks[block].NextFree)
+		stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, m_blocks[block].Size);
+	return stats;
+}
+
+uint32_t TlsfAllocator::GetNextAllocation(uint32_t allocation) const
+{
+	uint32_t block = allocation == INVALID_ALLOCATION ? m_firstPhysicalBlock : m_blocks[allocation].NextPhysical;
+	while (block != INVALID_ALLOCATION && !m_blocks[block].IsUsed)
+		block = m_blocks[block].NextPhysical;
+	return block;
+}
@@ -4,6 +4,7 @@
 #include "framework.h"
 #include "SleepyGame.h"
 #include "SleepyEngine.h"
+#include "HeadlessRunner.h"
 #include <iostream>
 #include <io.h>
 #include <fcntl.h>
@@ -17,15 +18,31 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_ int       nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
     
     AllocConsole();
     FILE* consoleOut;
     freopen_s(&consoleOut, "CONOUT$", "w", stdout);
 
-    SleepyEngine engine(hInstance);
-    engine.Initialize();
-    engine.Run();
+    // -record <file>: records the input of the session
+    // -replay <file>: replays a recorded session without window at full speed, writes its frame times
+    std::wstring commandLine = lpCmdLine;
+    std::string argument(commandLine.begin(), commandLine.end());
+    if (argument.rfind("-replay ", 0) == 0)
+    {
+        HeadlessRunner runner;
+        runner.Init();
+        int frameCount = runner.Run(argument.substr(8));
+        runner.ExportFrameStats("SleepyReplayStats.csv");
+        std::cout << "Replayed " << frameCount << " frames" << std::endl;
+    }
+    else
+    {
+        SleepyEngine engine(hInstance);
+        if (argument.rfind("-record ", 0) == 0)
+            engine.SetInputRecordPath(argument.substr(8));
+        engine.Initialize();
+        engine.Run();
+    }
 
     fclose(consoleOut);
     FreeConsole();
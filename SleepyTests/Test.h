@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+
+// Minimal self registering tests and benchmarks. Only portable code: the project links the
+// engine library on Windows, the same sources build against the engine sources elsewhere.
+typedef void (*TestFunction)();
+
+struct TestCase
+{
+	const char* Name;
+	TestFunction Function;
+	bool IsBenchmark;
+};
+
+class TestRegistry
+{
+public:
+	static bool Register(const char* name, TestFunction function, bool isBenchmark);
+	static std::vector<TestCase>& GetCases();
+
+	// Called by CHECK, the test keeps running
+	static void Fail(const char* file, int line, const char* expression);
+	static int GetFailureCount() { return s_failureCount; }
+
+private:
+	static int s_failureCount;
+};
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static bool s_is##name##Registered = TestRegistry::Register(#name, &name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static bool s_is##name##Registered = TestRegistry::Register(#name, &name, true); \
+	static void name()
+
+#define CHECK(expression) do { if (!(expression)) TestRegistry::Fail(__FILE__, __LINE__, #expression); } while (0)
@@ -0,0 +1,65 @@
+#include "Test.h"
+#include "TlsfAllocator.h"
+#include "Timer.h"
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+BENCHMARK(TlsfAllocateFree)
+{
+	// Sizes from one granule to 64, freed in an order that forces merges
+	TlsfAllocator allocator;
+	allocator.Init((uint64_t)1 << 30);
+	const int count = 100000;
+	std::vector<uint32_t> ids;
+	ids.reserve(count);
+
+	int64_t start = Timer::GetTicks();
+	for (int round = 0; round < 10; round++)
+	{
+		for (int i = 0; i < count; i++)
+			ids.push_back(allocator.Allocate(TlsfAllocator::GRANULARITY * (1 + i % 64)));
+		for (int i = 0; i < count; i += 2)
+			allocator.Free(ids[i]);
+		for (int i = 1; i < count; i += 2)
+			allocator.Free(ids[i]);
+		ids.clear();
+	}
+	double nanoseconds = (double)(Timer::GetTicks() - start) / (10.0 * count);
+	std::cout << "ns per allocate + free: " << std::fixed << std::setprecision(1) << nanoseconds << std::endl;
+}
+
+BENCHMARK(TlsfFragmentation)
+{
+	// Random churn at about 70% occupancy, how scattered the free space gets
+	std::mt19937_64 random(3);
+	TlsfAllocator allocator;
+	allocator.Init(256 << 20);
+	std::vector<uint32_t> ids;
+	std::cout << "operations  used  free blocks  largest free  fragmentation" << std::endl;
+	for (int operation = 1; operation <= 1000000; operation++)
+	{
+		bool isAllocating = ids.empty() || allocator.GetUsedSize() < allocator.GetTotalSize() * 7 / 10;
+		if (isAllocating)
+		{
+			uint32_t id = allocator.Allocate(TlsfAllocator::GRANULARITY * (1 + random() % 256));
+			if (id != TlsfAllocator::INVALID_ALLOCATION)
+				ids.push_back(id);
+		}
+		else
+		{
+			int index = (int)(random() % ids.size());
+			allocator.Free(ids[index]);
+			ids[index] = ids.back();
+			ids.pop_back();
+		}
+
+		if (operation % 200000 == 0)
+		{
+			TlsfStats stats = allocator.GetStats();
+			std::cout << std::setw(10) << operation << "  " << std::setw(3) << stats.UsedSize * 100 / stats.TotalSize << "%  "
+				<< std::setw(11) << stats.FreeBlockCount << "  " << std::setw(9) << (stats.LargestFreeBlock >> 10) << " KB  "
+				<< std::setprecision(3) << stats.GetFragmentation() << std::endl;
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include "Test.h"
+#include "JobSystem.h"
+#include "Timer.h"
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+static void EmptyJob(void* pData, int begin, int end)
+{
+}
+
+struct StealData
+{
+	std::atomic<int> ExecutedCounts[64];
+};
+
+static void CountWorker(void* pData, int begin, int end)
+{
+	int workerIndex = JobSystem::GetWorkerIndex();
+	((StealData*)pData)->ExecutedCounts[workerIndex >= 0 && workerIndex < 64 ? workerIndex : 0].fetch_add(1, std::memory_order_relaxed);
+}
+
+static int GetHardwareThreadCount()
+{
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+BENCHMARK(JobSpawnOverhead)
+{
+	// Batches below MAX_JOBS_IN_FLIGHT, the pool of the submitting thread is a ring
+	const int batchSize = JobSystem::MAX_JOBS_IN_FLIGHT / 2;
+	const int batchCount = 200;
+	std::cout << "workers  ns/job (spawn + run + wait)" << std::endl;
+	for (int workerCount = 1; workerCount <= GetHardwareThreadCount(); workerCount *= 2)
+	{
+		JobSystem jobSystem;
+		jobSystem.Init(workerCount);
+		int64_t start = Timer::GetTicks();
+		for (int batch = 0; batch < batchCount; batch++)
+		{
+			JobCounter counter;
+			for (int i = 0; i < batchSize; i++)
+				jobSystem.Run(&EmptyJob, nullptr, &counter);
+			jobSystem.Wait(counter);
+		}
+		double nanoseconds = (double)(Timer::GetTicks() - start) / ((double)batchSize * batchCount);
+		std::cout << std::setw(7) << workerCount << "  " << std::fixed << std::setprecision(1) << nanoseconds << std::endl;
+	}
+}
+
+BENCHMARK(JobStealOverhead)
+{
+	// Everything is pushed on worker 0, the other workers only get jobs by stealing
+	const int batchSize = JobSystem::MAX_JOBS_IN_FLIGHT / 2;
+	const int batchCount = 200;
+	std::cout << "workers  ns/job  stolen" << std::endl;
+	// At least one thief, even on a single core
+	int maxWorkerCount = GetHardwareThreadCount() > 2 ? GetHardwareThreadCount() : 2;
+	for (int workerCount = 2; workerCount <= maxWorkerCount && workerCount <= 64; workerCount *= 2)
+	{
+		JobSystem jobSystem;
+		jobSystem.Init(workerCount);
+		StealData data;
+		for (int i = 0; i < 64; i++)
+			data.ExecutedCounts[i].store(0);
+
+		int64_t start = Timer::GetTicks();
+		for (int batch = 0; batch < batchCount; batch++)
+		{
+			JobCounter counter;
+			for (int i = 0; i < batchSize; i++)
+				jobSystem.Run(&CountWorker, &data, &counter);
+			jobSystem.Wait(counter);
+		}
+		int64_t ticks = Timer::GetTicks() - start;
+
+		int total = batchSize * batchCount;
+		int stolen = total - data.ExecutedCounts[0].load();
+		std::cout << std::setw(7) << workerCount << "  " << std::fixed << std::setprecision(1) << std::setw(6) << (double)ticks / total
+			<< "  " << std::setprecision(1) << std::setw(5) << 100.0 * stolen / total << "%" << std::endl;
+	}
+}
+
+BENCHMARK(ParallelForScaling)
+{
+	// Compute bound loop, the speedup from 1 to N workers
+	const int count = 1 << 22;
+	std::vector<float> values(count);
+	auto work = [&values](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			float x = (float)i;
+			for (int k = 0; k < 16; k++)
+				x = std::sqrt(x + 1.0f);
+			values[i] = x;
+		}
+	};
+
+	std::cout << "workers  ms  speedup" << std::endl;
+	double baseMs = 0.0;
+	for (int workerCount = 1; workerCount <= GetHardwareThreadCount(); workerCount++)
+	{
+		JobSystem jobSystem;
+		jobSystem.Init(workerCount);
+		// Best of a few runs, the first one also warms the caches and wakes the workers
+		double bestMs = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			int64_t start = Timer::GetTicks();
+			jobSystem.ParallelFor(count, 1024, work);
+			double ms = Timer::TicksToSeconds(Timer::GetTicks() - start) * 1000.0;
+			bestMs = ms < bestMs ? ms : bestMs;
+		}
+		if (workerCount == 1)
+			baseMs = bestMs;
+		std::cout << std::setw(7) << workerCount << "  " << std::fixed << std::setprecision(2) << bestMs << "  " << baseMs / bestMs << "x" << std::endl;
+	}
+}
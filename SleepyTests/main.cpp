@@ -0,0 +1,60 @@
+#include "Test.h"
+#include <iostream>
+#include <string>
+
+int TestRegistry::s_failureCount = 0;
+
+bool TestRegistry::Register(const char* name, TestFunction function, bool isBenchmark)
+{
+	GetCases().push_back({ name, function, isBenchmark });
+	return true;
+}
+
+std::vector<TestCase>& TestRegistry::GetCases()
+{
+	// Built on first use, registration runs during static initialization
+	static std::vector<TestCase> s_cases;
+	return s_cases;
+}
+
+void TestRegistry::Fail(const char* file, int line, const char* expression)
+{
+	s_failureCount++;
+	std::cout << file << "(" << line << "): CHECK(" << expression << ") failed" << std::endl;
+}
+
+// SleepyTests [-bench] [name]
+// Runs the tests, or the benchmarks with -bench. name only runs the cases containing it.
+int main(int argc, char* argv[])
+{
+	bool isBenchmark = false;
+	std::string filter;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "-bench")
+			isBenchmark = true;
+		else
+			filter = argument;
+	}
+
+	int runCount = 0;
+	int failedCount = 0;
+	std::vector<TestCase>& cases = TestRegistry::GetCases();
+	for (int i = 0; i < cases.size(); i++)
+	{
+		if (cases[i].IsBenchmark != isBenchmark || std::string(cases[i].Name).find(filter) == std::string::npos)
+			continue;
+
+		std::cout << "[ RUN  ] " << cases[i].Name << std::endl;
+		int failureCount = TestRegistry::GetFailureCount();
+		cases[i].Function();
+		bool isPassed = TestRegistry::GetFailureCount() == failureCount;
+		std::cout << (isPassed ? "[  OK  ] " : "[ FAIL ] ") << cases[i].Name << std::endl;
+		runCount++;
+		failedCount += isPassed ? 0 : 1;
+	}
+
+	std::cout << runCount - failedCount << "/" << runCount << " passed" << std::endl;
+	return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "ActionMap.h"
+#include "Input.h"
+
+static const int KEY_CTRL = 0x11;
+
+static void Press(Input& input, int key)
+{
+	InputEvent event = {};
+	event.Type = InputEventType::KeyDown;
+	event.Key = (uint8_t)key;
+	input.PushEvent(event);
+}
+
+static void Release(Input& input, int key)
+{
+	InputEvent event = {};
+	event.Type = InputEventType::KeyUp;
+	event.Key = (uint8_t)key;
+	input.PushEvent(event);
+}
+
+static void Step(Input& input, ActionMap& actions)
+{
+	input.Update();
+	actions.Evaluate(input);
+}
+
+TEST_CASE(ActionMapChordNeedsEveryKey)
+{
+	Input input;
+	input.Init();
+	ActionMap actions;
+	actions.Init();
+	int save = actions.RegisterAction("Save");
+	CHECK(actions.BindChord(save, { KEY_CTRL, 'S' }));
+
+	Press(input, 'S');
+	Step(input, actions);
+	CHECK(!actions.IsActive(save));
+
+	Press(input, KEY_CTRL);
+	Step(input, actions);
+	CHECK(actions.IsActive(save));
+	CHECK(actions.WasActivated(save));
+
+	Release(input, 'S');
+	Step(input, actions);
+	CHECK(!actions.IsActive(save));
+	CHECK(actions.WasDeactivated(save));
+
+	// Over MAX_CHORD_KEYS, out of range keys and unknown actions are refused
+	CHECK(!actions.BindChord(save, { 'A', 'B', 'C', 'D', 'E' }));
+	CHECK(!actions.BindChord(save, { 'A', Input::KEY_COUNT }));
+	CHECK(!actions.Bind(save + 1, 'A'));
+}
+
+TEST_CASE(ActionMapDropsDuplicateBindings)
+{
+	ActionMap actions;
+	actions.Init();
+	int save = actions.RegisterAction("Save");
+	int jump = actions.RegisterAction("Jump");
+	CHECK(actions.RegisterAction("Save") == save);
+	CHECK(actions.FindAction("Jump") == jump);
+
+	actions.BindChord(save, { KEY_CTRL, 'S' });
+	actions.BindChord(save, { 'S', KEY_CTRL });
+	actions.BindChord(save, { 'S', KEY_CTRL, 'S' });
+	actions.Bind(jump, ' ');
+	actions.Bind(jump, ' ');
+	// The same chord on another action is kept
+	actions.BindChord(jump, { KEY_CTRL, 'S' });
+	actions.Compile();
+	CHECK(actions.GetCompiledCount() == 3);
+
+	actions.ClearBindings(save);
+	actions.Compile();
+	CHECK(actions.GetCompiledCount() == 2);
+}
+
+TEST_CASE(ActionMapEdgesAgainstPreviousFrame)
+{
+	Input input;
+	input.Init();
+	ActionMap actions;
+	actions.Init();
+	int fire = actions.RegisterAction("Fire");
+	actions.Bind(fire, 'F');
+	actions.Bind(fire, 'G');
+
+	Press(input, 'F');
+	Step(input, actions);
+	CHECK(actions.IsActive(fire) && actions.WasActivated(fire));
+
+	// Still held, or held through another binding: no new edge
+	Step(input, actions);
+	CHECK(actions.IsActive(fire) && !actions.WasActivated(fire));
+	Press(input, 'G');
+	Release(input, 'F');
+	Step(input, actions);
+	CHECK(actions.IsActive(fire) && !actions.WasActivated(fire) && !actions.WasDeactivated(fire));
+
+	Release(input, 'G');
+	Step(input, actions);
+	CHECK(!actions.IsActive(fire) && actions.WasDeactivated(fire));
+	Step(input, actions);
+	CHECK(!actions.WasDeactivated(fire));
+
+	// Tapped within one frame: active for that frame
+	Press(input, 'F');
+	Release(input, 'F');
+	Step(input, actions);
+	CHECK(actions.WasActivated(fire));
+	Step(input, actions);
+	CHECK(actions.WasDeactivated(fire));
+}
+
+TEST_CASE(ActionMapUnknownIdsAreInactive)
+{
+	ActionMap actions;
+	actions.Init();
+	int missing = actions.FindAction("Missing");
+	CHECK(missing == -1);
+	CHECK(!actions.IsActive(missing));
+	CHECK(!actions.WasActivated(missing));
+	CHECK(!actions.WasDeactivated(missing));
+	CHECK(!actions.IsActive(ActionMap::MAX_ACTIONS));
+}
@@ -0,0 +1,126 @@
+#include "Test.h"
+#include "DescriptorAllocator.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+TEST_CASE(DescriptorAllocatorReusesLowestPersistent)
+{
+	DescriptorAllocator allocator;
+	allocator.Init(4, 16);
+
+	uint32_t descriptors[4];
+	for (int i = 0; i < 4; i++)
+	{
+		descriptors[i] = allocator.AllocatePersistent();
+		CHECK(descriptors[i] == (uint32_t)i);
+	}
+	CHECK(allocator.AllocatePersistent() == DescriptorAllocator::INVALID_DESCRIPTOR);
+
+	// Last freed, first reused
+	allocator.FreePersistent(2);
+	allocator.FreePersistent(1);
+	CHECK(allocator.AllocatePersistent() == 1);
+
+	DescriptorStats stats = allocator.GetStats();
+	CHECK(stats.PersistentCapacity == 4);
+	CHECK(stats.PersistentInUse == 3);
+	CHECK(stats.PersistentPeak == 4);
+	CHECK(stats.PersistentAllocations == 5);
+	CHECK(stats.PersistentFrees == 2);
+	CHECK(stats.FailedAllocations == 1);
+	CHECK(stats.InvalidFrees == 0);
+}
+
+TEST_CASE(DescriptorAllocatorIgnoresDoubleFrees)
+{
+	DescriptorAllocator allocator;
+	allocator.Init(4, 16);
+	uint32_t first = allocator.AllocatePersistent();
+	uint32_t second = allocator.AllocatePersistent();
+
+	allocator.FreePersistent(first);
+	allocator.FreePersistent(first);
+	// Never allocated, out of range, and the no-op one
+	allocator.FreePersistent(3);
+	allocator.FreePersistent(4);
+	allocator.FreePersistent(DescriptorAllocator::INVALID_DESCRIPTOR);
+
+	DescriptorStats stats = allocator.GetStats();
+	CHECK(stats.InvalidFrees == 3);
+	CHECK(stats.PersistentFrees == 1);
+	CHECK(stats.PersistentInUse == 1);
+
+	// Handed out once, not to two owners
+	uint32_t reused[3];
+	for (int i = 0; i < 3; i++)
+		reused[i] = allocator.AllocatePersistent();
+	std::sort(reused, reused + 3);
+	CHECK(reused[0] == 0 && reused[1] == 2 && reused[2] == 3);
+	CHECK(reused[0] == first && second == 1);
+	CHECK(allocator.AllocatePersistent() == DescriptorAllocator::INVALID_DESCRIPTOR);
+}
+
+TEST_CASE(DescriptorAllocatorTransientFailsUntilRetired)
+{
+	DescriptorAllocator allocator;
+	allocator.Init(0, 16);
+
+	CHECK(allocator.AllocateTransient(0) == DescriptorAllocator::INVALID_DESCRIPTOR);
+	CHECK(allocator.AllocateTransient(10) == 0);
+	allocator.EndFrame(1);
+	// 6 left before the end, a table never straddles it
+	CHECK(allocator.AllocateTransient(8) == DescriptorAllocator::INVALID_DESCRIPTOR);
+	allocator.Retire(1);
+	CHECK(allocator.AllocateTransient(8) == 0);
+
+	DescriptorStats stats = allocator.GetStats();
+	CHECK(stats.TransientCapacity == 16);
+	CHECK(stats.TransientAllocations == 18);
+	CHECK(stats.FailedAllocations == 1);
+
+	allocator.AddCopies(5);
+	allocator.AddCopies(3);
+	stats = allocator.GetStats();
+	CHECK(stats.CopiedDescriptors == 8);
+	CHECK(stats.CopyBatches == 2);
+}
+
+TEST_CASE(DescriptorAllocatorConcurrentTransientDoNotOverlap)
+{
+	DescriptorAllocator allocator;
+	allocator.Init(0, 1 << 16);
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	const int count = 2000;
+	std::vector<uint32_t> firsts(count);
+	std::vector<uint32_t> counts(count);
+	for (int frame = 0; frame < 50; frame++)
+	{
+		jobSystem.ParallelFor(count, 16, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				counts[i] = 1 + (i * 7) % 16;
+				firsts[i] = allocator.AllocateTransient(counts[i]);
+			}
+		});
+
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		for (int i = 0; i < count; i++)
+		{
+			if (firsts[i] != DescriptorAllocator::INVALID_DESCRIPTOR)
+				ranges.push_back({ firsts[i], counts[i] });
+		}
+		std::sort(ranges.begin(), ranges.end());
+		for (int i = 1; i < ranges.size(); i++)
+			CHECK(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+		for (int i = 0; i < ranges.size(); i++)
+			CHECK(ranges[i].first + ranges[i].second <= allocator.GetStats().TransientCapacity);
+
+		// Two frames in flight, about 17000 descriptors each: always fits
+		allocator.EndFrame(frame + 1);
+		allocator.Retire(frame >= 2 ? frame - 1 : 0);
+	}
+	CHECK(allocator.GetStats().FailedAllocations == 0);
+}
@@ -0,0 +1,86 @@
+#include "Test.h"
+#include "FrameRing.h"
+
+TEST_CASE(FrameRingWaitsOnlyForItsSlot)
+{
+	// The GPU finishes a frame two signals after it was submitted
+	MockFenceTimeline timeline(2);
+	FrameRing ring;
+	CHECK(ring.Init(&timeline, 3));
+
+	// First pass over the slots: nothing was submitted on them
+	for (int frame = 0; frame < 3; frame++)
+	{
+		CHECK(ring.BeginFrame() == frame);
+		ring.EndFrame();
+		CHECK(ring.GetFenceValue(frame) == (uint64_t)frame + 1);
+	}
+	CHECK(ring.GetWaitCount() == 0);
+	CHECK(timeline.GetCompletedValue() == 1);
+
+	// Slot 0 holds fence 1, already completed
+	CHECK(ring.BeginFrame() == 0);
+	CHECK(ring.GetWaitCount() == 0);
+	ring.EndFrame();
+	CHECK(ring.GetFenceValue(0) == 4);
+
+	// Slot 1 holds fence 2, completed by the signal of the frame above
+	CHECK(ring.BeginFrame() == 1);
+	CHECK(ring.GetWaitCount() == 0);
+	ring.EndFrame();
+	CHECK(ring.GetSubmittedCount() == 5);
+}
+
+TEST_CASE(FrameRingBlocksWhenGpuIsBehind)
+{
+	// Completes nothing on its own: every reused slot has to wait for its fence
+	MockFenceTimeline timeline(100);
+	FrameRing ring;
+	ring.Init(&timeline, 2);
+
+	ring.BeginFrame();
+	ring.EndFrame();
+	ring.BeginFrame();
+	ring.EndFrame();
+	CHECK(timeline.GetCompletedValue() == 0);
+
+	CHECK(ring.BeginFrame() == 0);
+	CHECK(ring.GetWaitCount() == 1);
+	CHECK(timeline.GetWaitCount() == 1);
+	// Waited for fence 1 only, not for the frame still in flight on slot 1
+	CHECK(timeline.GetCompletedValue() == 1);
+	ring.EndFrame();
+
+	ring.WaitIdle();
+	CHECK(timeline.GetCompletedValue() == timeline.GetLastSignaledValue());
+}
+
+TEST_CASE(FrameRingClampsFrameCount)
+{
+	MockFenceTimeline timeline(100);
+	FrameRing ring;
+	CHECK(!ring.Init(nullptr, 2));
+
+	CHECK(ring.Init(&timeline, 8));
+	CHECK(ring.GetFrameCount() == FrameRing::MAX_FRAME_COUNT);
+	// Slots cycle over the clamped count, every one of them gets its own fence
+	for (int frame = 0; frame < FrameRing::MAX_FRAME_COUNT * 2; frame++)
+	{
+		CHECK(ring.BeginFrame() == frame % FrameRing::MAX_FRAME_COUNT);
+		ring.EndFrame();
+		CHECK(ring.GetFenceValue(ring.GetFrameIndex()) == timeline.GetLastSignaledValue());
+	}
+	CHECK(ring.GetWaitCount() == FrameRing::MAX_FRAME_COUNT);
+
+	// A single frame in flight waits for the previous one every time
+	CHECK(ring.Init(&timeline, 0));
+	CHECK(ring.GetFrameCount() == 1);
+	uint64_t waitCount = timeline.GetWaitCount();
+	for (int frame = 0; frame < 4; frame++)
+	{
+		CHECK(ring.BeginFrame() == 0);
+		ring.EndFrame();
+	}
+	CHECK(ring.GetWaitCount() == 3);
+	CHECK(timeline.GetWaitCount() == waitCount + 3);
+}
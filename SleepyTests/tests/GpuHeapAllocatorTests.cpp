@@ -0,0 +1,315 @@
+#include "Test.h"
+#include "TlsfAllocator.h"
+#include "GpuHeapAllocator.h"
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// Heaps in CPU memory, so the fuzzer can check the data survives defragmentation
+class MemoryHeapSource : public GpuHeapSource
+{
+public:
+	// Never resized afterwards, so other threads can read the heaps while new ones are created
+	MemoryHeapSource() { m_heaps.resize(64); }
+
+	bool CreateHeap(int heapIndex, uint64_t size) override
+	{
+		if (heapIndex >= m_heaps.size())
+			m_heaps.resize(heapIndex + 1);
+		m_heaps[heapIndex].assign(size, 0);
+		m_liveCount++;
+		return true;
+	}
+	void DestroyHeap(int heapIndex) override
+	{
+		m_heaps[heapIndex].clear();
+		m_heaps[heapIndex].shrink_to_fit();
+		m_liveCount--;
+	}
+
+	uint8_t* GetData(const GpuHeapAllocation& allocation) { return m_heaps[allocation.HeapIndex].data() + allocation.Offset; }
+	int GetLiveCount() const { return m_liveCount; }
+
+private:
+	std::vector<std::vector<uint8_t>> m_heaps;
+	int m_liveCount = 0;
+};
+
+TEST_CASE(TlsfFuzz)
+{
+	std::mt19937_64 random(7);
+	for (int trial = 0; trial < 20; trial++)
+	{
+		TlsfAllocator allocator;
+		CHECK(allocator.Init((1 + random() % 64) << 20));
+
+		// Offset -> size and id, mirrors what the allocator should hold
+		std::map<uint64_t, std::pair<uint64_t, uint32_t>> live;
+		uint64_t usedSize = 0;
+		int errorCount = 0;
+		for (int operation = 0; operation < 20000; operation++)
+		{
+			if (live.empty() || random() % 100 < 55)
+			{
+				uint64_t size = 1 + (random() % 4 == 0 ? random() % (1 << 20) : random() % 4096);
+				uint64_t alignment = (uint64_t)1 << (random() % 17);
+				uint32_t id = allocator.Allocate(size, alignment);
+				if (id == TlsfAllocator::INVALID_ALLOCATION)
+					continue;
+
+				uint64_t offset = allocator.GetOffset(id);
+				uint64_t allocatedSize = allocator.GetSize(id);
+				errorCount += offset % alignment != 0 || offset % TlsfAllocator::GRANULARITY != 0 ? 1 : 0;
+				errorCount += allocatedSize < size || offset + allocatedSize > allocator.GetTotalSize() ? 1 : 0;
+				// No overlap with the neighbors
+				auto next = live.lower_bound(offset);
+				if (next != live.end())
+					errorCount += offset + allocatedSize > next->first ? 1 : 0;
+				if (next != live.begin())
+				{
+					auto previous = std::prev(next);
+					errorCount += previous->first + previous->second.first > offset ? 1 : 0;
+				}
+				live[offset] = { allocatedSize, id };
+				usedSize += allocatedSize;
+			}
+			else
+			{
+				auto it = live.begin();
+				std::advance(it, random() % live.size());
+				allocator.Free(it->second.second);
+				usedSize -= it->second.first;
+				live.erase(it);
+			}
+			errorCount += allocator.GetUsedSize() != usedSize ? 1 : 0;
+		}
+		CHECK(errorCount == 0);
+
+		int allocationCount = 0;
+		for (uint32_t id = allocator.GetNextAllocation(TlsfAllocator::INVALID_ALLOCATION); id != TlsfAllocator::INVALID_ALLOCATION; id = allocator.GetNextAllocation(id))
+			allocationCount++;
+		CHECK(allocationCount == (int)live.size());
+		CHECK(allocator.GetStats().AllocationCount == (int)live.size());
+
+		// Everything merges back into one block
+		for (auto it = live.begin(); it != live.end(); it++)
+			allocator.Free(it->second.second);
+		TlsfStats stats = allocator.GetStats();
+		CHECK(stats.FreeBlockCount == 1);
+		CHECK(stats.LargestFreeBlock == allocator.GetTotalSize());
+		CHECK(stats.GetFragmentation() == 0.0f);
+	}
+}
+
+TEST_CASE(GpuHeapAllocatorFuzzWithDefragmentation)
+{
+	std::mt19937_64 random(11);
+	MemoryHeapSource source;
+	GpuHeapAllocator allocator;
+	CHECK(allocator.Init(&source, 1 << 20));
+
+	// Each allocation is filled with its own byte, checked after every defragmentation
+	struct Live
+	{
+		GpuHeapAllocation Allocation;
+		uint8_t Pattern;
+	};
+	std::vector<Live> lives;
+	int errorCount = 0;
+	auto checkAll = [&]()
+	{
+		for (int i = 0; i < lives.size(); i++)
+		{
+			const uint8_t* pData = source.GetData(lives[i].Allocation);
+			for (uint64_t b = 0; b < lives[i].Allocation.Size; b += 97)
+				errorCount += pData[b] != lives[i].Pattern ? 1 : 0;
+		}
+	};
+
+	for (int round = 0; round < 50; round++)
+	{
+		for (int i = 0; i < 200; i++)
+		{
+			if (lives.empty() || random() % 100 < 60)
+			{
+				Live live;
+				live.Allocation = allocator.Allocate(1 + random() % (128 * 1024), (uint64_t)256 << (random() % 4));
+				if (!live.Allocation.IsValid())
+					continue;
+				live.Pattern = (uint8_t)random();
+				memset(source.GetData(live.Allocation), live.Pattern, live.Allocation.Size);
+				lives.push_back(live);
+			}
+			else
+			{
+				int index = (int)(random() % lives.size());
+				allocator.Free(lives[index].Allocation);
+				lives[index] = lives.back();
+				lives.pop_back();
+			}
+		}
+
+		allocator.Defragment(64, [&](const GpuHeapAllocation& from, const GpuHeapAllocation& to)
+		{
+			memcpy(source.GetData(to), source.GetData(from), from.Size);
+			for (int i = 0; i < lives.size(); i++)
+			{
+				if (lives[i].Allocation.HeapIndex == from.HeapIndex && lives[i].Allocation.Block == from.Block)
+					lives[i].Allocation = to;
+			}
+		});
+		checkAll();
+	}
+	CHECK(errorCount == 0);
+
+	for (int i = 0; i < lives.size(); i++)
+		allocator.Free(lives[i].Allocation);
+	// Only the first heap is kept
+	CHECK(source.GetLiveCount() == 1);
+}
+
+TEST_CASE(GpuHeapAllocatorDefragmentEmptiesSparseHeaps)
+{
+	MemoryHeapSource source;
+	GpuHeapAllocator allocator;
+	allocator.Init(&source, 1 << 20);
+
+	std::vector<GpuHeapAllocation> allocations;
+	for (int i = 0; i < 100; i++)
+		allocations.push_back(allocator.Allocate(100000));
+	CHECK(source.GetLiveCount() == 10);
+	for (int i = 0; i < 100; i++)
+	{
+		if (i % 3 != 0)
+		{
+			allocator.Free(allocations[i]);
+			allocations[i] = GpuHeapAllocation();
+		}
+	}
+
+	// The callbacks allocate and free: they run without the allocator lock
+	int moveCount = 0;
+	while (true)
+	{
+		int count = allocator.Defragment(100, [&](const GpuHeapAllocation& from, const GpuHeapAllocation& to)
+		{
+			GpuHeapAllocation scratch = allocator.Allocate(256);
+			allocator.Free(scratch);
+			for (int i = 0; i < allocations.size(); i++)
+			{
+				if (allocations[i].HeapIndex == from.HeapIndex && allocations[i].Block == from.Block)
+					allocations[i] = to;
+			}
+		});
+		if (count == 0)
+			break;
+		moveCount += count;
+	}
+	CHECK(moveCount > 0);
+	// 34 allocations of 100000 bytes left in 10 heaps, 10 fit in a heap
+	CHECK(source.GetLiveCount() < 10);
+	CHECK(source.GetLiveCount() >= 4);
+
+	for (int i = 0; i < allocations.size(); i++)
+		allocator.Free(allocations[i]);
+	CHECK(source.GetLiveCount() == 1);
+}
+
+TEST_CASE(GpuHeapAllocatorConcurrentDefragmentAndFree)
+{
+	MemoryHeapSource source;
+	GpuHeapAllocator allocator;
+	allocator.Init(&source, 1 << 20);
+
+	struct Live
+	{
+		GpuHeapAllocation Allocation;
+		uint8_t Pattern;
+	};
+	// Owner side: the allocations and their patterns, the callbacks retarget them
+	std::mutex livesMutex;
+	std::vector<Live> lives;
+	std::atomic<bool> isRunning(true);
+	std::atomic<int> errorCount(0);
+	std::atomic<int> moveCount(0);
+
+	auto onMove = [&](const GpuHeapAllocation& from, const GpuHeapAllocation& to)
+	{
+		std::lock_guard<std::mutex> lock(livesMutex);
+		for (int i = 0; i < lives.size(); i++)
+		{
+			if (lives[i].Allocation.HeapIndex == from.HeapIndex && lives[i].Allocation.Block == from.Block)
+			{
+				memcpy(source.GetData(to), source.GetData(from), from.Size);
+				lives[i].Allocation = to;
+				return;
+			}
+		}
+		// Freed by a worker during the defragmentation
+		allocator.Free(to);
+	};
+
+	// Two defragmenting threads race for the same source heap
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 2; t++)
+	{
+		threads.push_back(std::thread([&]()
+		{
+			while (isRunning.load())
+				moveCount += allocator.Defragment(16, onMove);
+		}));
+	}
+	for (int t = 0; t < 2; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			std::mt19937_64 random(100 + t);
+			for (int i = 0; i < 20000; i++)
+			{
+				std::lock_guard<std::mutex> lock(livesMutex);
+				if (lives.empty() || random() % 100 < 52)
+				{
+					Live live;
+					live.Allocation = allocator.Allocate(1 + random() % (64 * 1024));
+					if (!live.Allocation.IsValid())
+						continue;
+					live.Pattern = (uint8_t)random();
+					memset(source.GetData(live.Allocation), live.Pattern, live.Allocation.Size);
+					lives.push_back(live);
+				}
+				else
+				{
+					int index = (int)(random() % lives.size());
+					const Live& live = lives[index];
+					const uint8_t* pData = source.GetData(live.Allocation);
+					for (uint64_t b = 0; b < live.Allocation.Size; b += 97)
+						errorCount += pData[b] != live.Pattern ? 1 : 0;
+					allocator.Free(live.Allocation);
+					lives[index] = lives.back();
+					lives.pop_back();
+				}
+			}
+		}));
+	}
+	for (int t = 2; t < threads.size(); t++)
+		threads[t].join();
+	isRunning = false;
+	threads[0].join();
+	threads[1].join();
+
+	CHECK(errorCount.load() == 0);
+	CHECK(moveCount.load() > 0);
+	int allocationCount = 0;
+	for (int i = 0; i < allocator.GetHeapCount(); i++)
+		allocationCount += allocator.GetHeapStats(i).AllocationCount;
+	// No block freed twice or leaked
+	CHECK(allocationCount == (int)lives.size());
+
+	for (int i = 0; i < lives.size(); i++)
+		allocator.Free(lives[i].Allocation);
+	CHECK(source.GetLiveCount() == 1);
+	CHECK(allocator.GetHeapStats(0).AllocationCount == 0);
+}
@@ -0,0 +1,115 @@
+#include "Test.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <new>
+
+static void AddOne(void* pData, int begin, int end)
+{
+	((std::atomic<int>*)pData)->fetch_add(1, std::memory_order_relaxed);
+}
+
+TEST_CASE(ParallelForCoversRangeOnce)
+{
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	const int count = 100000;
+	std::vector<std::atomic<int>> visits(count);
+	for (int pass = 0; pass < 20; pass++)
+	{
+		for (int i = 0; i < count; i++)
+			visits[i].store(0, std::memory_order_relaxed);
+		jobSystem.ParallelFor(count, 64, [&visits](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				visits[i].fetch_add(1, std::memory_order_relaxed);
+		});
+
+		int wrongCount = 0;
+		for (int i = 0; i < count; i++)
+			wrongCount += visits[i].load(std::memory_order_relaxed) != 1 ? 1 : 0;
+		CHECK(wrongCount == 0);
+	}
+}
+
+TEST_CASE(RunAfterStartsOnceDependencyIsDone)
+{
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	std::atomic<int> firstCount(0);
+	std::atomic<int> secondCount(0);
+	for (int pass = 0; pass < 1000; pass++)
+	{
+		JobCounter first;
+		JobCounter second;
+		for (int i = 0; i < 8; i++)
+			jobSystem.Run(&AddOne, &firstCount, &first);
+		jobSystem.RunAfter(first, &AddOne, &secondCount, &second);
+		jobSystem.Wait(second);
+		CHECK(first.IsDone());
+	}
+	CHECK(firstCount.load() == 8000);
+	CHECK(secondCount.load() == 1000);
+}
+
+TEST_CASE(CounterOnStackOutlivesNoJob)
+{
+	// ParallelFor returns as soon as its stack counter is done, the last job must not touch it after
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	std::atomic<int> total(0);
+	for (int pass = 0; pass < 10000; pass++)
+		jobSystem.ParallelFor(8, 1, [&total](int begin, int end) { total.fetch_add(end - begin, std::memory_order_relaxed); });
+	CHECK(total.load() == 80000);
+}
+
+TEST_CASE(NewInstanceAtSameAddress)
+{
+	// The thread's job pool belongs to the destroyed instance, the new one must not reuse it
+	alignas(JobSystem) unsigned char storage[sizeof(JobSystem)];
+	for (int pass = 0; pass < 3; pass++)
+	{
+		JobSystem* pJobSystem = new (storage) JobSystem();
+		pJobSystem->Init(2);
+		std::atomic<int> count(0);
+		JobCounter counter;
+		for (int i = 0; i < 100; i++)
+			pJobSystem->Run(&AddOne, &count, &counter);
+		pJobSystem->Wait(counter);
+		CHECK(count.load() == 100);
+		pJobSystem->~JobSystem();
+	}
+}
+
+TEST_CASE(MoreJobsThanPoolSlots)
+{
+	// A single worker keeps every job queued until Wait: allocating past the pool has to run some first
+	JobSystem jobSystem;
+	jobSystem.Init(1);
+	std::atomic<int> count(0);
+	JobCounter counter;
+	const int jobCount = JobSystem::MAX_JOBS_IN_FLIGHT * 3;
+	for (int i = 0; i < jobCount; i++)
+		jobSystem.Run(&AddOne, &count, &counter);
+	jobSystem.Wait(counter);
+	CHECK(count.load() == jobCount);
+}
+
+TEST_CASE(ThreadAlternatesBetweenSystems)
+{
+	JobSystem first;
+	first.Init(2);
+	JobSystem second;
+	second.Init(2);
+	std::atomic<int> count(0);
+	for (int pass = 0; pass < 1000; pass++)
+	{
+		JobSystem& jobSystem = pass % 2 == 0 ? first : second;
+		JobCounter counter;
+		for (int i = 0; i < 4; i++)
+			jobSystem.Run(&AddOne, &count, &counter);
+		jobSystem.Wait(counter);
+	}
+	CHECK(count.load() == 4000);
+}
@@ -0,0 +1,138 @@
+#include "Test.h"
+#include "PipelineCache.h"
+#include "RhiNull.h"
+#include "JobSystem.h"
+#include <filesystem>
+#include <stdexcept>
+
+// Throws for the pipelines with no constant buffer, like a driver error surfaced as an exception
+class ThrowingDevice : public RhiNullDevice
+{
+public:
+	RhiPipeline* CreatePipeline(const RhiPipelineDesc& desc) override
+	{
+		if (desc.ConstantBufferCount == 0)
+			throw std::runtime_error("rejected");
+		return RhiNullDevice::CreatePipeline(desc);
+	}
+};
+
+static RhiPipelineDesc CreateDesc(const uint8_t* pShader, int constantBufferCount)
+{
+	RhiPipelineDesc desc;
+	desc.VertexShader = { pShader, 4 };
+	desc.PixelShader = { pShader, 4 };
+	desc.ConstantBufferCount = constantBufferCount;
+	return desc;
+}
+
+TEST_CASE(PipelineCacheSharesPipelines)
+{
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	RhiNullDevice device;
+	const uint8_t shader[4] = { 1, 2, 3, 4 };
+	PipelineCache cache;
+	cache.Init(&device, &jobSystem);
+
+	uint64_t key = cache.CreateAsync(CreateDesc(shader, 1));
+	RhiPipeline* pPipeline = cache.GetOrCreate(CreateDesc(shader, 1));
+	CHECK(pPipeline != nullptr);
+	CHECK(cache.Find(key) == pPipeline);
+	CHECK(cache.GetOrCreate(CreateDesc(shader, 2)) != pPipeline);
+	CHECK(cache.GetPipelineCount() == 2);
+	CHECK(cache.GetStats().Created == 2);
+	CHECK(cache.GetStats().Hits == 1);
+}
+
+TEST_CASE(PipelineCacheReportsThrowingCreation)
+{
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	ThrowingDevice device;
+	const uint8_t shader[4] = { 1, 2, 3, 4 };
+	{
+		PipelineCache cache;
+		cache.Init(&device, &jobSystem);
+
+		// On a worker: caught there instead of ending the program
+		uint64_t key = cache.CreateAsync(CreateDesc(shader, 0));
+		cache.WaitAll();
+		CHECK(cache.Find(key) == nullptr);
+		CHECK(cache.GetStats().Failed == 1);
+
+		// Asked again, and created on the calling thread: neither waits forever
+		CHECK(cache.GetOrCreate(CreateDesc(shader, 0)) == nullptr);
+		const uint8_t otherShader[4] = { 5, 6, 7, 8 };
+		CHECK(cache.GetOrCreate(CreateDesc(otherShader, 0)) == nullptr);
+		CHECK(cache.GetStats().Failed == 2);
+		CHECK(cache.GetStats().Created == 0);
+	}
+}
+
+TEST_CASE(PipelineCacheDestroyedWithPendingJobs)
+{
+	// The destructor waits for the jobs, counters included, before deleting the entries
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	RhiNullDevice device;
+	for (int run = 0; run < 50; run++)
+	{
+		PipelineCache cache;
+		cache.Init(&device, &jobSystem);
+		for (int i = 0; i < 32; i++)
+		{
+			const uint8_t shader[4] = { (uint8_t)i, (uint8_t)run, 0, 0 };
+			cache.CreateAsync(CreateDesc(shader, 1));
+		}
+	}
+	CHECK(device.GetStats().ValidationErrors == 0);
+}
+
+TEST_CASE(PipelineCachePersistsBlobsBetweenRuns)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "SleepyPipelineCache";
+	std::filesystem::remove_all(directory);
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	RhiNullDevice device;
+	const uint8_t shaders[3][4] = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 } };
+
+	// First run: everything is compiled and its blob stored
+	{
+		PipelineCache cache;
+		cache.Init(&device, &jobSystem);
+		CHECK(cache.SetCacheDirectory(directory.string()));
+		cache.GetOrCreate(CreateDesc(shaders[0], 1));
+		cache.CreateAsync(CreateDesc(shaders[1], 1));
+		cache.WaitAll();
+		CHECK(cache.GetStats().Created == 2);
+		CHECK(cache.GetStats().FromDisk == 0);
+	}
+
+	// Second run: the same pipelines come from the blobs, the new one is compiled
+	{
+		PipelineCache cache;
+		cache.Init(&device, &jobSystem);
+		CHECK(cache.SetCacheDirectory(directory.string()));
+		RhiPipeline* pPipeline = cache.GetOrCreate(CreateDesc(shaders[0], 1));
+		CHECK(pPipeline != nullptr && pPipeline->IsFromCachedBlob());
+		cache.CreateAsync(CreateDesc(shaders[1], 1));
+		cache.CreateAsync(CreateDesc(shaders[2], 1));
+		// Another root signature, another key
+		CHECK(!cache.GetOrCreate(CreateDesc(shaders[0], 2))->IsFromCachedBlob());
+		cache.WaitAll();
+		CHECK(cache.GetStats().Created == 4);
+		CHECK(cache.GetStats().FromDisk == 2);
+	}
+
+	// Without a directory nothing is read
+	{
+		PipelineCache cache;
+		cache.Init(&device, nullptr);
+		cache.GetOrCreate(CreateDesc(shaders[0], 1));
+		CHECK(cache.GetStats().FromDisk == 0);
+	}
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+}
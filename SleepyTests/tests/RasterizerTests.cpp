@@ -0,0 +1,256 @@
+#include "Test.h"
+#include "RhiSoftware.h"
+#include "JobSystem.h"
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// R in the lowest byte, like the swap chain
+static const uint32_t BLACK = 0xFF000000;
+static const uint32_t COLORS[4] = { 0xFF0000FF, 0xFF00FF00, 0xFFFF0000, 0xFFFFFFFF };
+
+// Position and color of Color.hlsl
+struct RasterVertex
+{
+	float Position[3];
+	float Color[4];
+};
+
+// One draw of the given vertices, identity transform, into a fresh swap chain
+class RasterFixture
+{
+public:
+	RasterFixture(JobSystem* pJobSystem, uint32_t width, uint32_t height) : m_device(pJobSystem)
+	{
+		RhiSwapChainDesc swapChainDesc;
+		swapChainDesc.Width = width;
+		swapChainDesc.Height = height;
+		m_pSwapChain = (RhiSoftwareSwapChain*)m_device.CreateSwapChain(swapChainDesc);
+
+		RhiPipelineDesc pipelineDesc;
+		pipelineDesc.IsDepthTested = false;
+		m_pPipeline = m_device.CreatePipeline(pipelineDesc);
+		m_pCommandList = m_device.CreateCommandList(1);
+
+		// InstanceData: transposed identity, white
+		RhiBufferDesc constantDesc;
+		constantDesc.Size = RhiSoftwareDevice::INSTANCE_STRIDE;
+		m_pConstants = m_device.CreateBuffer(constantDesc);
+		float* pInstance = (float*)m_pConstants->Map();
+		memset(pInstance, 0, RhiSoftwareDevice::INSTANCE_STRIDE);
+		for (int i = 0; i < 4; i++)
+		{
+			pInstance[i * 5] = 1.0f;
+			pInstance[16 + i] = 1.0f;
+		}
+	}
+
+	~RasterFixture()
+	{
+		delete m_pVertices;
+		delete m_pIndices;
+		delete m_pConstants;
+		delete m_pCommandList;
+		delete m_pPipeline;
+		delete m_pSwapChain;
+	}
+
+	void SetTriangles(const std::vector<RasterVertex>& vertices)
+	{
+		delete m_pVertices;
+		delete m_pIndices;
+		RhiBufferDesc desc;
+		desc.Size = vertices.size() * sizeof(RasterVertex);
+		m_pVertices = m_device.CreateBuffer(desc);
+		memcpy(m_pVertices->Map(), vertices.data(), desc.Size);
+
+		desc.Size = vertices.size() * sizeof(uint32_t);
+		m_pIndices = m_device.CreateBuffer(desc);
+		uint32_t* pIndices = (uint32_t*)m_pIndices->Map();
+		for (uint32_t i = 0; i < vertices.size(); i++)
+			pIndices[i] = i;
+		m_indexCount = (uint32_t)vertices.size();
+	}
+
+	const uint32_t* Draw()
+	{
+		const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		RhiViewport viewport;
+		viewport.Width = (float)m_pSwapChain->GetDesc().Width;
+		viewport.Height = (float)m_pSwapChain->GetDesc().Height;
+
+		m_pCommandList->Begin(0);
+		m_pCommandList->BeginRenderPass(m_pSwapChain, clearColor, false);
+		m_pCommandList->SetViewport(viewport);
+		m_pCommandList->SetPipeline(m_pPipeline);
+		m_pCommandList->SetVertexBuffer(m_pVertices, 0, sizeof(RasterVertex));
+		m_pCommandList->SetIndexBuffer(m_pIndices, 0);
+		m_pCommandList->SetConstantBuffer(0, m_pConstants, 0);
+		m_pCommandList->DrawIndexed(m_indexCount, 1, 0, 0);
+		m_pCommandList->EndRenderPass(false);
+		m_pCommandList->End();
+		m_device.GetQueue()->Submit(m_pCommandList);
+		m_pSwapChain->Present(false);
+		return m_pSwapChain->GetPresentedBuffer();
+	}
+
+	RhiSoftwareDevice& GetDevice() { return m_device; }
+
+private:
+	RhiSoftwareDevice m_device;
+	RhiSoftwareSwapChain* m_pSwapChain = nullptr;
+	RhiPipeline* m_pPipeline = nullptr;
+	RhiCommandList* m_pCommandList = nullptr;
+	RhiBuffer* m_pConstants = nullptr;
+	RhiBuffer* m_pVertices = nullptr;
+	RhiBuffer* m_pIndices = nullptr;
+	uint32_t m_indexCount = 0;
+};
+
+static void AddVertex(std::vector<RasterVertex>& vertices, float x, float y, float z, uint32_t color)
+{
+	RasterVertex vertex;
+	vertex.Position[0] = x;
+	vertex.Position[1] = y;
+	vertex.Position[2] = z;
+	for (int c = 0; c < 4; c++)
+		vertex.Color[c] = (float)((color >> (c * 8)) & 0xFF) / 255.0f;
+	vertices.push_back(vertex);
+}
+
+// Clockwise on screen, split along the top-left to bottom-right diagonal
+static void AddQuad(std::vector<RasterVertex>& vertices, float left, float top, float right, float bottom, uint32_t color)
+{
+	AddVertex(vertices, left, top, 0.5f, color);
+	AddVertex(vertices, right, top, 0.5f, color);
+	AddVertex(vertices, right, bottom, 0.5f, color);
+	AddVertex(vertices, left, top, 0.5f, color);
+	AddVertex(vertices, right, bottom, 0.5f, color);
+	AddVertex(vertices, left, bottom, 0.5f, color);
+}
+
+TEST_CASE(RasterizerCoversSharedEdgesOnce)
+{
+	// Pixel centers on the diagonal of a full screen quad: the left edge of the upper right triangle
+	// takes them, the lower left triangle only has a right edge there
+	const int size = 16;
+	RasterFixture fixture(nullptr, size, size);
+	std::vector<RasterVertex> vertices;
+	AddVertex(vertices, -1.0f, 1.0f, 0.5f, COLORS[0]);
+	AddVertex(vertices, 1.0f, 1.0f, 0.5f, COLORS[0]);
+	AddVertex(vertices, 1.0f, -1.0f, 0.5f, COLORS[0]);
+	AddVertex(vertices, -1.0f, 1.0f, 0.5f, COLORS[1]);
+	AddVertex(vertices, 1.0f, -1.0f, 0.5f, COLORS[1]);
+	AddVertex(vertices, -1.0f, -1.0f, 0.5f, COLORS[1]);
+	fixture.SetTriangles(vertices);
+	const uint32_t* pPixels = fixture.Draw();
+
+	int wrongCount = 0;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+			wrongCount += pPixels[y * size + x] != (x >= y ? COLORS[0] : COLORS[1]) ? 1 : 0;
+	}
+	CHECK(wrongCount == 0);
+	CHECK(fixture.GetDevice().GetRasterStats().PixelsWritten == size * size);
+}
+
+TEST_CASE(RasterizerCoversQuadCornersOnce)
+{
+	// Quads meeting at x = y = 8.5 (screen), on pixel centers: row 8 belongs to the quads below
+	// (top edge) and column 8 to the quads on the right (left edge)
+	const int size = 16;
+	RasterFixture fixture(nullptr, size, size);
+	const float middle = 2.0f * 8.5f / size - 1.0f;
+	std::vector<RasterVertex> vertices;
+	AddQuad(vertices, -1.0f, 1.0f, middle, -middle, COLORS[0]);
+	AddQuad(vertices, middle, 1.0f, 1.0f, -middle, COLORS[1]);
+	AddQuad(vertices, -1.0f, -middle, middle, -1.0f, COLORS[2]);
+	AddQuad(vertices, middle, -middle, 1.0f, -1.0f, COLORS[3]);
+	fixture.SetTriangles(vertices);
+	const uint32_t* pPixels = fixture.Draw();
+
+	int wrongCount = 0;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+			wrongCount += pPixels[y * size + x] != COLORS[(x >= 8 ? 1 : 0) + (y >= 8 ? 2 : 0)] ? 1 : 0;
+	}
+	CHECK(wrongCount == 0);
+	CHECK(fixture.GetDevice().GetRasterStats().PixelsWritten == size * size);
+}
+
+TEST_CASE(RasterizerClipsAgainstNearPlane)
+{
+	// z goes from -1 on the left to 1 on the right, the near plane cuts the screen in two halves.
+	// The upper right triangle has one vertex behind it and is split in 2, the other is cut to 1.
+	const int size = 16;
+	RasterFixture fixture(nullptr, size, size);
+	std::vector<RasterVertex> vertices;
+	AddVertex(vertices, -1.0f, 1.0f, -1.0f, COLORS[3]);
+	AddVertex(vertices, 1.0f, 1.0f, 1.0f, COLORS[3]);
+	AddVertex(vertices, 1.0f, -1.0f, 1.0f, COLORS[3]);
+	AddVertex(vertices, -1.0f, 1.0f, -1.0f, COLORS[3]);
+	AddVertex(vertices, 1.0f, -1.0f, 1.0f, COLORS[3]);
+	AddVertex(vertices, -1.0f, -1.0f, -1.0f, COLORS[3]);
+	fixture.SetTriangles(vertices);
+	const uint32_t* pPixels = fixture.Draw();
+
+	int wrongCount = 0;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+			wrongCount += pPixels[y * size + x] != (x >= size / 2 ? COLORS[3] : BLACK) ? 1 : 0;
+	}
+	CHECK(wrongCount == 0);
+	const SoftwareRasterStats& stats = fixture.GetDevice().GetRasterStats();
+	CHECK(stats.TrianglesSubmitted == 2);
+	CHECK(stats.TrianglesRasterized == 3);
+	CHECK(stats.PixelsWritten == size * size / 2);
+
+	// Entirely behind the near plane
+	vertices.clear();
+	AddVertex(vertices, -1.0f, 1.0f, -0.5f, COLORS[3]);
+	AddVertex(vertices, 1.0f, 1.0f, -0.5f, COLORS[3]);
+	AddVertex(vertices, 1.0f, -1.0f, -0.5f, COLORS[3]);
+	fixture.SetTriangles(vertices);
+	fixture.GetDevice().ResetRasterStats();
+	pPixels = fixture.Draw();
+	CHECK(fixture.GetDevice().GetRasterStats().TrianglesRasterized == 0);
+	CHECK(pPixels[size - 1] == BLACK);
+}
+
+BENCHMARK(RasterizerTrianglesPerSecond)
+{
+	JobSystem jobSystem;
+	jobSystem.Init();
+	RasterFixture fixture(&jobSystem, 1280, 720);
+
+	// Small triangles all over the screen, about 50 pixels each
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::vector<RasterVertex> vertices;
+	const int triangleCount = 200000;
+	const float size = 0.02f;
+	for (int i = 0; i < triangleCount; i++)
+	{
+		float x = position(random);
+		float y = position(random);
+		uint32_t color = COLORS[i % 4];
+		float z = 0.1f + 0.8f * (float)i / triangleCount;
+		AddVertex(vertices, x, y, z, color);
+		AddVertex(vertices, x + size, y, z, color);
+		AddVertex(vertices, x, y - size, z, color);
+	}
+	fixture.SetTriangles(vertices);
+
+	fixture.Draw();
+	fixture.GetDevice().ResetRasterStats();
+	for (int frame = 0; frame < 10; frame++)
+		fixture.Draw();
+
+	const SoftwareRasterStats& stats = fixture.GetDevice().GetRasterStats();
+	std::cout << "  " << (uint64_t)stats.GetTrianglesPerSecond() << " triangles/s, "
+		<< stats.PixelsWritten / stats.TrianglesRasterized << " pixels per triangle" << std::endl;
+	CHECK(stats.TrianglesRasterized > 0);
+}
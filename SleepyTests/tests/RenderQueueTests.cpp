@@ -0,0 +1,167 @@
+#include "Test.h"
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "RhiNull.h"
+#include "RhiSoftware.h"
+#include "JobSystem.h"
+#include <random>
+
+TEST_CASE(PartitionCoversBatchesInOrder)
+{
+	const int maxRangeCount = 8;
+	const int minBatchesPerRange = 16;
+	int rangeBegins[maxRangeCount + 1];
+	int batchCounts[] = { 0, 1, 15, 16, 17, 31, 32, 100, 128, 129, 1000 };
+	for (int i = 0; i < (int)(sizeof(batchCounts) / sizeof(batchCounts[0])); i++)
+	{
+		int batchCount = batchCounts[i];
+		int rangeCount = RenderQueue::Partition(batchCount, maxRangeCount, minBatchesPerRange, rangeBegins);
+		CHECK(rangeCount >= 1 && rangeCount <= maxRangeCount);
+		CHECK(rangeBegins[0] == 0);
+		CHECK(rangeBegins[rangeCount] == batchCount);
+		for (int r = 0; r < rangeCount; r++)
+		{
+			int size = rangeBegins[r + 1] - rangeBegins[r];
+			CHECK(size >= 0);
+			// Only a single range can be smaller than the minimum
+			CHECK(rangeCount == 1 || size >= minBatchesPerRange);
+		}
+		// As many ranges as the minimum allows
+		int expectedCount = batchCount / minBatchesPerRange;
+		expectedCount = expectedCount < maxRangeCount ? expectedCount : maxRangeCount;
+		CHECK(rangeCount == (expectedCount > 1 ? expectedCount : 1));
+	}
+}
+
+static void RecordPass(RhiCommandList* pCommandList, RhiSwapChain* pSwapChain, bool isResumed, bool isSuspended)
+{
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	pCommandList->Begin(0);
+	pCommandList->BeginRenderPass(pSwapChain, isResumed ? nullptr : clearColor, isResumed);
+	pCommandList->EndRenderPass(isSuspended);
+	pCommandList->End();
+}
+
+TEST_CASE(NullQueueChecksSuspendResumeOrder)
+{
+	RhiNullDevice device;
+	RhiSwapChainDesc swapChainDesc;
+	swapChainDesc.Width = 8;
+	swapChainDesc.Height = 8;
+	RhiSwapChain* pSwapChain = device.CreateSwapChain(swapChainDesc);
+	RhiCommandList* commandLists[3] = { device.CreateCommandList(1), device.CreateCommandList(1), device.CreateCommandList(1) };
+
+	// First suspends, middle resumes and suspends, last resumes
+	RecordPass(commandLists[0], pSwapChain, false, true);
+	RecordPass(commandLists[1], pSwapChain, true, true);
+	RecordPass(commandLists[2], pSwapChain, true, false);
+	device.GetQueue()->Submit(commandLists, 3);
+	CHECK(device.GetStats().ValidationErrors == 0);
+	CHECK(device.GetStats().CommandLists == 3);
+
+	// Out of order: the resumed pass comes first
+	RecordPass(commandLists[0], pSwapChain, false, true);
+	RecordPass(commandLists[1], pSwapChain, true, false);
+	RhiCommandList* reversed[2] = { commandLists[1], commandLists[0] };
+	device.GetQueue()->Submit(reversed, 2);
+	CHECK(device.GetStats().ValidationErrors > 0);
+
+	// The submission ends on a suspended pass
+	device.ResetStats();
+	RecordPass(commandLists[0], pSwapChain, false, true);
+	device.GetQueue()->Submit(commandLists[0]);
+	CHECK(device.GetStats().ValidationErrors == 1);
+
+	// Submitted again without recording
+	device.ResetStats();
+	device.GetQueue()->Submit(commandLists[0]);
+	CHECK(device.GetStats().ValidationErrors == 1);
+
+	for (int i = 0; i < 3; i++)
+		delete commandLists[i];
+	delete pSwapChain;
+}
+
+static void FillSnapshot(int boxCount, RenderSnapshot& snapshot)
+{
+	std::mt19937 random(3);
+	for (int i = 0; i < boxCount; i++)
+	{
+		RenderBox box;
+		box.Center = DirectX::XMFLOAT3((float)(random() % 60) - 30.0f, (float)(random() % 30) - 5.0f, (float)(random() % 60) - 30.0f);
+		box.PreviousCenter = box.Center;
+		box.HalfExtents = DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f);
+		box.IsSleeping = random() % 2 != 0;
+		snapshot.Boxes.push_back(box);
+	}
+}
+
+TEST_CASE(RendererSplitsDrawsOverCommandLists)
+{
+	JobSystem jobSystem;
+	jobSystem.Init(8);
+	RhiNullDevice device;
+	RhiSwapChainDesc swapChainDesc;
+	swapChainDesc.Width = 160;
+	swapChainDesc.Height = 120;
+	RhiSwapChain* pSwapChain = device.CreateSwapChain(swapChainDesc);
+
+	RenderSnapshot snapshot;
+	FillSnapshot(100000, snapshot);
+	{
+		Renderer renderer;
+		CHECK(renderer.Init(&device, pSwapChain, 2, &jobSystem, 64 << 20));
+		CHECK(renderer.CreatePipeline(RhiShaderBytecode(), RhiShaderBytecode()));
+		for (int frame = 0; frame < 3; frame++)
+		{
+			uint64_t commandListCount = device.GetStats().CommandLists;
+			renderer.Draw(snapshot);
+			// Every recorded list is submitted, each frame
+			CHECK(renderer.GetRecordedListCount() > 1);
+			CHECK(device.GetStats().CommandLists - commandListCount == renderer.GetRecordedListCount());
+		}
+		CHECK(renderer.GetQueueStats().ItemCount == 100000);
+		CHECK(renderer.GetQueueStats().DroppedItems == 0);
+		// The suspended and resumed passes match
+		CHECK(device.GetStats().ValidationErrors == 0);
+	}
+	delete pSwapChain;
+}
+
+static std::vector<uint32_t> RenderSoftware(JobSystem* pJobSystem, int& recordedListCount)
+{
+	RhiSoftwareDevice device(nullptr);
+	RhiSwapChainDesc swapChainDesc;
+	swapChainDesc.Width = 160;
+	swapChainDesc.Height = 120;
+	RhiSoftwareSwapChain* pSwapChain = (RhiSoftwareSwapChain*)device.CreateSwapChain(swapChainDesc);
+
+	RenderSnapshot snapshot;
+	FillSnapshot(50000, snapshot);
+	std::vector<uint32_t> pixels;
+	{
+		Renderer renderer;
+		renderer.Init(&device, pSwapChain, 2, pJobSystem, 64 << 20);
+		renderer.CreatePipeline(RhiShaderBytecode(), RhiShaderBytecode());
+		renderer.Draw(snapshot);
+		recordedListCount = renderer.GetRecordedListCount();
+		const uint32_t* pPixels = pSwapChain->GetPresentedBuffer();
+		pixels.assign(pPixels, pPixels + swapChainDesc.Width * swapChainDesc.Height);
+	}
+	delete pSwapChain;
+	return pixels;
+}
+
+TEST_CASE(ParallelRecordingDrawsLikeSerial)
+{
+	// Draw order decides which box wins at equal depth, so the lists must execute in submission order
+	JobSystem jobSystem;
+	jobSystem.Init(8);
+	int serialListCount = 0;
+	int parallelListCount = 0;
+	std::vector<uint32_t> serial = RenderSoftware(nullptr, serialListCount);
+	std::vector<uint32_t> parallel = RenderSoftware(&jobSystem, parallelListCount);
+	CHECK(serialListCount == 1);
+	CHECK(parallelListCount > 1);
+	CHECK(serial == parallel);
+}
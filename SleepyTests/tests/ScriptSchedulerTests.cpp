@@ -0,0 +1,194 @@
+#include "Test.h"
+#include "ScriptScheduler.h"
+#include "Script.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+static ScriptTask WaitFrames(std::vector<std::string>& log, std::string name, int frameCount)
+{
+	for (int i = 0; i < frameCount; i++)
+	{
+		co_await NextFrame();
+		log.push_back(name);
+	}
+}
+
+static ScriptTask WaitTime(std::vector<std::string>& log, std::string name, float seconds)
+{
+	co_await WaitForSeconds(seconds);
+	log.push_back(name);
+}
+
+static ScriptTask WaitFlag(std::vector<std::string>& log, std::string name, const bool& flag)
+{
+	co_await WaitUntil([&flag]() { return flag; });
+	log.push_back(name);
+}
+
+static ScriptTask WaitCounter(std::vector<std::string>& log, std::string name, JobCounter& counter)
+{
+	co_await WaitForJob(counter);
+	log.push_back(name);
+}
+
+static void WaitForRelease(void* pData, int begin, int end)
+{
+	while (!((std::atomic<bool>*)pData)->load())
+		std::this_thread::yield();
+}
+
+TEST_CASE(ScriptSchedulerResumesEachWaitKindInOrder)
+{
+	ScriptScheduler scheduler;
+	scheduler.Init();
+	JobSystem jobSystem;
+	jobSystem.Init(2);
+
+	std::vector<std::string> log;
+	bool flag = false;
+	std::atomic<bool> release(false);
+	JobCounter counter;
+	jobSystem.Run(&WaitForRelease, &release, &counter);
+	scheduler.Start(WaitCounter(log, "job", counter), nullptr);
+	scheduler.Start(WaitFlag(log, "flag", flag), nullptr);
+	scheduler.Start(WaitTime(log, "late", 2.0f), nullptr);
+	scheduler.Start(WaitTime(log, "early", 1.0f), nullptr);
+	scheduler.Start(WaitFrames(log, "frame", 2), nullptr);
+	CHECK(log.empty());
+	CHECK(scheduler.GetTaskCount() == 5);
+
+	// A coroutine waiting for the next frame again is not resumed twice in one update
+	scheduler.Update(0.5);
+	CHECK(log.size() == 1 && log[0] == "frame");
+
+	// Next frame waits first, then timers by wake time, then conditions, then jobs
+	flag = true;
+	release = true;
+	jobSystem.Wait(counter);
+	log.clear();
+	scheduler.Update(3.0);
+	CHECK(log.size() == 5);
+	CHECK(log[0] == "frame");
+	CHECK(log[1] == "early");
+	CHECK(log[2] == "late");
+	CHECK(log[3] == "flag");
+	CHECK(log[4] == "job");
+	CHECK(scheduler.GetTaskCount() == 0);
+}
+
+TEST_CASE(ScriptSchedulerStopAllCancelsEveryWait)
+{
+	ScriptScheduler scheduler;
+	scheduler.Init();
+	Script script;
+	Script other;
+	scheduler.Attach(&script);
+	scheduler.Attach(&other);
+	int baseLiveCount = CoroutineFramePool::GetLiveCount();
+
+	std::vector<std::string> log;
+	int conditionCalls = 0;
+	bool flag = false;
+	JobSystem jobSystem;
+	jobSystem.Init(1);
+	std::atomic<bool> release(false);
+	JobCounter counter;
+	jobSystem.Run(&WaitForRelease, &release, &counter);
+	script.StartCoroutine(WaitFrames(log, "frame", 1));
+	script.StartCoroutine(WaitTime(log, "time", 100.0f));
+	script.StartCoroutine(WaitCounter(log, "job", counter));
+	scheduler.Start([](int& calls) -> ScriptTask
+	{
+		co_await WaitUntil([&calls]() { calls++; return false; });
+	}(conditionCalls), &script);
+	other.StartCoroutine(WaitFlag(log, "other", flag));
+	CHECK(scheduler.GetTaskCount() == 5);
+
+	script.StopCoroutines();
+	// Far timers are freed right away, the others on the next update
+	CHECK(scheduler.GetTaskCount() == 4);
+	int callsBefore = conditionCalls;
+	scheduler.Update(1000.0);
+	CHECK(log.empty());
+	CHECK(conditionCalls == callsBefore);
+	CHECK(scheduler.GetTaskCount() == 1);
+
+	flag = true;
+	scheduler.Update(1001.0);
+	CHECK(log.size() == 1 && log[0] == "other");
+	CHECK(CoroutineFramePool::GetLiveCount() == baseLiveCount);
+	release = true;
+	jobSystem.Wait(counter);
+}
+
+TEST_CASE(ScriptSchedulerReusesCoroutineFrames)
+{
+	ScriptScheduler scheduler;
+	scheduler.Init();
+	std::vector<std::string> log;
+	log.reserve(4096);
+	int baseLiveCount = CoroutineFramePool::GetLiveCount();
+
+	for (int i = 0; i < 1000; i++)
+		scheduler.Start(WaitFrames(log, "frame", 1), nullptr);
+	CHECK(CoroutineFramePool::GetLiveCount() == baseLiveCount + 1000);
+	scheduler.Update(0.0);
+	CHECK(CoroutineFramePool::GetLiveCount() == baseLiveCount);
+	size_t reservedBytes = CoroutineFramePool::GetReservedBytes();
+	CHECK(reservedBytes > 0);
+
+	// Warmed up: the freed frames are handed out again
+	for (int pass = 0; pass < 10; pass++)
+	{
+		for (int i = 0; i < 1000; i++)
+			scheduler.Start(WaitFrames(log, "frame", 1), nullptr);
+		scheduler.Update(0.0);
+	}
+	CHECK(CoroutineFramePool::GetReservedBytes() == reservedBytes);
+	CHECK(CoroutineFramePool::GetLiveCount() == baseLiveCount);
+	CHECK(log.size() == 11000);
+}
+
+TEST_CASE(ScriptOutlivesItsScheduler)
+{
+	Script script;
+	std::vector<std::string> log;
+	{
+		ScriptScheduler scheduler;
+		scheduler.Init();
+		scheduler.Attach(&script);
+		script.StartCoroutine(WaitFrames(log, "frame", 10));
+		CHECK(script.GetScheduler() == &scheduler);
+	}
+	// Detached by the scheduler, stopping and starting coroutines is safe
+	CHECK(script.GetScheduler() == nullptr);
+	script.StopCoroutines();
+	script.StartCoroutine(WaitFrames(log, "frame", 1));
+	CHECK(log.empty());
+}
+
+TEST_CASE(ScriptDetachesFromItsScheduler)
+{
+	ScriptScheduler first;
+	ScriptScheduler second;
+	first.Init();
+	second.Init();
+	std::vector<std::string> log;
+	{
+		Script script;
+		first.Attach(&script);
+		script.StartCoroutine(WaitFrames(log, "first", 1));
+		// Moving to another scheduler stops what ran on the previous one
+		second.Attach(&script);
+		script.StartCoroutine(WaitFrames(log, "second", 10));
+		first.Update(0.0);
+		CHECK(log.empty());
+		CHECK(first.GetTaskCount() == 0);
+	}
+	// Its coroutines were stopped with it
+	second.Update(0.0);
+	CHECK(log.empty());
+	CHECK(second.GetTaskCount() == 0);
+}
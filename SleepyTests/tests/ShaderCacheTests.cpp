@@ -0,0 +1,208 @@
+#include "Test.h"
+#include "ShaderCache.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+// Returns the entry point as bytecode, without reading the files
+class StubShaderCompiler : public ShaderCompiler
+{
+public:
+	bool Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) override
+	{
+		m_compileCount++;
+		if (desc.EntryPoint == "Broken")
+		{
+			errors = "error X1000: stub";
+			return false;
+		}
+		std::string text = desc.EntryPoint + desc.Target;
+		bytecode.assign(text.begin(), text.end());
+		return true;
+	}
+	std::string GetVersion() const override { return m_version; }
+
+	// SETTER / GETTER
+	void SetVersion(const std::string& version) { m_version = version; }
+	int GetCompileCount() const { return m_compileCount; }
+	void ResetCompileCount() { m_compileCount = 0; }
+
+private:
+	std::atomic<int> m_compileCount = 0;
+	std::string m_version = "1";
+};
+
+static void WriteText(const std::filesystem::path& path, const char* text)
+{
+	std::ofstream file(path);
+	file << text;
+}
+
+// Shader sources in a fresh temporary directory, removed at the end of the test
+class ShaderFixture
+{
+public:
+	ShaderFixture(const char* name)
+	{
+		m_directory = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove_all(m_directory);
+		std::filesystem::create_directories(m_directory / "include");
+		WriteText(m_directory / "Box.hlsl", "#include \"include/Common.hlsli\"\nfloat4 VS() : SV_POSITION { return 0; }\n");
+		WriteText(m_directory / "include" / "Common.hlsli", "#include \"Constants.hlsli\"\n");
+		WriteText(m_directory / "include" / "Constants.hlsli", "// 1\n");
+	}
+	~ShaderFixture()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(m_directory, error);
+	}
+
+	std::string GetPath(const char* relativePath) const { return (m_directory / relativePath).string(); }
+	std::string GetCacheDirectory() const { return (m_directory / "cache").string(); }
+
+	// Builds every desc with a new cache, like a new run of the game
+	ShaderCacheStats Build(ShaderCompiler* pCompiler, JobSystem* pJobSystem, std::vector<ShaderDesc>& descs, std::vector<CompiledShader>& shaders)
+	{
+		ShaderCache cache;
+		cache.Init(pCompiler, GetCacheDirectory(), pJobSystem);
+		shaders.assign(descs.size(), CompiledShader());
+		cache.Build(descs.data(), shaders.data(), (int)descs.size());
+		return cache.GetStats();
+	}
+
+private:
+	std::filesystem::path m_directory;
+};
+
+static std::vector<ShaderDesc> CreateDescs(const ShaderFixture& fixture, int count)
+{
+	std::vector<ShaderDesc> descs;
+	for (int i = 0; i < count; i++)
+		descs.push_back({ fixture.GetPath("Box.hlsl"), "VS" + std::to_string(i), "vs_5_0" });
+	return descs;
+}
+
+TEST_CASE(ShaderCacheHitsAfterFirstBuild)
+{
+	ShaderFixture fixture("SleepyShaderCacheHits");
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+	StubShaderCompiler compiler;
+	std::vector<ShaderDesc> descs = CreateDescs(fixture, 8);
+	// Same key as the first one, compiled once
+	descs.push_back(descs[0]);
+	std::vector<CompiledShader> shaders;
+
+	ShaderCacheStats stats = fixture.Build(&compiler, &jobSystem, descs, shaders);
+	CHECK(stats.Compiled == 8);
+	CHECK(stats.Hits == 0);
+	CHECK(compiler.GetCompileCount() == 8);
+	CHECK(shaders[8].IsValid() && shaders[8].Bytecode == shaders[0].Bytecode);
+	for (int i = 0; i < 8; i++)
+		CHECK(!shaders[i].IsFromCache);
+
+	compiler.ResetCompileCount();
+	std::vector<CompiledShader> cached;
+	stats = fixture.Build(&compiler, &jobSystem, descs, cached);
+	CHECK(stats.Compiled == 0);
+	// Stats count keys, the duplicate is not loaded twice
+	CHECK(stats.Hits == 8);
+	CHECK(compiler.GetCompileCount() == 0);
+	for (int i = 0; i < (int)descs.size(); i++)
+	{
+		CHECK(cached[i].IsFromCache);
+		CHECK(cached[i].Bytecode == shaders[i].Bytecode);
+	}
+}
+
+TEST_CASE(ShaderCacheInvalidatesOnDependencies)
+{
+	ShaderFixture fixture("SleepyShaderCacheInvalidation");
+	StubShaderCompiler compiler;
+	std::vector<ShaderDesc> descs = CreateDescs(fixture, 2);
+	std::vector<CompiledShader> shaders;
+	fixture.Build(&compiler, nullptr, descs, shaders);
+
+	// A file included by an include
+	WriteText(fixture.GetPath("include/Constants.hlsli"), "// 2\n");
+	ShaderCacheStats stats = fixture.Build(&compiler, nullptr, descs, shaders);
+	CHECK(stats.Compiled == 2);
+	CHECK(stats.Hits == 0);
+	stats = fixture.Build(&compiler, nullptr, descs, shaders);
+	CHECK(stats.Hits == 2);
+
+	// Only the shader whose defines changed
+	descs[1].Defines.push_back({ "USE_FOG", "1" });
+	stats = fixture.Build(&compiler, nullptr, descs, shaders);
+	CHECK(stats.Compiled == 1);
+	CHECK(stats.Hits == 1);
+
+	// Every shader when the compiler changes
+	compiler.SetVersion("2");
+	stats = fixture.Build(&compiler, nullptr, descs, shaders);
+	CHECK(stats.Compiled == 2);
+	CHECK(stats.Hits == 0);
+}
+
+TEST_CASE(ShaderCacheRecompilesCorruptFiles)
+{
+	ShaderFixture fixture("SleepyShaderCacheCorrupt");
+	StubShaderCompiler compiler;
+	std::vector<ShaderDesc> descs = CreateDescs(fixture, 3);
+	std::vector<CompiledShader> shaders;
+	fixture.Build(&compiler, nullptr, descs, shaders);
+
+	// Flips the last byte of every cached blob, and truncates one of them
+	int fileCount = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(fixture.GetCacheDirectory()))
+	{
+		uintmax_t size = std::filesystem::file_size(entry.path());
+		if (fileCount == 0)
+		{
+			std::filesystem::resize_file(entry.path(), size / 2);
+		}
+		else
+		{
+			std::fstream file(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+			file.seekg(size - 1);
+			char last = 0;
+			file.get(last);
+			file.seekp(size - 1);
+			file.put((char)(last ^ 0x5A));
+		}
+		fileCount++;
+	}
+	CHECK(fileCount == 3);
+
+	std::vector<CompiledShader> rebuilt;
+	ShaderCacheStats stats = fixture.Build(&compiler, nullptr, descs, rebuilt);
+	CHECK(stats.Compiled == 3);
+	CHECK(stats.Hits == 0);
+	for (int i = 0; i < 3; i++)
+		CHECK(rebuilt[i].Bytecode == shaders[i].Bytecode);
+}
+
+TEST_CASE(ShaderCacheReportsFailures)
+{
+	ShaderFixture fixture("SleepyShaderCacheFailures");
+	StubShaderCompiler compiler;
+	std::vector<ShaderDesc> descs = CreateDescs(fixture, 1);
+	descs.push_back({ fixture.GetPath("Box.hlsl"), "Broken", "vs_5_0" });
+	descs.push_back({ fixture.GetPath("Missing.hlsl"), "VS", "vs_5_0" });
+	std::vector<CompiledShader> shaders(descs.size());
+
+	ShaderCache cache;
+	cache.Init(&compiler, fixture.GetCacheDirectory(), nullptr);
+	CHECK(!cache.Build(descs.data(), shaders.data(), (int)descs.size()));
+	CHECK(shaders[0].IsValid());
+	CHECK(!shaders[1].IsValid() && !shaders[1].Errors.empty());
+	CHECK(!shaders[2].IsValid() && !shaders[2].Errors.empty());
+	CHECK(cache.GetStats().Failed == 2);
+
+	// Failures are not cached, the broken shader is compiled again
+	compiler.ResetCompileCount();
+	ShaderCacheStats stats = fixture.Build(&compiler, nullptr, descs, shaders);
+	CHECK(stats.Hits == 1);
+	CHECK(compiler.GetCompileCount() == 1);
+}
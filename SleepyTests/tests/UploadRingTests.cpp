@@ -0,0 +1,135 @@
+#include "Test.h"
+#include "UploadRing.h"
+#include "FrameRing.h"
+#include "RhiNull.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+TEST_CASE(UploadRingAlignsAndFails)
+{
+	RhiNullDevice device;
+	UploadRing ring;
+	CHECK(ring.Init(&device, 1000));
+	// Rounded up to MAX_ALIGNMENT
+	CHECK(ring.GetCapacity() == 1024);
+
+	UploadAllocation allocation;
+	CHECK(ring.Allocate(100, 256, allocation));
+	CHECK(allocation.Offset == 0);
+	CHECK(allocation.pData != nullptr);
+	CHECK(ring.Allocate(100, 256, allocation));
+	CHECK(allocation.Offset == 256);
+	CHECK(allocation.GpuAddress % 256 == 0);
+	// Does not fit before the end, and the start is still in use
+	CHECK(!ring.Allocate(600, 256, allocation));
+	CHECK(ring.GetFailedCount() == 1);
+	CHECK(device.GetStats().ValidationErrors == 0);
+}
+
+TEST_CASE(UploadRingWrapsAndRetiresByFence)
+{
+	RhiNullDevice device;
+	// Completes nothing on its own within the test
+	MockFenceTimeline timeline(8);
+	UploadRing ring;
+	ring.Init(&device, 1024);
+
+	UploadAllocation allocation;
+	ring.Allocate(100, 256, allocation);
+	ring.Allocate(100, 256, allocation);
+	// Frame 1 ends at 356
+	ring.EndFrame(timeline.Signal());
+	CHECK(ring.GetPendingFrameCount() == 1);
+	CHECK(ring.Allocate(400, 256, allocation));
+	CHECK(allocation.Offset == 512);
+
+	// Not completed yet: nothing comes back
+	ring.Retire(timeline.GetCompletedValue());
+	CHECK(ring.GetUsedSize() == 912);
+	CHECK(!ring.Allocate(300, 256, allocation));
+
+	timeline.Complete(1);
+	ring.Retire(timeline.GetCompletedValue());
+	CHECK(ring.GetUsedSize() == 912 - 356);
+	CHECK(ring.GetPendingFrameCount() == 0);
+	// Skips the 112 bytes left at the end, never straddles it
+	CHECK(ring.Allocate(300, 256, allocation));
+	CHECK(allocation.Offset == 0);
+
+	ring.EndFrame(timeline.Signal());
+	timeline.Complete(2);
+	ring.Retire(timeline.GetCompletedValue());
+	CHECK(ring.GetUsedSize() == 0);
+}
+
+TEST_CASE(UploadRingSteadyFramesNeverFail)
+{
+	// Frames in flight through the null backend, each allocating the same amount
+	RhiNullDevice device;
+	FrameRing frameRing;
+	frameRing.Init(device.GetQueue(), 3);
+	UploadRing ring;
+	ring.Init(&device, 3 * 64 * 1024);
+
+	for (int frame = 0; frame < 1000; frame++)
+	{
+		int frameSlot = frameRing.BeginFrame();
+		ring.Retire(device.GetQueue()->GetCompletedValue());
+		UploadAllocation allocation;
+		for (int i = 0; i < 64; i++)
+			CHECK(ring.Allocate(1000, 256, allocation));
+		frameRing.EndFrame();
+		ring.EndFrame(frameRing.GetFenceValue(frameSlot));
+	}
+	CHECK(ring.GetFailedCount() == 0);
+}
+
+TEST_CASE(UploadRingConcurrentAllocationsDoNotOverlap)
+{
+	RhiNullDevice device;
+	UploadRing ring;
+	ring.Init(&device, 1 << 20);
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	const int count = 2000;
+	std::vector<uint64_t> offsets(count);
+	std::vector<uint64_t> sizes(count);
+	std::vector<char> isAllocated(count);
+	for (int frame = 0; frame < 50; frame++)
+	{
+		jobSystem.ParallelFor(count, 16, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				UploadAllocation allocation;
+				uint64_t alignment = (uint64_t)16 << (i % 5);
+				sizes[i] = 16 + (i * 37) % 300;
+				isAllocated[i] = ring.Allocate(sizes[i], alignment, allocation);
+				offsets[i] = allocation.Offset;
+				if (isAllocated[i])
+				{
+					CHECK(allocation.Offset % alignment == 0);
+					memset(allocation.pData, i & 0xFF, sizes[i]);
+				}
+			}
+		});
+
+		std::vector<std::pair<uint64_t, uint64_t>> ranges;
+		for (int i = 0; i < count; i++)
+		{
+			if (isAllocated[i])
+				ranges.push_back({ offsets[i], sizes[i] });
+		}
+		std::sort(ranges.begin(), ranges.end());
+		for (int i = 1; i < ranges.size(); i++)
+			CHECK(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+		for (int i = 0; i < ranges.size(); i++)
+			CHECK(ranges[i].first + ranges[i].second <= ring.GetCapacity());
+
+		// Two frames in flight
+		ring.EndFrame(frame + 1);
+		ring.Retire(frame >= 2 ? frame - 1 : 0);
+	}
+}